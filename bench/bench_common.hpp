@@ -0,0 +1,53 @@
+#ifndef HADES_BENCH_COMMON_HPP
+#define HADES_BENCH_COMMON_HPP
+
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+
+// shared by the standalone benchmarks in this directory
+
+namespace hades::bench
+{
+	using bench_clock = std::chrono::steady_clock;
+	using milliseconds_double = std::chrono::duration<double, std::milli>;
+
+	// the benchmarks only take positional counts
+	//	usage is printed if an argument can't be read
+	class bench_args
+	{
+	public:
+		bench_args(const int argc, char** argv, const std::string_view usage) noexcept
+			: _argc{ argc }, _argv{ argv }, _usage{ usage }
+		{}
+
+		// reads the argument at index, or returns default_value if it wasn't passed
+		//	exits if the argument isn't a number, or is less than min_value
+		std::size_t get(const int index, const std::size_t default_value, const std::size_t min_value = {}) const
+		{
+			if (_argc <= index)
+				return default_value;
+
+			const auto arg = std::string_view{ _argv[index] };
+			auto out = std::size_t{};
+			const auto [ptr, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), out);
+			if (ec != std::errc{} || ptr != arg.data() + arg.size() || out < min_value)
+			{
+				std::cerr << "invalid argument: " << arg << "\n"
+					<< "usage: " << _usage << "\n";
+				std::exit(EXIT_FAILURE);
+			}
+			return out;
+		}
+
+	private:
+		int _argc;
+		char** _argv;
+		std::string_view _usage;
+	};
+}
+
+#endif //!HADES_BENCH_COMMON_HPP
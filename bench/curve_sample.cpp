@@ -0,0 +1,119 @@
+// compares reading linear curves one at a time with get()
+// against reading them together with sample_curves()
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "hades/curve_sample.hpp"
+
+#include "bench_common.hpp"
+
+namespace
+{
+	using hades::bench::bench_clock;
+	using hades::bench::milliseconds_double;
+
+	constexpr auto usage = "hades_bench_curve_sample [curve count] [frame count]";
+
+	constexpr auto keyframe_count = 8;
+
+	template<typename T, typename MakeValue>
+	std::vector<hades::linear_curve<T>> make_curves(const std::size_t count, MakeValue&& make_value)
+	{
+		auto out = std::vector<hades::linear_curve<T>>(count);
+		for (auto& c : out)
+		{
+			for (auto k = 0; k < keyframe_count; ++k)
+				c.add_keyframe(hades::time_point{ hades::seconds{ k } }, make_value());
+		}
+		return out;
+	}
+
+	float checksum(const float f) noexcept
+	{
+		return f;
+	}
+
+	float checksum(const hades::vector2_float v) noexcept
+	{
+		return v.x + v.y;
+	}
+
+	float difference(const float a, const float b) noexcept
+	{
+		return std::abs(a - b);
+	}
+
+	float difference(const hades::vector2_float a, const hades::vector2_float b) noexcept
+	{
+		return std::max(std::abs(a.x - b.x), std::abs(a.y - b.y));
+	}
+
+	template<typename T>
+	void run(const std::string_view name, const std::vector<hades::linear_curve<T>>& curves, const std::size_t frames)
+	{
+		// frames are spread over the curves, so each one lands between different keyframes
+		const auto frame_step = hades::time_duration{ hades::seconds{ keyframe_count - 1 } } / static_cast<std::int64_t>(frames);
+		auto per_entity = std::vector<T>(std::size(curves));
+		auto batched = std::vector<T>(std::size(curves));
+		auto sink = 0.f;
+
+		const auto per_entity_start = bench_clock::now();
+		for (auto f = std::size_t{}; f < frames; ++f)
+		{
+			const auto t = hades::time_point{ frame_step * static_cast<std::int64_t>(f) };
+			for (auto i = std::size_t{}; i < std::size(curves); ++i)
+				per_entity[i] = curves[i].get(t);
+			sink += checksum(per_entity[f % std::size(per_entity)]);
+		}
+		const auto per_entity_time = milliseconds_double{ bench_clock::now() - per_entity_start };
+
+		const auto batched_start = bench_clock::now();
+		for (auto f = std::size_t{}; f < frames; ++f)
+		{
+			const auto t = hades::time_point{ frame_step * static_cast<std::int64_t>(f) };
+			hades::sample_curves(curves, t, std::span{ batched });
+			sink += checksum(batched[f % std::size(batched)]);
+		}
+		const auto batched_time = milliseconds_double{ bench_clock::now() - batched_start };
+
+		// both paths should agree apart from float rounding
+		auto max_difference = 0.f;
+		for (auto i = std::size_t{}; i < std::size(curves); ++i)
+			max_difference = std::max(max_difference, difference(per_entity[i], batched[i]));
+
+		const auto samples = static_cast<double>(std::size(curves) * frames);
+		std::cout << name << ":\n"
+			<< "\tper entity: " << per_entity_time.count() << "ms ("
+			<< per_entity_time.count() * 1'000'000.0 / samples << "ns per curve)\n"
+			<< "\tbatched:    " << batched_time.count() << "ms ("
+			<< batched_time.count() * 1'000'000.0 / samples << "ns per curve)\n"
+			<< "\tspeedup:    " << per_entity_time.count() / batched_time.count() << "x\n"
+			<< "\tmax difference: " << max_difference << " (checksum " << sink << ")\n";
+		return;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const auto args = hades::bench::bench_args{ argc, argv, usage };
+	const auto curve_count = args.get(1, 10'000, 1);
+	const auto frames = args.get(2, 500, 1);
+
+	std::cout << curve_count << " curves, " << keyframe_count << " keyframes each, "
+		<< frames << " frames\n";
+
+	auto rng = std::mt19937{ 1 };
+	auto dist = std::uniform_real_distribution{ -1000.f, 1000.f };
+	run("linear_curve<float>", make_curves<float>(curve_count, [&]() { return dist(rng); }), frames);
+	run("linear_curve<vector2_float>", make_curves<hades::vector2_float>(curve_count, [&]() {
+		return hades::vector2_float{ dist(rng), dist(rng) };
+		}), frames);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+// measures the per tick cost and size of exporting and packing the changes to a level
+// objects that were created and destroyed before the measured ticks stay in the
+// creation and destruction time maps, export_changes should skip them
+
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include "hades/export_curves.hpp"
+
+#include "bench_common.hpp"
+
+namespace
+{
+	using namespace hades;
+	using bench::bench_clock;
+	using bench::milliseconds_double;
+
+	constexpr auto usage = "hades_bench_export_curves [moving object count] [tick count] [old object count]";
+
+	struct bench_level
+	{
+		game_state state;
+		extra_state<game_system> extras;
+		resources::object object_type;
+		unique_id position = make_unique_id();
+		std::vector<entity_id> objects;
+	};
+
+	game_obj& create_object(bench_level& l, const time_point t)
+	{
+		const auto id = increment(l.state.next_id);
+		const auto o = l.extras.objects.insert(game_obj{ id, &l.object_type, {} });
+		auto position = linear_curve<vector2_float>{};
+		position.add_keyframe(t, { static_cast<float>(to_value(id)), 0.f });
+		state_api::detail::insert_object_property<linear_curve, vector2_float>(*o, l.position, l.state, std::move(position));
+		l.state.object_creation_time.insert_or_assign(id, t);
+		return *o;
+	}
+
+	// the work export_changes did for created and destroyed objects before they were indexed by time
+	std::size_t scan_object_times(const time_point since, const game_state& s)
+	{
+		auto out = std::size_t{};
+		for (const auto& [id, t] : s.object_creation_time)
+			out += t > since;
+		for (const auto& [id, t] : s.object_destruction_time)
+			out += t > since;
+		return out;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const auto args = bench::bench_args{ argc, argv, usage };
+	const auto moving_count = args.get(1, 10'000);
+	const auto ticks = args.get(2, 300);
+	const auto old_count = args.get(3, 100'000);
+
+	std::cout << moving_count << " moving objects, " << old_count << " old objects, "
+		<< ticks << " ticks\n";
+
+	auto level = bench_level{};
+	auto t = time_point{};
+
+	// objects that came and went before the measured ticks
+	for (auto i = std::size_t{}; i < old_count; ++i)
+	{
+		auto& o = create_object(level, t);
+		level.state.object_destruction_time.insert_or_assign(o.id, t);
+		state_api::erase_object(o, level.state, level.extras);
+	}
+
+	for (auto i = std::size_t{}; i < moving_count; ++i)
+		level.objects.emplace_back(create_object(level, t).id);
+
+	constexpr auto dt = std::chrono::milliseconds{ 33 };
+	auto exported = exported_curves{};
+	auto buffer = std::vector<std::byte>{};
+	auto read_back = exported_curves{};
+	auto export_time = milliseconds_double{};
+	auto write_time = milliseconds_double{};
+	auto scan_time = milliseconds_double{};
+	auto bytes = std::size_t{};
+	auto keyframes = std::size_t{};
+	auto scanned = std::size_t{};
+
+	for (auto tick = std::size_t{}; tick < ticks; ++tick)
+	{
+		const auto since = t;
+		t += dt;
+		for (const auto id : level.objects)
+		{
+			auto& position = state_api::get_object_property_ref<linear_curve, vector2_float>(
+				*level.extras.objects.find(id), level.position);
+			position.add_keyframe(t, { static_cast<float>(tick), static_cast<float>(to_value(id)) });
+		}
+
+		// a little churn, so there is something for the created and destroyed lists
+		if (!std::empty(level.objects))
+		{
+			const auto id = level.objects[tick % std::size(level.objects)];
+			level.state.object_destruction_time.insert_or_assign(id, t);
+			level.objects[tick % std::size(level.objects)] = create_object(level, t).id;
+			state_api::erase_object(*level.extras.objects.find(id), level.state, level.extras);
+		}
+
+		const auto export_start = bench_clock::now();
+		state_api::export_changes(since, level.state, level.extras, exported);
+		export_time += bench_clock::now() - export_start;
+
+		const auto write_start = bench_clock::now();
+		buffer.clear();
+		write_exported_curves(exported, buffer);
+		write_time += bench_clock::now() - write_start;
+
+		const auto scan_start = bench_clock::now();
+		scanned += scan_object_times(since, level.state);
+		scan_time += bench_clock::now() - scan_start;
+
+		read_exported_curves(buffer, read_back);
+		if (std::size(read_back.created_objects) != std::size(exported.created_objects) ||
+			std::size(read_back.destroyed_objects) != std::size(exported.destroyed_objects))
+		{
+			std::cerr << "exported changes didn't survive packing on tick " << tick << "\n";
+			return EXIT_FAILURE;
+		}
+
+		bytes += std::size(buffer);
+		for (const auto& set : std::get<std::vector<curve_export_set<vector2_float>>>(exported.curves))
+			keyframes += std::size(set.keyframes);
+	}
+
+	const auto per_tick = static_cast<double>(std::max(ticks, std::size_t{ 1 }));
+	const auto total_seconds = (export_time + write_time).count() / 1000.0;
+	std::cout << "\texport_changes:        " << export_time.count() / per_tick << "ms per tick\n"
+		<< "\twrite_exported_curves: " << write_time.count() / per_tick << "ms per tick\n"
+		<< "\tpacked size:           " << static_cast<double>(bytes) / 1024.0 / per_tick << "KiB per tick ("
+		<< static_cast<double>(bytes) / static_cast<double>(std::max(keyframes, std::size_t{ 1 })) << " bytes per keyframe)\n"
+		<< "\tthroughput:            " << static_cast<double>(bytes) / (1024.0 * 1024.0) / total_seconds << "MB/s\n"
+		<< "\tfull time map scan:    " << scan_time.count() / per_tick << "ms per tick, skipped by the time index ("
+		<< scanned << " entries found)\n";
+	return EXIT_SUCCESS;
+}
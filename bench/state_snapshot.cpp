@@ -0,0 +1,199 @@
+// measures the time and memory of taking a snapshot after each tick
+// compares driving take_snapshot from the changed objects(as the server does with the dirty curve list)
+// against comparing the version of every curve in the level
+
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "hades/state_snapshot.hpp"
+
+#include "bench_common.hpp"
+
+namespace
+{
+	using namespace hades;
+	using bench::bench_clock;
+	using bench::milliseconds_double;
+	using snapshot = state_snapshot<game_system>;
+
+	constexpr auto usage = "hades_bench_state_snapshot [object count] [objects written per tick, per thousand] [tick count]";
+
+	struct bench_level
+	{
+		game_state state;
+		extra_state<game_system> extras;
+		resources::object object_type;
+		unique_id position = make_unique_id();
+		unique_id health = make_unique_id();
+		std::vector<entity_id> objects;
+	};
+
+	void create_object(bench_level& l, const time_point t)
+	{
+		const auto id = increment(l.state.next_id);
+		const auto o = l.extras.objects.insert(game_obj{ id, &l.object_type, {} });
+		auto position = linear_curve<vector2_float>{};
+		position.add_keyframe(t, { static_cast<float>(to_value(id)), 0.f });
+		auto health = step_curve<int32>{};
+		health.add_keyframe(t, 100);
+		state_api::detail::insert_object_property<linear_curve, vector2_float>(*o, l.position, l.state, std::move(position));
+		state_api::detail::insert_object_property<step_curve, int32>(*o, l.health, l.state, std::move(health));
+		l.state.object_creation_time.insert_or_assign(id, t);
+		l.objects.emplace_back(id);
+		return;
+	}
+
+	// bytes held by snap that aren't shared with previous
+	//	curves are counted by their keyframes
+	std::size_t new_memory(const snapshot& snap, const snapshot& previous)
+	{
+		auto out = std::size(snap.chunks) * sizeof(snap.chunks.front());
+		for (auto i = std::size_t{}; i < std::size(snap.chunks); ++i)
+		{
+			const auto& chunk = snap.chunks[i];
+			if (!chunk || (i < std::size(previous.chunks) && previous.chunks[i] == chunk))
+				continue;
+
+			out += sizeof(*chunk) + std::size(chunk->objects) * sizeof(chunk->objects.front());
+			for (const auto& o : chunk->objects)
+			{
+				const auto prev = previous.find(o->id);
+				if (prev && *prev == o)
+					continue;
+
+				out += sizeof(*o) + std::size(o->curves) * sizeof(o->curves.front());
+				for (auto c = std::size_t{}; c < std::size(o->curves); ++c)
+				{
+					if (prev && (*prev)->curves[c].curve == o->curves[c].curve)
+						continue;
+					if (c == 0)
+						out += static_cast<const linear_curve<vector2_float>*>(o->curves[c].curve.get())->size() *
+							(sizeof(time_point) + sizeof(vector2_float));
+					else
+						out += static_cast<const step_curve<int32>*>(o->curves[c].curve.get())->size() *
+							(sizeof(time_point) + sizeof(int32));
+				}
+			}
+		}
+		return out;
+	}
+
+	// both ways of taking a snapshot should end up with the same objects and curve versions
+	bool same_objects(const snapshot& l, const snapshot& r)
+	{
+		if (l.next_id != r.next_id)
+			return false;
+
+		for (auto i = std::size_t{}; i < std::max(std::size(l.chunks), std::size(r.chunks)); ++i)
+		{
+			const auto left = i < std::size(l.chunks) ? l.chunks[i] : nullptr;
+			const auto right = i < std::size(r.chunks) ? r.chunks[i] : nullptr;
+			const auto left_size = left ? std::size(left->objects) : std::size_t{};
+			const auto right_size = right ? std::size(right->objects) : std::size_t{};
+			if (left_size != right_size)
+				return false;
+
+			for (auto o = std::size_t{}; o < left_size; ++o)
+			{
+				const auto& a = *left->objects[o];
+				const auto& b = *right->objects[o];
+				if (a.id != b.id || std::size(a.curves) != std::size(b.curves))
+					return false;
+				for (auto c = std::size_t{}; c < std::size(a.curves); ++c)
+				{
+					if (a.curves[c].version != b.curves[c].version)
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const auto args = bench::bench_args{ argc, argv, usage };
+	const auto object_count = args.get(1, 10'000);
+	const auto written = args.get(2, 10);
+	const auto ticks = args.get(3, 300);
+
+	std::cout << object_count << " objects, " << written << " in every thousand written per tick, "
+		<< ticks << " ticks\n";
+
+	auto level = bench_level{};
+	state_api::enable_dirty_tracking(true, level.extras);
+	auto t = time_point{};
+	for (auto i = std::size_t{}; i < object_count; ++i)
+		create_object(level, t);
+	state_api::finish_dirty_tick(level.extras);
+
+	auto incremental = std::deque<snapshot>{};
+	auto full = std::deque<snapshot>{};
+	incremental.emplace_back(state_api::take_snapshot<game_system>(t, level.state, level.extras));
+	full.emplace_back(incremental.back());
+
+	constexpr auto dt = std::chrono::milliseconds{ 33 };
+	auto rng = std::mt19937{ 1 };
+	auto dist = std::uniform_int_distribution<std::size_t>{ 0, 999 };
+	auto changed = std::vector<entity_id>{};
+	auto incremental_time = milliseconds_double{};
+	auto full_time = milliseconds_double{};
+	auto memory = std::size_t{};
+
+	for (auto tick = std::size_t{}; tick < ticks; ++tick)
+	{
+		t += dt;
+		changed.clear();
+		for (const auto id : level.objects)
+		{
+			if (dist(rng) >= written)
+				continue;
+
+			const auto o = level.extras.objects.find(id);
+			auto& position = state_api::get_object_property_ref<linear_curve, vector2_float>(*o, level.position);
+			position.add_keyframe(t, { static_cast<float>(tick), static_cast<float>(to_value(id)) });
+			level.extras.dirty_curves.current.push_back({ id, level.position });
+		}
+
+		// churn a few objects, the way the server passes in the ones it erased
+		if (tick % 8 == 0 && !std::empty(level.objects))
+		{
+			const auto index = dist(rng) % std::size(level.objects);
+			const auto id = level.objects[index];
+			state_api::erase_object(*level.extras.objects.find(id), level.state, level.extras);
+			level.objects.erase(begin(level.objects) + static_cast<std::ptrdiff_t>(index));
+			changed.emplace_back(id);
+			create_object(level, t);
+		}
+
+		state_api::finish_dirty_tick(level.extras);
+		for (const auto& c : state_api::get_dirty_curves(level.extras))
+			changed.emplace_back(c.object);
+
+		const auto incremental_start = bench_clock::now();
+		incremental.emplace_back(state_api::take_snapshot(t, level.state, level.extras, incremental.back(), changed));
+		incremental_time += bench_clock::now() - incremental_start;
+
+		const auto full_start = bench_clock::now();
+		full.emplace_back(state_api::take_snapshot(t, level.state, level.extras, &full.back()));
+		full_time += bench_clock::now() - full_start;
+
+		memory += new_memory(incremental.back(), incremental[std::size(incremental) - 2]);
+		if (!same_objects(incremental.back(), full.back()))
+		{
+			std::cerr << "snapshots differ on tick " << tick << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	const auto per_tick = static_cast<double>(std::max(ticks, std::size_t{ 1 }));
+	std::cout << "\tchanged objects:   " << incremental_time.count() / per_tick << "ms per snapshot\n"
+		<< "\tevery curve:       " << full_time.count() / per_tick << "ms per snapshot\n"
+		<< "\tspeedup:           " << full_time.count() / incremental_time.count() << "x\n"
+		<< "\tnew memory:        " << static_cast<double>(memory) / 1024.0 / per_tick << "KiB per snapshot\n";
+	return EXIT_SUCCESS;
+}
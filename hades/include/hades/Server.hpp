@@ -3,8 +3,10 @@
 
 #include "hades/export_curves.hpp"
 #include "hades/input.hpp"
+#include "hades/interest.hpp"
 #include "hades/mission.hpp"
 #include "hades/level.hpp"
+#include "hades/replay.hpp"
 #include "hades/time.hpp"
 
 //TODO: move to hades-core
@@ -23,6 +25,16 @@
 
 //NOTE: current system doesn't support this, use mission time everywhere
 
+// __hibernation__
+// when s_hibernate_after is set, levels that haven't been used by a client for that long
+// have their objects packed into a compressed store(see: cold_storage.hpp) and are freed.
+// when a client connects to or uses them again they're restored on the thread pool, then swapped in
+// at the start of the first update after they're ready, and skip ahead by the mission time they missed.
+// level locals, systems and system data are kept as they are, on_create and on_destroy aren't called.
+// get_level returns nullptr for a hibernating level and starts restoring it,
+// calls deferred to the level are held until it has been restored.
+// hibernating and waking are recorded in replays, see: replay_hibernation
+
 namespace hades
 {
 	void register_game_server_resources(data::data_manager&);
@@ -42,15 +54,26 @@ namespace hades
 		virtual void get_changes(exported_curves&, time_point) const = 0;
 		//get all changes since last call to get_changes
 		virtual void get_changes(exported_curves&) const = 0;
+		//get changes since time_point for the objects near view, see: interest.hpp
+		//	interest holds the objects that were sent last time, and is updated
+		//	levels that aren't using interest management(s_interest_management) send every change
+		virtual void get_changes(exported_curves&, time_point, rect_float view, interest_set& interest) const = 0;
+		//tells the server which part of the level this client can see
+		virtual void set_view(rect_float) = 0; //noop on local server
 		//sends player input
 		virtual void send_request(unique_id, std::vector<action>) = 0;
 
+		//false while the level is hibernating, see: s_hibernate_after
+		//	get_changes returns no changes and get_interface returns nullptr until the level is available
+		//	calling them also wakes the level
+		virtual bool is_available() const noexcept = 0;
 		virtual common_interface* get_interface() noexcept = 0;
 		// returns nullptr if this the game_interface is not available
 		virtual game_interface* try_get_game_interface() noexcept = 0;
 
 		//current level time
-		//virtual time_point get_level_time() = 0;
+		//	the time_points passed to and stored by get_changes are in level time, not mission time
+		virtual time_point get_level_time() const noexcept = 0;
 		//time the level started at, from level save
 		//virtual time_point get_level_start_time() = 0;
 	};
@@ -82,6 +105,21 @@ namespace hades
 		//virtual time_point get_current_time() = 0;
 		//returns the total mission time of the server
 		virtual time_point get_time() const noexcept = 0;
+		//rolls every level back by at least duration, using the snapshots kept when s_snapshot_history is set
+		// returns false and changes nothing if a level doesn't have a snapshot that old
+		// or if a replay is being recorded, see: set_replay_writer
+		virtual bool rewind(time_duration) = 0;
+		//records level creation, input, hibernation and a state hash after each update into the replay, see: replay.hpp
+		//	pass nullptr to stop recording, the writer must outlive the server or be replaced
+		//	rewinding isn't recorded, so the server refuses to rewind while recording
+		virtual void set_replay_writer(replay_writer*) = 0; //noop on remote server
+		//levels hibernate and wake where the replay says instead of when clients use them
+		virtual void set_replay_playback(bool) = 0; //noop on remote server
+		//hibernates or wakes a level, used to play back replay_hibernation records
+		//	returns false if the level isn't running
+		virtual bool play_hibernation(unique_id level, bool hibernating) = 0; //returns false on remote server
+		//hash of the mission and level states, see: state_api::hash_state
+		virtual std::uint64_t get_state_hash() const = 0; //returns 0 on remote server
 
 		//returns the mission interface
 		virtual common_interface* get_interface() noexcept = 0;
@@ -92,6 +130,7 @@ namespace hades
 		//get source_file level1.mission or whatever
 		virtual mission get_mission() = 0;
 
+		//wakes the level at the start of the next update if it's hibernating
 		virtual server_level *connect_to_level(unique_id) = 0;
 		virtual void disconnect_from_level() = 0;
 	};
@@ -122,7 +161,9 @@ namespace hades
 	server_ptr create_server(mission_save); //auto player assignment
 	server_ptr create_server(mission_save, unique_id player_slot); //join as player x // obs for slot -1 or already taken 
 	server_ptr create_server(mission_save, std::string_view name_slot); //join as player in named slot
-	//server_ptr connect_to_server(/*ip address*/); //auto player assignment
+	//join a server_host in another process as the player in the named slot, see: remote_server.hpp
+	//	update() on the returned hub sends queued input and reads the latest changes
+	server_ptr connect_to_server(std::string_view address, unsigned short port, std::string_view name_slot);
 }
 
 #endif //HADES_SERVER_HPP
@@ -72,6 +72,7 @@ namespace hades::data
 		const types::string& get_as_string_impl(unique_id id) const noexcept override;
 		unique_id get_uid_impl(std::string_view name) const override;
 		unique_id get_uid_impl(std::string_view name) override;
+		std::vector<std::pair<unique_id, types::string>> get_all_names_impl() const override;
 
 	protected:
 		const std::filesystem::path& _current_data_file() const noexcept override
@@ -0,0 +1,87 @@
+#ifndef HADES_REMOTE_SERVER_HPP
+#define HADES_REMOTE_SERVER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "SFML/Network/Packet.hpp"
+#include "SFML/Network/TcpListener.hpp"
+#include "SFML/Network/TcpSocket.hpp"
+
+#include "hades/properties.hpp"
+#include "hades/Server.hpp"
+
+// server_host lets remote_server_hubs(see: connect_to_server) play on a server_hub from another process
+//	clients send their input in one batch per update, the host replies with the
+//	changes to the mission and any levels the client is connected to, as deflated exported_curves
+// unique_ids are process local, so the host sends its table of id names when a client joins
+//	and the client translates ids in both directions
+// once a client sets its view of a level, it's only sent the objects near that view, see: interest.hpp
+
+namespace hades
+{
+	class server_host
+	{
+	public:
+		//exception: server_error if the port cannot be listened on
+		server_host(server_hub&, unsigned short port);
+
+		// accepts new clients, passes their input to the server,
+		//	and sends each client the changes since the last update
+		//	should be called after each server_hub::update, on the same thread
+		void update();
+
+		std::size_t client_count() const noexcept;
+
+	private:
+		struct level_connection
+		{
+			unique_id id = unique_zero;
+			server_level* level = nullptr;
+			// in the levels time, see: server_level::get_level_time
+			time_point since;
+			// set by the client, see: server_level::set_view
+			//	until then the client is sent every change in the level
+			std::optional<rect_float> view;
+			interest_set interest;
+		};
+
+		struct remote_client
+		{
+			// nullptr once the client has disconnected
+			std::unique_ptr<sf::TcpSocket> socket;
+			unique_id player = unique_zero;
+			std::vector<level_connection> levels;
+			time_point mission_since;
+			// the clients clock from their last input, sent back with the next changes
+			//	so the client can measure the round trip
+			std::int64_t echo_time = {};
+			bool echo_pending = false;
+			std::deque<sf::Packet> outgoing;
+		};
+
+		void _accept_clients();
+		void _receive(remote_client&);
+		void _handle_hello(remote_client&, sf::Packet&);
+		void _handle_input(remote_client&, sf::Packet&);
+		void _handle_resync(remote_client&, sf::Packet&);
+		void _handle_view(remote_client&, sf::Packet&);
+		void _send_changes(remote_client&);
+		std::size_t _flush(remote_client&);
+		void _drop(remote_client&, std::string_view reason);
+
+		server_hub* _server = nullptr;
+		sf::TcpListener _listener;
+		std::vector<remote_client> _clients;
+		// reused between updates
+		exported_curves _changes;
+		std::vector<std::byte> _buffer;
+		console::property_int _bytes_sent;
+	};
+}
+
+#endif //!HADES_REMOTE_SERVER_HPP
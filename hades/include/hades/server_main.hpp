@@ -0,0 +1,40 @@
+#ifndef HADES_SERVER_MAIN_HPP
+#define HADES_SERVER_MAIN_HPP
+
+#include <string_view>
+
+// headless entry point for running a mission without a window or renderer
+// used by the hades_server target, games that register their own systems
+// should call hades_server_main from their own server executable
+
+namespace hades::data
+{
+	class data_manager;
+}
+
+namespace hades
+{
+	// same as the register_resource_types_fn in Main.hpp
+	using register_resource_types_fn = void(*)(hades::data::data_manager&);
+
+	// commands:
+	//	-game <name>: the game to load, defaults to the game argument
+	//	-mod <name>: a mod to load after the game
+	//	-mission <path>: the mission file to load; required
+	//	-slot <name>: the player slot to create the server with, defaults to the first player in the mission
+	//	-ticks <count>: stop after this many ticks, defaults to running until the process is killed
+	//	-fast: don't wait between ticks, for throughput testing
+	//	-listen <port>: accept remote clients(see: connect_to_server), port defaults to s_port
+	//	-loopback: instead of running normally, connect a client to the server through a server_host on 127.0.0.1
+	//		(the -listen port, or s_port) for -ticks ticks(default 300), and check it joins, its input arrives
+	//		and its copy of the first level matches. logs the bandwidth and round trip, exits with failure if a check fails
+	//	-record <path>: write the input and a state hash for each tick to a replay file(see: replay.hpp)
+	//	-replay <path>: play back a recorded replay as fast as possible, instead of running the mission
+	//		exits with failure on the first tick whose state hash doesn't match the recording
+	// any other commands are passed to the console, eg. -s_tickrate 60
+	// timing for each second of ticks is written to the log and the s_*_tick_time cvars
+	int hades_server_main(int argc, char* argv[], std::string_view game,
+		register_resource_types_fn = nullptr);
+}
+
+#endif //!HADES_SERVER_MAIN_HPP
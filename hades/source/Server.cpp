@@ -1,8 +1,16 @@
 #include "hades/Server.hpp"
 
+#include "hades/allocation_counter.hpp"
+#include "hades/async.hpp"
+#include "hades/cold_storage.hpp"
+#include "hades/console_variables.hpp"
+#include "hades/frame_arena.hpp"
 #include "hades/game_system.hpp"
 #include "hades/level.hpp"
+#include "hades/logging.hpp"
 #include "hades/players.hpp"
+#include "hades/properties.hpp"
+#include "hades/state_snapshot.hpp"
 
 namespace hades
 {
@@ -14,76 +22,619 @@ namespace hades
 		//register_systems_resources();
 	}
 
+	// waits for all the jobs to finish, then returns the first exception thrown by any of them
+	static std::exception_ptr wait_for_all(std::vector<future<void>>& jobs) noexcept
+	{
+		auto error = std::exception_ptr{};
+		for (auto& j : jobs)
+		{
+			try
+			{
+				j.get();
+			}
+			catch (...)
+			{
+				if (!error)
+					error = std::current_exception();
+			}
+		}
+
+		return error;
+	}
+
 	class local_server_hub;
 	static game_interface* get_game_interface(local_server_hub&) noexcept;
 	static const std::vector<player_data>* get_players(local_server_hub&) noexcept;
+	static void record_input(local_server_hub&, unique_id level, unique_id player, time_point, const std::vector<action>&);
+	static bool is_level_hibernating(const local_server_hub&, unique_id level) noexcept;
 
 	class local_server_level final : public server_level
 	{
 	public:
-		local_server_level(const level_save& sv, local_server_hub *server)
-			: _game{ sv, get_game_interface(*server), get_players(*server) }, _server(server)
-		{}
+		// source must outlive the level, it's used to restore the level after hibernating
+		local_server_level(unique_id id, const level_save& sv, const level* source, local_server_hub *server)
+			: _game{ std::in_place, sv, get_game_interface(*server), get_players(*server) }, _server(server), _id{ id },
+			_source{ source },
+			_cold_storage{ console::get_bool(cvars::server_cold_storage,
+				cvars::default_value::server_cold_storage) },
+			_snapshot_history{ console::get_float(cvars::server_snapshot_history,
+				cvars::default_value::server_snapshot_history) }
+		{
+			_game->get_state().cold_objects.set_spill_to_disk(console::get_bool(cvars::server_cold_storage_spill,
+				cvars::default_value::server_cold_storage_spill)->load());
+			state_api::enable_dirty_tracking(console::get_bool(cvars::server_dirty_tracking,
+				cvars::default_value::server_dirty_tracking)->load(), _game->get_extras());
+
+			if (console::get_bool(cvars::server_interest_management,
+				cvars::default_value::server_interest_management)->load())
+			{
+				_interest.emplace(_game->get_world_bounds(), console::get_float(cvars::server_interest_cell_size,
+					cvars::default_value::server_interest_cell_size)->load());
+			}
+		}
 
 		void tick(time_duration dt, unique_id level_id, const std::vector<player_data>* p, system_job_data::get_level_fn get_level)
 		{
-			auto data = system_job_data{ _level_time + dt, &_game.get_extras(), &_game.get_systems() };
+			assert(_game);
+			_last_tick_time = _level_time;
+			// release the last ticks temporaries
+			_frame_arena.reset();
+			auto data = system_job_data{ _level_time + dt, &_game->get_extras(), &_game->get_systems() };
+			data.frame_memory = _frame_arena.resource();
 			data.get_level = get_level;
+			data.deferred_calls = &_deferred_calls;
 			data.dt = dt;
 			data.players = p;
 			data.level_id = level_id;
-			data.level_data = &_game;
+			data.level_data = &*_game;
 			data.mission_data = get_game_interface(*_server);
-			_level_time = update_level(std::move(data), _game);
+			{
+				// counts every heap allocation made by the update, including by systems on the thread pool
+				_update_allocations.reset();
+				const auto counter = allocation_counter_scope{ &_update_allocations };
+				_level_time = update_level(std::move(data), *_game);
+			}
+
+			if (_interest)
+				_interest->update(_level_time, _game->get_state(), _game->get_extras());
 
 			//TODO: perhaps only clean this up when requested
 			// when running a listen server, this could mean the client won't have
 			// any state to read while running disconnect on these objects
-			for (const auto o : _game.get_destroyed_objects())
+			const auto cold_storage = _cold_storage->load();
+			for (const auto o : _game->get_destroyed_objects())
 			{
 				assert(o);
-				//TODO: extract objects for being saved in the replay
+				if (_interest)
+					_interest->remove(o->id);
+				_changed_objects.emplace_back(o->id);
 				//TODO: a way to pick and choose which kinds of object to save like this
-				//		
+				if (cold_storage)
+					state_api::move_to_cold_storage(*o, _game->get_state(), _game->get_extras());
+				else
+					state_api::erase_object(*o, _game->get_state(), _game->get_extras());
+			}
+
+			using std::chrono::duration_cast;
+			const auto history = _snapshot_history->load();
+			if (history > 0.f)
+				_take_snapshot(duration_cast<time_duration>(seconds_float{ history }));
+			else
+			{
+				_snapshots.clear();
+				_changed_objects.clear();
+			}
+			return;
+		}
+
+		// true if this level has a snapshot from at least dt ago
+		bool can_rewind(time_duration dt) const noexcept
+		{
+			return !empty(_snapshots) && _snapshots.front().time <= _level_time - dt;
+		}
+
+		// how far back the newest snapshot from at least dt ago is, rewinding by this lands exactly on it
+		//	returns nullopt if there are no snapshots that old
+		std::optional<time_duration> rewind_distance(time_duration dt) const noexcept
+		{
+			const auto target = _level_time - dt;
+			const auto snapshot = std::find_if(rbegin(_snapshots), rend(_snapshots), [target](const auto& s) noexcept {
+				return s.time <= target;
+				});
+
+			if (snapshot == rend(_snapshots))
+				return std::nullopt;
+			return _level_time - snapshot->time;
+		}
+
+		// restores the newest snapshot from at least dt ago
+		//	returns false if there are no snapshots that old
+		bool rewind(time_duration dt)
+		{
+			const auto target = _level_time - dt;
+			const auto snapshot = std::find_if(rbegin(_snapshots), rend(_snapshots), [target](const auto& s) noexcept {
+				return s.time <= target;
+				});
+
+			if (snapshot == rend(_snapshots))
+				return false;
+
+			_game->restore_snapshot(*snapshot);
+			_level_time = snapshot->time;
+			// the snapshot is kept, so the level can be rewound to the same point again
+			_snapshots.erase(snapshot.base(), end(_snapshots));
+			_deferred_calls.clear();
+			if (_interest)
+			{
+				_interest->reset();
+				_interest->update(_level_time, _game->get_state(), _game->get_extras());
+			}
+			return true;
+		}
+
+		// makes the calls that systems in this level deferred to other levels during the last tick
+		//	calls deferred by these calls will be made after the next tick
+		void call_deferred(unique_id level_id, const std::vector<player_data>* p, system_job_data::get_level_fn get_level)
+		{
+			const auto calls = std::exchange(_deferred_calls, {});
+			for (const auto& call : calls)
+			{
+				const auto target = call.level == unique_zero ?
+					get_game_interface(*_server) : std::invoke(get_level, call.level);
 
-				state_api::erase_object(*o, _game.get_state(), _game.get_extras());
+				if (!target)
+				{
+					// get_level has asked for the level to be restored, hold the call until it is
+					if (is_level_hibernating(*_server, call.level))
+					{
+						_deferred_calls.emplace_back(call);
+						continue;
+					}
+
+					LOGWARNING("Deferred call to unavailable level: " + to_string(call.level) +
+						", from level: " + to_string(level_id));
+					continue;
+				}
+
+				// the call runs in the target level, but doesn't belong to any of its systems
+				//	so system data and sleeping entities aren't available, see: game::sleep_system
+				auto& extras = target->get_extras();
+				auto data = system_job_data{ _level_time, &extras, &extras.systems };
+				data.get_level = get_level;
+				data.deferred_calls = &_deferred_calls;
+				data.players = p;
+				data.level_id = call.level;
+				data.level_data = target;
+				data.mission_data = get_game_interface(*_server);
+				const auto scope = detail::game_data_scope{ &data };
+				std::invoke(call.function);
 			}
+			return;
+		}
+
+		// number of allocations during the last tick that didn't fit in the frame arena
+		std::size_t frame_arena_overflow() const noexcept
+		{
+			return _frame_arena.heap_allocation_count();
+		}
+
+		// number of heap allocations made by update_level during the last tick
+		std::size_t update_allocations() const noexcept
+		{
+			return _update_allocations.count();
+		}
+
+		bool needs_compaction(time_duration interval) const noexcept
+		{
+			return _level_time - _last_compaction >= interval;
+		}
+
+		// removes curve keyframes older than history, see: state_api::compact_curves
+		void compact_curves(time_duration history)
+		{
+			state_api::compact_curves(_last_compaction, _level_time, history, _game->get_extras());
+			_last_compaction = _level_time;
+			return;
 		}
 
 		void send_request(unique_id id, std::vector<action> a) override
 		{
 			// TODO: verify that the id represents this client
-			_game.update_input_queue(id, std::move(a), _level_time);
+			record_input(*_server, _id, id, _level_time, a);
+			_last_used = _level_time;
+			if (!_game)
+			{
+				// passed on once the level has been restored
+				_pending_input.emplace_back(id, std::move(a));
+				_wake_requested = true;
+				return;
+			}
+
+			_game->update_input_queue(id, std::move(a), _level_time);
+			return;
+		}
+
+		void get_changes(exported_curves& exp, time_point t) const override
+		{
+			// nothing changes while the level is hibernating
+			if (!_game)
+			{
+				exp.clear();
+				_wake_requested = true;
+				return;
+			}
+
+			_last_used = _level_time;
+			state_api::export_changes(t, _game->get_state(), _game->get_extras(), exp);
 			return;
 		}
 
-		//TODO: exported curves is dead
-		void get_changes(exported_curves &, time_point) const override
+		void get_changes(exported_curves& exp) const override
 		{
+			get_changes(exp, _last_update_time);
+			_last_update_time = _level_time;
 			return;
 		}
 
-		void get_changes(exported_curves&) const override
+		void get_changes(exported_curves& exp, time_point t, rect_float view, interest_set& interest) const override
 		{
+			if (!_interest || !_game)
+			{
+				get_changes(exp, t);
+				return;
+			}
+
+			_last_used = _level_time;
+
+			const auto changes = update_interest(interest, _interest->find(view));
+			state_api::export_changes(t, changes, _game->get_state(), _game->get_extras(), exp);
 			return;
 		}
 
+		void set_view(rect_float) noexcept override
+		{}
+
+		time_point get_level_time() const noexcept override
+		{
+			return _level_time;
+		}
+
+		bool is_available() const noexcept override
+		{
+			return _game.has_value();
+		}
+
 		common_interface* get_interface() noexcept override
 		{
-			return &_game;
+			return try_get_game_interface();
 		}
 
 		game_interface* try_get_game_interface() noexcept override
 		{
-			return &_game;
+			if (!_game)
+			{
+				_wake_requested = true;
+				return nullptr;
+			}
+
+			_last_used = _level_time;
+			return &*_game;
+		}
+
+		// hibernating levels use the hash from when they were hibernated
+		//	keyframes written during the last tick are all hashed, see: state_api::hash_state
+		std::uint64_t hash_state() const
+		{
+			if (!_game)
+			{
+				assert(_hibernated);
+				return _hibernated->hash;
+			}
+
+			return state_api::hash_state(_last_tick_time, _game->get_state(), _game->get_extras());
+		}
+
+		// true if the level can hibernate, it must not have been used for at least idle_time
+		bool can_hibernate(time_duration idle_time) const noexcept
+		{
+			return _game && empty(_deferred_calls) && _level_time - _last_used >= idle_time;
+		}
+
+		// true if the level was used while it was hibernating, and isn't being restored yet, see: begin_wake
+		bool wake_requested() const noexcept
+		{
+			return _wake_requested && !_restoring;
+		}
+
+		// true once the level has been restored on the thread pool, see: finish_wake
+		bool restored() noexcept
+		{
+			return _restoring && _restoring->ready();
+		}
+
+		void request_wake() noexcept
+		{
+			_last_used = _level_time;
+			_wake_requested = true;
+			return;
+		}
+
+		// packs the levels objects into a compressed store, then frees the level
+		//	the level stops ticking until it's restored, see: wake
+		//	spill writes the store to a temp file, the same as s_cold_storage_spill
+		void hibernate(time_point mission_time, bool spill)
+		{
+			assert(_game);
+			auto& state = _game->get_state();
+			auto& extras = _game->get_extras();
+
+			auto h = hibernated_level{};
+			h.objects.set_spill_to_disk(spill);
+			for (const auto& o : extras.objects)
+				h.objects.insert(state_api::extract_object(o, state));
+
+			h.cold_objects = std::move(state.cold_objects);
+			h.next_id = state.next_id;
+			h.mission_time = mission_time;
+			h.dirty_tracking = extras.dirty_curves.enabled;
+			h.hash = hash_state();
+			h.level_locals = std::move(extras.level_locals);
+			h.level_local_slots = std::move(extras.level_local_slots);
+
+			// the systems are kept with their data and in the same order
+			//	the entity lists point at the objects being freed, so only the sleeping entities are remembered
+			for (const auto s : extras.systems.get_systems())
+			{
+				auto& sleeping = h.sleeping_entities.emplace_back();
+				for (const auto list : { &s->attached_entities, &s->sleeping_ents })
+				{
+					for (const auto& [object, activation] : *list)
+					{
+						if (activation != time_point::min())
+							sleeping.emplace_back(object.id, activation);
+					}
+				}
+
+				std::sort(begin(sleeping), end(sleeping));
+				s->attached_entities.clear();
+				s->sleeping_ents.clear();
+				s->new_ents.clear();
+				s->created_ents.clear();
+				s->removed_ents.clear();
+			}
+
+			h.systems = std::move(extras.systems);
+			// the level isn't being destroyed, so on_destroy isn't called
+			extras.systems = {};
+
+			_game.reset();
+			_snapshots.clear();
+			if (_interest)
+				_interest->reset();
+			_hibernated.emplace(std::move(h));
+			return;
+		}
+
+		// starts restoring the level on the thread pool if it's hibernating
+		//	the level keeps hibernating until it's swapped in by finish_wake
+		void begin_wake()
+		{
+			_wake_requested = false;
+			if (_game || _restoring)
+				return;
+
+			assert(_hibernated);
+			// the hibernated state isn't touched by anything else until the level is swapped in
+			//	and the levels are kept in a deque, so the pointers stay valid
+			_restoring.emplace(async([h = &*_hibernated, source = _source, level_time = _level_time,
+				mission = get_game_interface(*_server), players = get_players(*_server)]() {
+				return _restore(*h, *source, level_time, mission, players);
+			}));
+			return;
+		}
+
+		// swaps in the restored level, waiting for it to finish restoring if needed
+		//	the level skips ahead by the mission time it missed, this keeps the level time in step with the mission time
+		void finish_wake(time_point mission_time)
+		{
+			assert(_restoring);
+			auto restoring = std::move(*_restoring);
+			_restoring.reset();
+			_game.emplace(restoring.get());
+
+			// level locals may have been registered while the level was restoring
+			auto& extras = _game->get_extras();
+			extras.level_local_slots.resize(detail::level_local_count());
+
+			// the level didn't tick while it was hibernating
+			_level_time += std::max(mission_time - _hibernated->mission_time, time_duration::zero());
+			_last_used = _level_time;
+			_hibernated.reset();
+
+			if (_interest)
+				_interest->update(_level_time, _game->get_state(), extras);
+
+			for (auto& [player, actions] : std::exchange(_pending_input, {}))
+				_game->update_input_queue(player, std::move(actions), _level_time);
+			return;
+		}
+
+		// restores the level if it's hibernating, and waits for it to finish
+		void wake(time_point mission_time)
+		{
+			begin_wake();
+			if (_restoring)
+				finish_wake(mission_time);
+			return;
+		}
+
+		// waits for a restore that was started by begin_wake, and throws away the result
+		//	called before the server is destroyed, as the restore uses the mission
+		void cancel_wake() noexcept
+		{
+			if (!_restoring)
+				return;
+
+			try
+			{
+				std::ignore = _restoring->get();
+			}
+			catch (...)
+			{}
+
+			_restoring.reset();
+			return;
 		}
 
 	private:
-		game_implementation _game;
+		struct hibernated_level;
+
+		// loads the hibernated objects into a new game, and hands them over to the systems that were kept
+		//	runs on the thread pool, see: begin_wake
+		static game_implementation _restore(hibernated_level& h, const level& source, time_point level_time,
+			game_interface* mission, const std::vector<player_data>* players)
+		{
+			// the level is loaded the same way as a level save
+			//	without its on_load script, since what it set up was kept
+			auto sv = level_save{};
+			sv.source = source;
+			sv.source.on_load = unique_zero;
+			sv.level_time = level_time;
+			sv.objects.objects = h.objects.get_all();
+			// restore_object expects ids to be lower than next_id
+			sv.objects.next_id = next(h.next_id);
+
+			// loading replaces the game data for this thread
+			//	pool threads can be running this while helping a thread that is ticking a level
+			const auto scope = detail::game_data_scope{ nullptr };
+			auto game = game_implementation{ sv, mission, players };
+
+			auto& state = game.get_state();
+			auto& extras = game.get_extras();
+			state.next_id = h.next_id;
+			state.cold_objects = std::move(h.cold_objects);
+			state_api::enable_dirty_tracking(h.dirty_tracking, extras);
+			extras.level_locals = std::move(h.level_locals);
+			extras.level_local_slots = std::move(h.level_local_slots);
+
+			// hand the loaded objects over to the systems that were kept
+			//	systems only installed by the load are new, and get on_create as usual
+			auto& systems = h.systems;
+			const auto kept_systems = systems.get_systems();
+			for (const auto s : extras.systems.get_systems())
+			{
+				const auto kept = std::ranges::find(kept_systems, s->system, &game_system::system);
+				if (kept == end(kept_systems))
+				{
+					for (const auto& entity : s->attached_entities)
+						systems.attach_system_from_load(entity.object, s->system->id);
+					continue;
+				}
+
+				(*kept)->attached_entities = std::move(s->attached_entities);
+			}
+
+			for (auto i = std::size_t{}; i < size(h.sleeping_entities); ++i)
+			{
+				const auto& sleeping = h.sleeping_entities[i];
+				for (auto& [object, activation] : kept_systems[i]->attached_entities)
+				{
+					const auto iter = std::lower_bound(begin(sleeping), end(sleeping), object.id,
+						[](const std::pair<entity_id, time_point>& e, const entity_id id) noexcept {
+							return e.first < id;
+						});
+					if (iter != end(sleeping) && iter->first == object.id)
+						activation = iter->second;
+				}
+			}
+
+			extras.systems = std::move(systems);
+			return game;
+		}
+
+		// snapshots share unchanged curves with the previous snapshot
+		//	so keeping one per tick only costs the curves that were written to
+		void _take_snapshot(time_duration history)
+		{
+			auto& extras = _game->get_extras();
+			if (empty(_snapshots) || !extras.dirty_curves.enabled)
+			{
+				// the dirty curve list is what lets a snapshot skip the objects that didn't change
+				//	it's only complete from the tick after it was turned on, so compare everything this tick
+				state_api::enable_dirty_tracking(true, extras);
+				const auto previous = empty(_snapshots) ? nullptr : &_snapshots.back();
+				_snapshots.emplace_back(state_api::take_snapshot(_level_time, _game->get_state(),
+					extras, previous));
+			}
+			else
+			{
+				for (const auto& c : state_api::get_dirty_curves(extras))
+				{
+					if (empty(_changed_objects) || _changed_objects.back() != c.object)
+						_changed_objects.emplace_back(c.object);
+				}
+
+				_snapshots.emplace_back(state_api::take_snapshot(_level_time, _game->get_state(),
+					extras, _snapshots.back(), _changed_objects));
+			}
+
+			_changed_objects.clear();
+
+			while (_snapshots.front().time < _level_time - history)
+				_snapshots.pop_front();
+			return;
+		}
+
+		// the state of a level while it is hibernating
+		struct hibernated_level
+		{
+			// the levels objects, packed and compressed
+			cold_object_store objects;
+			// game_state::cold_objects is kept as it is
+			cold_object_store cold_objects;
+			entity_id next_id = bad_entity;
+			// the mission time when the level was hibernated
+			time_point mission_time;
+			bool dirty_tracking = false;
+			std::uint64_t hash = {};
+			any_map<unique_id> level_locals;
+			std::vector<detail::level_local_slot> level_local_slots;
+			// the systems without their entity lists
+			system_behaviours<game_system> systems;
+			// entities that were asleep in each system, and when they wake, sorted by id
+			std::vector<std::vector<std::pair<entity_id, time_point>>> sleeping_entities;
+		};
+
+		// empty while the level is hibernating
+		std::optional<game_implementation> _game;
+		std::vector<deferred_level_call> _deferred_calls;
+		frame_arena _frame_arena;
+		allocation_counter _update_allocations;
 		
 		local_server_hub *_server; 
+		unique_id _id;
+		const level* _source;
+		console::property_bool _cold_storage;
+		console::property_float _snapshot_history;
+		std::deque<state_snapshot<game_system>> _snapshots;
+		// objects erased this tick, and then the objects in the dirty curve list
+		//	kept between ticks to reuse the memory
+		std::vector<entity_id> _changed_objects;
+		// only created when s_interest_management is set
+		std::optional<interest_grid> _interest;
+		std::optional<hibernated_level> _hibernated;
+		// set while the level is being restored on the thread pool, see: begin_wake
+		std::optional<future<game_implementation>> _restoring;
+		// input sent while the level was hibernating
+		std::vector<std::pair<unique_id, std::vector<action>>> _pending_input;
+		mutable bool _wake_requested = false;
+		// the level time when a client last used this level
+		mutable time_point _last_used;
 
 		time_point _level_time;
+		// the level time at the start of the last tick
+		time_point _last_tick_time;
+		time_point _last_compaction;
 		time_point _instance_time;
 		mutable time_point _last_update_time;
 	};
@@ -91,12 +642,29 @@ namespace hades
 	// used to implement get_level
 	static local_server_hub* local_server = {};
 
-	//TODO: handle advertising local network and accepting connections from remote_server_hubs
+	// remote_server_hubs connect through a server_host wrapped around this hub, see: remote_server.hpp
+	//TODO: handle advertising on the local network
 	class local_server_hub final : public server_hub
 	{
 	public:
 		local_server_hub(mission_save lvl, unique_id slot = unique_zero)
-			: _mission{ std::move(lvl) }
+			: _mission{ std::move(lvl) },
+			_parallel_levels{ console::get_bool(cvars::server_parallel_levels,
+				cvars::default_value::server_parallel_levels) },
+			_curve_compaction{ console::get_bool(cvars::server_curve_compaction,
+				cvars::default_value::server_curve_compaction) },
+			_curve_history{ console::get_float(cvars::server_curve_history,
+				cvars::default_value::server_curve_history) },
+			_curve_compaction_interval{ console::get_float(cvars::server_curve_compaction_interval,
+				cvars::default_value::server_curve_compaction_interval) },
+			_frame_arena_overflow{ console::get_int(cvars::server_frame_arena_overflow,
+				cvars::default_value::server_frame_arena_overflow) },
+			_update_allocations{ console::get_int(cvars::server_update_allocations,
+				cvars::default_value::server_update_allocations) },
+			_hibernate_after{ console::get_float(cvars::server_hibernate_after,
+				cvars::default_value::server_hibernate_after) },
+			_hibernated_levels{ console::get_int(cvars::server_hibernated_levels,
+				cvars::default_value::server_hibernated_levels) }
 		{
 			assert(slot != unique_zero);
 			if (slot == unique_zero) //TODO: needed for lobbies and so on.
@@ -128,26 +696,109 @@ namespace hades
 
 			// store the levels
 			for (auto& l : _mission.level_saves)
-				_levels.emplace_back(level{ l.name, local_server_level{ l.save, this } });
+				_levels.emplace_back(level{ l.name, local_server_level{ l.name, l.save, &l.save.source, this } });
+		}
+
+		~local_server_hub() noexcept override
+		{
+			for (auto& l : _levels)
+				l.instance.cancel_wake();
 		}
 
 		void update(time_duration dt) override
 		{
+			// levels that were used while hibernating are restored on the thread pool
+			//	and swapped in at the start of the first update after they're ready
+			//	when playing back a replay they're woken by the replay instead, see: play_hibernation
+			if (!_replay_playback)
+			{
+				for (auto& l : _levels)
+				{
+					if (l.instance.restored())
+						_wake_level(l.id, l.instance);
+					else if (l.instance.wake_requested())
+						l.instance.begin_wake();
+				}
+			}
+
 			//tick the mission contruct
 			//_mission_instance->tick(dt, &_players);
+			_last_mission_time = _mission_time;
 			_mission_time += dt;
 			//tick all the level contructs
 			//they will give accesss to the mission construct as well.
 			local_server = this;
 
-			constexpr auto get_level = [](unique_id lvl) noexcept {
+			constexpr auto get_level = [](unique_id lvl) {
 				return local_server->find_level(lvl);
 			};
 
-			for(auto &l : _levels)
-				l.instance.tick(dt, l.id, &_players, get_level);
+			if (_parallel_levels->load() && size(_levels) > 1)
+			{
+				// levels can't access each other while ticking concurrently
+				// so they are given no get_level function, they must
+				// defer their calls to other levels instead
+				auto ticks = std::vector<future<void>>{};
+				ticks.reserve(size(_levels));
+				for (auto& l : _levels)
+				{
+					if (!l.instance.is_available())
+						continue;
+
+					ticks.emplace_back(async([&l, dt, players = &_players]() {
+						l.instance.tick(dt, l.id, players, nullptr);
+						return;
+					}));
+				}
+
+				// wait for every level before passing on any errors
+				const auto error = wait_for_all(ticks);
+				if (error)
+				{
+					local_server = {};
+					std::rethrow_exception(error);
+				}
+			}
+			else
+			{
+				for (auto& l : _levels)
+				{
+					if (l.instance.is_available())
+						l.instance.tick(dt, l.id, &_players, get_level);
+				}
+			}
+
+			// deferred calls are always made in level order
+			// so the result is the same whether levels were ticked concurrently or not
+			for (auto& l : _levels)
+			{
+				if (l.instance.is_available())
+					l.instance.call_deferred(l.id, &_players, get_level);
+			}
 
 			local_server = {};
+
+			auto arena_overflow = std::size_t{};
+			auto update_allocations = std::size_t{};
+			for (const auto& l : _levels)
+			{
+				if (!l.instance.is_available())
+					continue;
+				arena_overflow += l.instance.frame_arena_overflow();
+				update_allocations += l.instance.update_allocations();
+			}
+			_frame_arena_overflow->store(integer_clamp_cast<int32>(arena_overflow));
+			_update_allocations->store(integer_clamp_cast<int32>(update_allocations));
+
+			if (_curve_compaction->load())
+				_compact_levels();
+
+			if (_replay)
+				_replay->record_tick(_mission_time, get_state_hash());
+
+			// after the tick is recorded, so a replay hibernates the levels between the same ticks
+			_hibernate_levels();
+			return;
 		}
 
 		time_point get_time() const noexcept override
@@ -155,17 +806,105 @@ namespace hades
 			return _mission_time;
 		}
 
-		void get_updates(exported_curves& exp, time_point dt) const override
+		bool rewind(time_duration dt) override
 		{
-			//_last_local_update_request = _mission_instance->get_time();
+			// replays don't record rewinds, so playing one back would diverge from the recording
+			if (_replay)
+			{
+				LOGWARNING("Cannot rewind while a replay is being recorded");
+				return false;
+			}
+
+			// hibernating levels aren't ticking, so they have nothing to rewind
+			//	the rest are rewound to the same tick, and the mission time follows them
+			auto distance = std::optional<time_duration>{};
+			for (const auto& l : _levels)
+			{
+				if (!l.instance.is_available())
+					continue;
+
+				const auto d = l.instance.rewind_distance(dt);
+				if (!d)
+					return false;
+				distance = distance ? std::max(*distance, *d) : *d;
+			}
+
+			if (!distance)
+			{
+				_mission_time -= dt;
+				return true;
+			}
+
+			const auto can_rewind = std::ranges::all_of(_levels, [d = *distance](const level& l) noexcept {
+				return !l.instance.is_available() || l.instance.can_rewind(d);
+				});
+
+			if (!can_rewind)
+				return false;
+
+			for (auto& l : _levels)
+			{
+				if (l.instance.is_available())
+					l.instance.rewind(*distance);
+			}
+			_mission_time -= *distance;
+			return true;
+		}
+
+		void set_replay_writer(replay_writer* r) noexcept override
+		{
+			_replay = r;
+			return;
+		}
+
+		void set_replay_playback(bool playback) noexcept override
+		{
+			_replay_playback = playback;
+			return;
+		}
+
+		bool play_hibernation(unique_id id, bool hibernating) override
+		{
+			const auto l = std::ranges::find(_levels, id, &local_server_hub::level::id);
+			if (l == end(_levels))
+				return false;
+
+			if (!hibernating)
+				_wake_level(l->id, l->instance);
+			else if (l->instance.is_available())
+				l->instance.hibernate(_mission_time, _spill_hibernated_levels());
+			return true;
+		}
+
+		std::uint64_t get_state_hash() const override
+		{
+			assert(_mission_instance);
+			// levels are kept in the order they were created, so combining their hashes in order is stable
+			auto out = state_api::hash_state(_last_mission_time, _mission_instance->get_state(), _mission_instance->get_extras());
+			for (const auto& l : _levels)
+				out = (out * 1099511628211u) ^ l.instance.hash_state();
+			return out;
+		}
+
+		void record_input(unique_id level, unique_id player, time_point t, const std::vector<action>& a)
+		{
+			if (_replay)
+				_replay->record_input(level, player, t, a);
+			return;
+		}
+
+		void get_updates(exported_curves& exp, time_point t) const override
+		{
+			assert(_mission_instance);
+			state_api::export_changes(t, _mission_instance->get_state(), _mission_instance->get_extras(), exp);
 			return;
-			//return _level.get_changes(exp, dt);
 		}
 
 		void get_updates(exported_curves &exp) const override
 		{
-			const auto dt = _last_local_update_request;
-			return get_updates(exp, dt);
+			get_updates(exp, _last_local_update_request);
+			_last_local_update_request = _mission_time;
+			return;
 		}
 
 		common_interface* get_interface() noexcept override
@@ -201,10 +940,21 @@ namespace hades
 			return _mission.source;
 		}
 
-		game_interface* find_level(unique_id id) noexcept
+		// returns nullptr for hibernating levels, and asks for them to be restored
+		//	calls deferred to them are held until then, see: local_server_level::call_deferred
+		game_interface* find_level(unique_id id)
 		{
 			const auto out = std::ranges::find(_levels, id, &local_server_hub::level::id);
-			return out == end(_levels) ? nullptr : out->instance.try_get_game_interface();
+			if (out == end(_levels))
+				return nullptr;
+
+			return out->instance.try_get_game_interface();
+		}
+
+		bool is_hibernating(unique_id id) const noexcept
+		{
+			const auto out = std::ranges::find(_levels, id, &local_server_hub::level::id);
+			return out != end(_levels) && !out->instance.is_available();
 		}
 
 		server_level* connect_to_level(unique_id id) override
@@ -215,7 +965,10 @@ namespace hades
 			for (auto& l : _levels)
 			{
 				if (l.id == id)
+				{
+					l.instance.request_wake();
 					return &l.instance;
+				}
 			}
 
 			//load level
@@ -240,8 +993,10 @@ namespace hades
 				if (l.name == id)
 				{
 					const auto save = make_save_from_level(l.level_obj);
-					auto new_level = level{ id, { save, this } };
+					auto new_level = level{ id, { id, save, &l.level_obj, this } };
 					auto &out = _levels.emplace_back(std::move(new_level));
+					if (_replay)
+						_replay->record_level(id);
 					return &out.instance;
 				}
 			}
@@ -253,13 +1008,111 @@ namespace hades
 		{}
 
 	private:
+		// trims old keyframes from each level that is due for compaction
+		//	levels are compacted at the same time on the thread pool
+		//	finishes before returning, so clients never read a level while it's being compacted
+		void _compact_levels()
+		{
+			using std::chrono::duration_cast;
+			const auto interval = duration_cast<time_duration>(seconds_float{ _curve_compaction_interval->load() });
+			const auto history = duration_cast<time_duration>(seconds_float{ std::max(_curve_history->load(), 0.f) });
+
+			auto jobs = std::vector<future<void>>{};
+			for (auto& l : _levels)
+			{
+				if (!l.instance.is_available() || !l.instance.needs_compaction(interval))
+					continue;
+
+				jobs.emplace_back(async([&l, history]() {
+					l.instance.compact_curves(history);
+					return;
+				}));
+			}
+
+			const auto error = wait_for_all(jobs);
+			if (error)
+				std::rethrow_exception(error);
+			return;
+		}
+
+		// compresses and frees the levels that haven't been used for s_hibernate_after seconds
+		//	levels are hibernated at the same time on the thread pool
+		void _hibernate_levels()
+		{
+			using std::chrono::duration_cast;
+			const auto after = _hibernate_after->load();
+			if (after > 0.f && !_replay_playback)
+			{
+				const auto idle_time = duration_cast<time_duration>(seconds_float{ after });
+				const auto spill = _spill_hibernated_levels();
+
+				auto hibernating = std::vector<level*>{};
+				auto jobs = std::vector<future<void>>{};
+				for (auto& l : _levels)
+				{
+					if (!l.instance.can_hibernate(idle_time))
+						continue;
+
+					hibernating.emplace_back(&l);
+					jobs.emplace_back(async([&l, t = _mission_time, spill]() {
+						l.instance.hibernate(t, spill);
+						return;
+					}));
+				}
+
+				const auto error = wait_for_all(jobs);
+				if (error)
+					std::rethrow_exception(error);
+
+				if (_replay)
+				{
+					for (const auto l : hibernating)
+						_replay->record_hibernation(l->id, true);
+				}
+			}
+
+			const auto hibernating = std::ranges::count_if(_levels, [](const level& l) noexcept {
+				return !l.instance.is_available();
+				});
+			_hibernated_levels->store(integer_clamp_cast<int32>(hibernating));
+			return;
+		}
+
+		void _wake_level(unique_id id, local_server_level& l)
+		{
+			const auto hibernating = !l.is_available();
+			l.wake(_mission_time);
+			if (hibernating && _replay)
+				_replay->record_hibernation(id, false);
+			return;
+		}
+
+		static bool _spill_hibernated_levels()
+		{
+			return console::get_bool(cvars::server_cold_storage_spill,
+				cvars::default_value::server_cold_storage_spill)->load();
+		}
+
 		mutable time_point _last_local_update_request;
 		//save file for the current game
 		//also stores the state for unloaded levels
 		mission_save _mission;
+		console::property_bool _parallel_levels;
+		console::property_bool _curve_compaction;
+		console::property_float _curve_history;
+		console::property_float _curve_compaction_interval;
+		console::property_int _frame_arena_overflow;
+		console::property_int _update_allocations;
+		console::property_float _hibernate_after;
+		console::property_int _hibernated_levels;
+		replay_writer* _replay = {};
+		// levels only hibernate and wake when the replay says to, see: play_hibernation
+		bool _replay_playback = false;
 
 		std::optional<game_implementation> _mission_instance;
 		time_point _mission_time;
+		// the mission time at the start of the last update
+		time_point _last_mission_time;
 		//players
 		//TODO: wrap player_data and add network info etc.
 		std::vector<player_data> _players;
@@ -286,8 +1139,18 @@ namespace hades
 		return s.get_players();
 	}
 
-	//has to handle networking and resolving unique_id differences between hosts
-	//remote server hub
+	static void record_input(local_server_hub& s, unique_id level, unique_id player, time_point t, const std::vector<action>& a)
+	{
+		s.record_input(level, player, t, a);
+		return;
+	}
+
+	static bool is_level_hibernating(const local_server_hub& s, unique_id level) noexcept
+	{
+		return s.is_hibernating(level);
+	}
+
+	//remote_server_hub and server_host are in remote_server.cpp
 
 	std::unique_ptr<server_hub> create_server(mission_save lvl)
 	{
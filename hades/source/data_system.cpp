@@ -313,6 +313,15 @@ namespace hades::data
 		return out.first->second;
 	}
 
+	std::vector<std::pair<unique_id, string>> data_system::get_all_names_impl() const
+	{
+		auto out = std::vector<std::pair<unique_id, string>>{};
+		out.reserve(size(_ids));
+		for (const auto& [name, id] : _ids)
+			out.emplace_back(id, name);
+		return out;
+	}
+
 	// TODO: redo this func, see parseYaml
 	template<typename YAMLPARSER>
 	static void parseInclude(unique_id mod, const std::filesystem::path &file, const data::mod& mod_info, YAMLPARSER &&yamlParser)
@@ -0,0 +1,976 @@
+#include "hades/remote_server.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "SFML/Network/IpAddress.hpp"
+
+#include "hades/console_variables.hpp"
+#include "hades/data.hpp"
+#include "hades/deflate.hpp"
+#include "hades/logging.hpp"
+#include "hades/utility.hpp"
+
+using namespace std::string_literals;
+
+namespace hades
+{
+	namespace
+	{
+		// increase this whenever the messages below are changed
+		constexpr auto protocol_version = std::uint8_t{ 2 };
+		constexpr auto connect_timeout = 5.f; // seconds
+		constexpr auto resync_timeout = seconds{ 5 };
+
+		// every packet starts with one of these
+		enum class message : std::uint8_t
+		{
+			// client -> host
+			hello,				// protocol version, player slot name
+			connect_level,		// level id
+			disconnect_level,	// disconnects from every level
+			input,				// client time, level count, [level id, action count, [action]]
+			resync,				// level id(zero for the mission), since
+			view,				// level id, x, y, width, height
+			// host -> client
+			welcome,			// player id, player entity, mission time, serialised mission, name count, [id, name]
+			refused,			// reason
+			changes				// level id(zero for the mission), is resync, mission time, echoed client time,
+								//	uncompressed size, deflated exported_curves
+		};
+
+		// keyframes at the start of the game are included in a clients first changes
+		constexpr auto initial_sync_time = time_point{ time_duration{ -1 } };
+
+		void write_message(sf::Packet& p, const message m)
+		{
+			p << enum_type(m);
+			return;
+		}
+
+		message read_message(sf::Packet& p)
+		{
+			auto m = std::uint8_t{};
+			p >> m;
+			return message{ m };
+		}
+
+		void write_id(sf::Packet& p, const unique_id id)
+		{
+			p << id.get();
+			return;
+		}
+
+		// the id may belong to another process, see: remote_server_hub::_to_local
+		unique_id read_id(sf::Packet& p)
+		{
+			auto value = unique_id::type{};
+			p >> value;
+			auto out = unique_id{};
+			static_assert(sizeof(out) == sizeof(value) && std::is_trivially_copyable_v<unique_id>);
+			std::memcpy(&out, &value, sizeof(out));
+			return out;
+		}
+
+		void write_time(sf::Packet& p, const time_point t)
+		{
+			p << std::int64_t{ t.time_since_epoch().count() };
+			return;
+		}
+
+		time_point read_time(sf::Packet& p)
+		{
+			auto value = std::int64_t{};
+			p >> value;
+			return time_point{ time_duration{ value } };
+		}
+
+		std::int64_t clock_now() noexcept
+		{
+			return time_clock::now().time_since_epoch().count();
+		}
+
+		void write_action(sf::Packet& p, const action& a, const unique_id::type id)
+		{
+			p << id << a.x_axis << a.y_axis << a.u_axis << a.v_axis << a.active;
+			return;
+		}
+
+		action read_action(sf::Packet& p)
+		{
+			auto a = action{};
+			a.id = read_id(p);
+			p >> a.x_axis >> a.y_axis >> a.u_axis >> a.v_axis >> a.active;
+			return a;
+		}
+
+		std::size_t packet_size(const sf::Packet& p) noexcept
+		{
+			// sfml adds a 4 byte size to each packet
+			return p.getDataSize() + sizeof(std::uint32_t);
+		}
+
+		sf::Packet make_changes_packet(const unique_id level, const bool resync, const time_point t,
+			const std::int64_t echo, const exported_curves& e, std::vector<std::byte>& buffer)
+		{
+			buffer.clear();
+			write_exported_curves(e, buffer);
+			// changes are compressed for every client on every tick, so favour speed
+			const auto compressed = zip::deflate(buffer, Z_BEST_SPEED);
+
+			auto p = sf::Packet{};
+			write_message(p, message::changes);
+			write_id(p, level);
+			p << resync;
+			write_time(p, t);
+			p << echo << integer_cast<std::uint32_t>(std::size(buffer));
+			p.append(compressed.data(), std::size(compressed));
+			return p;
+		}
+
+		// reads the rest of a changes packet
+		void read_changes(sf::Packet& p, exported_curves& out)
+		{
+			auto size = std::uint32_t{};
+			p >> size;
+			if (!p)
+				throw export_error{ "changes packet is truncated" };
+
+			const auto pos = p.getReadPosition();
+			const auto data = std::span{ static_cast<const std::byte*>(p.getData()) + pos, p.getDataSize() - pos };
+			const auto bytes = zip::inflate<std::byte>(data, size);
+			read_exported_curves(bytes, out);
+			return;
+		}
+
+		// adds the changes onto the end of out
+		//	apply_changes will add the keyframes of later sets after the earlier ones
+		void append_changes(exported_curves& out, exported_curves&& in)
+		{
+			if (out.empty())
+			{
+				out = std::move(in);
+				return;
+			}
+
+			const auto append = [](auto& to, auto&& from) {
+				to.insert(end(to), std::make_move_iterator(begin(from)), std::make_move_iterator(end(from)));
+				return;
+			};
+
+			// objects that left and then came back into view are sent again as created objects
+			//	this has to be checked before in.created_objects is moved from
+			std::erase_if(out.left_objects, [&in](const entity_id id) noexcept {
+				return std::ranges::find(in.created_objects, id, &exported_curves::exported_object::id) != end(in.created_objects);
+				});
+			out.since = std::min(out.since, in.since);
+			append(out.created_objects, std::move(in.created_objects));
+			append(out.destroyed_objects, std::move(in.destroyed_objects));
+			append(out.left_objects, std::move(in.left_objects));
+			append(out.entity_names, std::move(in.entity_names));
+			[&]<std::size_t... I>(std::index_sequence<I...>) {
+				(append(std::get<I>(out.curves), std::move(std::get<I>(in.curves))), ...);
+				return;
+			}(std::make_index_sequence<std::tuple_size_v<decltype(out.curves)>>{});
+			return;
+		}
+	}
+
+	server_host::server_host(server_hub& s, const unsigned short port)
+		: _server{ &s }, _bytes_sent{ console::get_int(cvars::server_net_bytes_sent,
+			cvars::default_value::server_net_bytes_sent) }
+	{
+		if (_listener.listen(port) != sf::Socket::Status::Done)
+			throw server_error{ "Unable to listen for clients on port: " + to_string(port) };
+		_listener.setBlocking(false);
+		LOG("Listening for clients on port: " + to_string(port));
+	}
+
+	void server_host::update()
+	{
+		_accept_clients();
+
+		for (auto& c : _clients)
+		{
+			if (c.socket)
+				_receive(c);
+		}
+
+		auto bytes_sent = std::size_t{};
+		for (auto& c : _clients)
+		{
+			if (c.socket && c.player != unique_zero)
+				_send_changes(c);
+			if (c.socket)
+				bytes_sent += _flush(c);
+		}
+
+		std::erase_if(_clients, [](const remote_client& c) noexcept {
+			return !c.socket;
+			});
+
+		_bytes_sent->store(integer_clamp_cast<int32>(bytes_sent));
+		return;
+	}
+
+	std::size_t server_host::client_count() const noexcept
+	{
+		return std::size(_clients);
+	}
+
+	void server_host::_accept_clients()
+	{
+		while (true)
+		{
+			auto socket = std::make_unique<sf::TcpSocket>();
+			if (_listener.accept(*socket) != sf::Socket::Status::Done)
+				return;
+
+			socket->setBlocking(false);
+			auto& c = _clients.emplace_back();
+			c.socket = std::move(socket);
+			c.mission_since = initial_sync_time;
+		}
+	}
+
+	void server_host::_receive(remote_client& c)
+	{
+		auto p = sf::Packet{};
+		while (c.socket)
+		{
+			const auto status = c.socket->receive(p);
+			if (status == sf::Socket::Status::NotReady || status == sf::Socket::Status::Partial)
+				return;
+			else if (status != sf::Socket::Status::Done)
+			{
+				_drop(c, "disconnected");
+				return;
+			}
+
+			const auto m = read_message(p);
+			if (c.player == unique_zero && m != message::hello)
+			{
+				_drop(c, "sent a message before joining");
+				return;
+			}
+
+			try
+			{
+				switch (m)
+				{
+				case message::hello:
+					_handle_hello(c, p);
+					break;
+				case message::connect_level:
+				{
+					const auto id = read_id(p);
+					const auto level = _server->connect_to_level(id);
+					if (!level)
+					{
+						LOGWARNING("Remote client requested unavailable level: " + to_string(id));
+						break;
+					}
+
+					if (std::ranges::find(c.levels, id, &level_connection::id) == end(c.levels))
+						c.levels.emplace_back(level_connection{ id, level, initial_sync_time });
+				}break;
+				case message::disconnect_level:
+					c.levels.clear();
+					break;
+				case message::input:
+					_handle_input(c, p);
+					break;
+				case message::resync:
+					_handle_resync(c, p);
+					break;
+				case message::view:
+					_handle_view(c, p);
+					break;
+				default:
+					_drop(c, "sent an unexpected message");
+					return;
+				}
+			}
+			catch (const std::exception& e)
+			{
+				// malformed data or a failed request only costs this client its connection
+				_drop(c, e.what());
+				return;
+			}
+
+			if (!p)
+			{
+				_drop(c, "sent a malformed message");
+				return;
+			}
+
+			p.clear();
+		}
+		return;
+	}
+
+	void server_host::_handle_hello(remote_client& c, sf::Packet& p)
+	{
+		auto version = std::uint8_t{};
+		auto slot_name = std::string{};
+		p >> version >> slot_name;
+
+		const auto refuse = [&c](std::string reason) {
+			auto out = sf::Packet{};
+			write_message(out, message::refused);
+			out << reason;
+			c.outgoing.emplace_back(std::move(out));
+			LOG("Refused remote client: " + reason);
+			return;
+		};
+
+		if (version != protocol_version)
+		{
+			refuse("protocol version mismatch, expected: "s + to_string(protocol_version));
+			return;
+		}
+
+		// the name came from the client, so don't give it an id if it isn't already known
+		const auto slot = data::find_uid(slot_name);
+		const auto taken = std::ranges::any_of(_clients, [slot](const remote_client& other) noexcept {
+			return other.socket && other.player == slot;
+			});
+
+		if (slot == unique_zero || taken)
+		{
+			refuse("player slot not available: " + slot_name);
+			return;
+		}
+
+		auto m = _server->get_mission();
+		const auto player = std::ranges::find(m.players, slot, &mission::player::id);
+		if (player == end(m.players))
+		{
+			refuse("no player slot named: " + slot_name);
+			return;
+		}
+
+		c.player = slot;
+
+		const auto names = data::get_all_names();
+		auto out = sf::Packet{};
+		write_message(out, message::welcome);
+		write_id(out, slot);
+		out << to_value(_server->get_player_obj(slot).id);
+		write_time(out, _server->get_time());
+		out << serialise(m) << integer_cast<std::uint32_t>(std::size(names));
+		for (const auto& [id, name] : names)
+		{
+			write_id(out, id);
+			out << name;
+		}
+		c.outgoing.emplace_back(std::move(out));
+		LOG("Remote client joined as: " + slot_name);
+		return;
+	}
+
+	void server_host::_handle_input(remote_client& c, sf::Packet& p)
+	{
+		auto level_count = std::uint32_t{};
+		p >> c.echo_time >> level_count;
+		c.echo_pending = true;
+
+		for (auto i = std::uint32_t{}; i < level_count && p; ++i)
+		{
+			const auto id = read_id(p);
+			auto action_count = std::uint32_t{};
+			p >> action_count;
+
+			auto actions = std::vector<action>{};
+			for (auto j = std::uint32_t{}; j < action_count && p; ++j)
+				actions.emplace_back(read_action(p));
+
+			// input is always sent as the clients own player
+			const auto level = std::ranges::find(c.levels, id, &level_connection::id);
+			if (p && level != end(c.levels))
+				level->level->send_request(c.player, std::move(actions));
+		}
+		return;
+	}
+
+	void server_host::_handle_resync(remote_client& c, sf::Packet& p)
+	{
+		const auto id = read_id(p);
+		const auto since = read_time(p);
+		if (!p)
+			return;
+
+		if (id == unique_zero)
+			_server->get_updates(_changes, since);
+		else
+		{
+			const auto level = std::ranges::find(c.levels, id, &level_connection::id);
+			if (level == end(c.levels))
+				_changes.clear();
+			else if (level->view)
+			{
+				// the client will have everything in view after this, so start the interest set again
+				level->interest = {};
+				level->level->get_changes(_changes, since, *level->view, level->interest);
+			}
+			else
+				level->level->get_changes(_changes, since);
+		}
+
+		c.outgoing.emplace_back(make_changes_packet(id, true, _server->get_time(), {}, _changes, _buffer));
+		return;
+	}
+
+	void server_host::_handle_view(remote_client& c, sf::Packet& p)
+	{
+		const auto id = read_id(p);
+		auto view = rect_float{};
+		p >> view.x >> view.y >> view.width >> view.height;
+		if (!p)
+			return;
+
+		const auto level = std::ranges::find(c.levels, id, &level_connection::id);
+		if (level == end(c.levels))
+			return;
+
+		// the client has been sent every object so far, so start the interest set with all of them
+		//	then anything outside the view will be listed as leaving in the next changes
+		//	if the level isn't available yet then nothing has been sent, and the set can start empty
+		const auto level_interface = level->level->is_available() ? level->level->get_interface() : nullptr;
+		if (!level->view && level_interface)
+			level->level->get_changes(_changes, level->since, level_interface->get_world_bounds(), level->interest);
+
+		level->view = view;
+		return;
+	}
+
+	void server_host::_send_changes(remote_client& c)
+	{
+		const auto time = _server->get_time();
+		const auto send = [&](const unique_id id) {
+			if (_changes.empty() && !c.echo_pending)
+				return;
+
+			const auto echo = std::exchange(c.echo_pending, false) ? c.echo_time : std::int64_t{};
+			c.outgoing.emplace_back(make_changes_packet(id, false, time, echo, _changes, _buffer));
+			return;
+		};
+
+		_server->get_updates(_changes, c.mission_since);
+		c.mission_since = time;
+		send(unique_zero);
+
+		for (auto& l : c.levels)
+		{
+			// hold back hibernating levels without moving since, so the client is sent
+			//	everything once the level has been restored
+			if (!l.level->is_available())
+				continue;
+
+			// since is compared against the levels own keyframes, so track it in level time
+			const auto level_time = l.level->get_level_time();
+			if (l.view)
+				l.level->get_changes(_changes, l.since, *l.view, l.interest);
+			else
+				l.level->get_changes(_changes, l.since);
+			l.since = level_time;
+			send(l.id);
+		}
+		return;
+	}
+
+	std::size_t server_host::_flush(remote_client& c)
+	{
+		auto bytes = std::size_t{};
+		while (c.socket && !std::empty(c.outgoing))
+		{
+			// a partly sent packet must be sent again until it's done
+			const auto status = c.socket->send(c.outgoing.front());
+			if (status == sf::Socket::Status::Done)
+			{
+				bytes += packet_size(c.outgoing.front());
+				c.outgoing.pop_front();
+			}
+			else if (status == sf::Socket::Status::NotReady || status == sf::Socket::Status::Partial)
+				break;
+			else
+				_drop(c, "disconnected");
+		}
+
+		return bytes;
+	}
+
+	void server_host::_drop(remote_client& c, std::string_view reason)
+	{
+		LOG("Remote client dropped: " + to_string(reason));
+		c.socket.reset();
+		c.outgoing.clear();
+		return;
+	}
+
+	class remote_server_hub;
+
+	// levels on a remote server don't have a game state on the client
+	//	the client builds its own state from get_changes
+	class remote_server_level final : public server_level
+	{
+	public:
+		remote_server_level(unique_id host_id, remote_server_hub* hub) noexcept
+			: _host_id{ host_id }, _hub{ hub }
+		{}
+
+		void get_changes(exported_curves&, time_point) const override;
+		void get_changes(exported_curves&) const override;
+		void get_changes(exported_curves&, time_point, rect_float, interest_set&) const override;
+		void set_view(rect_float) override;
+		void send_request(unique_id, std::vector<action>) override;
+		time_point get_level_time() const noexcept override;
+
+		// the host holds changes back while a level is hibernating
+		bool is_available() const noexcept override
+		{
+			return true;
+		}
+
+		common_interface* get_interface() noexcept override
+		{
+			return nullptr;
+		}
+
+		game_interface* try_get_game_interface() noexcept override
+		{
+			return nullptr;
+		}
+
+		unique_id host_id() const noexcept
+		{
+			return _host_id;
+		}
+
+		// changes received since the last call to get_changes
+		exported_curves& pending() const noexcept
+		{
+			return _pending;
+		}
+
+	private:
+		unique_id _host_id;
+		remote_server_hub* _hub;
+		mutable exported_curves _pending;
+		std::optional<rect_float> _view;
+	};
+
+	class remote_server_hub final : public server_hub
+	{
+	public:
+		remote_server_hub(std::string_view address, unsigned short port, std::string_view name_slot)
+			: _socket{ std::make_unique<sf::TcpSocket>() },
+			_bytes_received{ console::get_int(cvars::client_net_bytes_received,
+				cvars::default_value::client_net_bytes_received) },
+			_round_trip{ console::get_float(cvars::client_net_round_trip,
+				cvars::default_value::client_net_round_trip) }
+		{
+			const auto ip = sf::IpAddress::resolve(address);
+			if (!ip)
+				throw server_error{ "Unable to resolve server address: " + to_string(address) };
+
+			if (_socket->connect(*ip, port, sf::seconds(connect_timeout)) != sf::Socket::Status::Done)
+				throw server_error{ "Unable to connect to server: " + to_string(address) + ":" + to_string(port) };
+
+			auto p = sf::Packet{};
+			write_message(p, message::hello);
+			p << protocol_version << to_string(name_slot);
+			if (_socket->send(p) != sf::Socket::Status::Done)
+				throw server_error{ "Lost connection while joining server" };
+
+			p.clear();
+			if (_socket->receive(p) != sf::Socket::Status::Done)
+				throw server_error{ "Lost connection while joining server" };
+
+			const auto m = read_message(p);
+			if (m == message::refused)
+			{
+				auto reason = std::string{};
+				p >> reason;
+				throw server_error{ "Server refused connection: " + reason };
+			}
+			else if (m != message::welcome)
+				throw server_error{ "Unexpected reply from server" };
+
+			const auto player = read_id(p);
+			auto player_entity = entity_id::value_type{};
+			auto mission_str = std::string{};
+			auto name_count = std::uint32_t{};
+			_server_time = read_time(p);
+			p >> player_entity >> mission_str >> name_count;
+
+			// match the hosts ids to our own by name
+			for (auto i = std::uint32_t{}; i < name_count && p; ++i)
+			{
+				const auto id = read_id(p);
+				auto name = std::string{};
+				p >> name;
+				if (id == unique_zero)
+					continue;
+
+				const auto local = data::get_uid(name);
+				_from_host.insert_or_assign(id.get(), local);
+				_to_host.insert_or_assign(local, id);
+			}
+
+			if (!p)
+				throw server_error{ "Malformed reply from server" };
+
+			_player = _to_local(player);
+			_player_entity = entity_id{ player_entity };
+			_mission = deserialise_mission(mission_str);
+			_socket->setBlocking(false);
+		}
+
+		// sends the input queued since the last update and reads the latest changes
+		//	the server ticks by itself, so dt is unused
+		void update(time_duration) override
+		{
+			_bytes_this_update = {};
+			_send_input();
+			_pump();
+			_bytes_received->store(integer_clamp_cast<int32>(_bytes_this_update));
+			return;
+		}
+
+		void get_updates(exported_curves& exp, time_point t) const override
+		{
+			_resync(unique_zero, t, exp);
+			return;
+		}
+
+		void get_updates(exported_curves& exp) const override
+		{
+			exp = std::exchange(_mission_pending, {});
+			return;
+		}
+
+		time_point get_time() const noexcept override
+		{
+			return _server_time;
+		}
+
+		// rewinding is only available on the host
+		bool rewind(time_duration) override
+		{
+			return false;
+		}
+
+		// replays are recorded by the host
+		void set_replay_writer(replay_writer*) noexcept override
+		{}
+
+		void set_replay_playback(bool) noexcept override
+		{}
+
+		bool play_hibernation(unique_id, bool) noexcept override
+		{
+			return false;
+		}
+
+		std::uint64_t get_state_hash() const noexcept override
+		{
+			return {};
+		}
+
+		common_interface* get_interface() noexcept override
+		{
+			return nullptr;
+		}
+
+		object_ref get_player_obj(unique_id i) noexcept override
+		{
+			if (i == _player)
+				return object_ref{ _player_entity };
+			return {};
+		}
+
+		mission get_mission() override
+		{
+			return _mission;
+		}
+
+		server_level* connect_to_level(unique_id id) override
+		{
+			const auto host_id = _to_host.find(id);
+			if (host_id == end(_to_host))
+				return nullptr;
+
+			for (auto& l : _levels)
+			{
+				if (l.host_id() == host_id->second)
+					return &l;
+			}
+
+			auto p = sf::Packet{};
+			write_message(p, message::connect_level);
+			write_id(p, host_id->second);
+			_outgoing.emplace_back(std::move(p));
+			return &_levels.emplace_back(host_id->second, this);
+		}
+
+		void disconnect_from_level() override
+		{
+			auto p = sf::Packet{};
+			write_message(p, message::disconnect_level);
+			_outgoing.emplace_back(std::move(p));
+			_levels.clear();
+			_input.clear();
+			return;
+		}
+
+		void queue_input(const unique_id level, const std::vector<action>& actions)
+		{
+			auto batch = std::ranges::find(_input, level, &input_batch::level);
+			if (batch == end(_input))
+				batch = _input.emplace(end(_input), input_batch{ level, {} });
+
+			for (const auto& a : actions)
+			{
+				// actions the host doesn't know about are dropped
+				const auto id = _to_host.find(a.id);
+				if (id != end(_to_host))
+					batch->actions.emplace_back(a, id->second.get());
+			}
+			return;
+		}
+
+		void send_view(const remote_server_level& l, const rect_float view)
+		{
+			auto p = sf::Packet{};
+			write_message(p, message::view);
+			write_id(p, l.host_id());
+			p << view.x << view.y << view.width << view.height;
+			_outgoing.emplace_back(std::move(p));
+			return;
+		}
+
+		void resync(const remote_server_level& l, time_point t, exported_curves& exp) const
+		{
+			_resync(l.host_id(), t, exp);
+			return;
+		}
+
+	private:
+		struct input_batch
+		{
+			unique_id level = unique_zero;
+			// actions with the hosts id
+			std::vector<std::pair<action, unique_id::type>> actions;
+		};
+
+		void _send_input()
+		{
+			if (std::empty(_input))
+				return;
+
+			auto p = sf::Packet{};
+			write_message(p, message::input);
+			p << clock_now() << integer_cast<std::uint32_t>(std::size(_input));
+			for (const auto& batch : _input)
+			{
+				write_id(p, batch.level);
+				p << integer_cast<std::uint32_t>(std::size(batch.actions));
+				for (const auto& [a, id] : batch.actions)
+					write_action(p, a, id);
+			}
+
+			_outgoing.emplace_back(std::move(p));
+			_input.clear();
+			return;
+		}
+
+		// sends what we can and reads everything that has arrived
+		void _pump() const
+		{
+			while (!std::empty(_outgoing))
+			{
+				const auto status = _socket->send(_outgoing.front());
+				if (status == sf::Socket::Status::Done)
+					_outgoing.pop_front();
+				else if (status == sf::Socket::Status::NotReady || status == sf::Socket::Status::Partial)
+					break;
+				else
+					throw server_error{ "Lost connection to server" };
+			}
+
+			auto p = sf::Packet{};
+			while (true)
+			{
+				const auto status = _socket->receive(p);
+				if (status == sf::Socket::Status::NotReady || status == sf::Socket::Status::Partial)
+					return;
+				else if (status != sf::Socket::Status::Done)
+					throw server_error{ "Lost connection to server" };
+
+				_bytes_this_update += packet_size(p);
+				_handle_changes(p);
+				p.clear();
+			}
+		}
+
+		void _handle_changes(sf::Packet& p) const
+		{
+			if (read_message(p) != message::changes)
+				throw server_error{ "Unexpected message from server" };
+
+			const auto level = read_id(p);
+			auto resync = false;
+			auto echo = std::int64_t{};
+			p >> resync;
+			const auto server_time = read_time(p);
+			p >> echo;
+
+			auto changes = exported_curves{};
+			read_changes(p, changes);
+			for_each_unique_id(changes, [this](unique_id& id) {
+				id = _to_local(id);
+				return;
+				});
+
+			_server_time = std::max(_server_time, server_time);
+			if (echo != std::int64_t{})
+			{
+				const auto round_trip = time_duration{ clock_now() - echo };
+				_round_trip->store(std::chrono::duration_cast<milliseconds_float>(round_trip).count());
+			}
+
+			if (resync)
+			{
+				_resync_result = std::move(changes);
+				return;
+			}
+
+			if (level == unique_zero)
+			{
+				append_changes(_mission_pending, std::move(changes));
+				return;
+			}
+
+			const auto target = std::ranges::find(_levels, level, &remote_server_level::host_id);
+			// otherwise these are changes for a level we've disconnected from
+			if (target != end(_levels))
+				append_changes(target->pending(), std::move(changes));
+			return;
+		}
+
+		// asks the host for every change since t, and waits for the reply
+		void _resync(const unique_id level, const time_point t, exported_curves& exp) const
+		{
+			auto p = sf::Packet{};
+			write_message(p, message::resync);
+			write_id(p, level);
+			write_time(p, t);
+			_outgoing.emplace_back(std::move(p));
+
+			_resync_result.reset();
+			const auto timeout = time_clock::now() + resync_timeout;
+			while (!_resync_result)
+			{
+				_pump();
+				if (_resync_result)
+					break;
+				if (time_clock::now() > timeout)
+					throw server_error{ "Timed out waiting for server" };
+				std::this_thread::sleep_for(milliseconds{ 1 });
+			}
+
+			exp = std::move(*_resync_result);
+			_resync_result.reset();
+			return;
+		}
+
+		unique_id _to_local(const unique_id host_id) const
+		{
+			if (host_id == unique_zero)
+				return unique_zero;
+
+			const auto iter = _from_host.find(host_id.get());
+			if (iter != end(_from_host))
+				return iter->second;
+
+			// ids created after we joined, or ids without names
+			LOGWARNING("Received unknown unique_id from server: " + std::to_string(host_id.get()));
+			_from_host.emplace(host_id.get(), unique_zero);
+			return unique_zero;
+		}
+
+		std::unique_ptr<sf::TcpSocket> _socket;
+		mutable std::deque<sf::Packet> _outgoing;
+		std::vector<input_batch> _input;
+
+		// the host's ids aren't valid in this process, so they are only used for lookups
+		mutable std::unordered_map<unique_id::type, unique_id> _from_host;
+		std::unordered_map<unique_id, unique_id> _to_host;
+
+		unique_id _player = unique_zero;
+		entity_id _player_entity = bad_entity;
+		mission _mission;
+		mutable time_point _server_time;
+		mutable exported_curves _mission_pending;
+		mutable std::optional<exported_curves> _resync_result;
+		//NOTE: deque, need constant addresses
+		std::deque<remote_server_level> _levels;
+
+		mutable std::size_t _bytes_this_update = {};
+		console::property_int _bytes_received;
+		console::property_float _round_trip;
+	};
+
+	void remote_server_level::get_changes(exported_curves& exp, time_point t) const
+	{
+		_hub->resync(*this, t, exp);
+		return;
+	}
+
+	void remote_server_level::get_changes(exported_curves& exp) const
+	{
+		exp = std::exchange(_pending, {});
+		return;
+	}
+
+	void remote_server_level::get_changes(exported_curves& exp, time_point t, rect_float, interest_set&) const
+	{
+		// the host has already limited the changes to our view, see: set_view
+		get_changes(exp, t);
+		return;
+	}
+
+	time_point remote_server_level::get_level_time() const noexcept
+	{
+		// the host only sends mission time
+		return _hub->get_time();
+	}
+
+	void remote_server_level::set_view(const rect_float view)
+	{
+		// clients will usually set the view every frame, only send it when it moves
+		if (_view == view)
+			return;
+
+		_view = view;
+		_hub->send_view(*this, view);
+		return;
+	}
+
+	void remote_server_level::send_request(unique_id, std::vector<action> a)
+	{
+		// the host always uses the player we joined as
+		_hub->queue_input(_host_id, a);
+		return;
+	}
+
+	server_ptr connect_to_server(std::string_view address, unsigned short port, std::string_view name_slot)
+	{
+		return std::make_unique<remote_server_hub>(address, port, name_slot);
+	}
+}
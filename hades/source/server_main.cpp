@@ -0,0 +1,635 @@
+#include "hades/server_main.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "hades/async.hpp"
+#include "hades/Console.hpp"
+#include "hades/console_variables.hpp"
+#include "hades/core_resources.hpp"
+#include "hades/data_system.hpp"
+#include "hades/export_curves.hpp"
+#include "hades/files.hpp"
+#include "hades/logging.hpp"
+#include "hades/mission.hpp"
+#include "hades/properties.hpp"
+#include "hades/remote_server.hpp"
+#include "hades/replay.hpp"
+#include "hades/Server.hpp"
+#include "hades/simple_resources.hpp"
+#include "hades/yaml_parser.hpp"
+#include "hades/yaml_writer.hpp"
+
+using namespace std::string_literals;
+using namespace std::string_view_literals;
+
+namespace hades
+{
+	static void try_write_server_log()
+	{
+		if (console::is_logging())
+		{
+			console::dump_log();
+			console::stop_log();
+		}
+		return;
+	}
+
+	static command_list make_command_list(int argc, char* argv[])
+	{
+		//new commands start with a '-'.
+		constexpr auto command_delimiter = '-';
+
+		const auto cmdline = std::vector<std::string_view>{ argv, argv + argc };
+
+		auto commands = command_list{};
+		auto index = -1;
+
+		for (const auto s : cmdline)
+		{
+			if (!std::empty(s) && s[0] == command_delimiter)
+			{
+				const auto s2 = s.substr(1, s.size());
+				commands.emplace_back(s2);
+				index++;
+			}
+			else if (index != -1)
+				commands[index].arguments.push_back(s);
+		}
+
+		return commands;
+	}
+
+	// tick times for the last reporting period
+	struct server_tick_stats
+	{
+		std::size_t ticks = {};
+		std::size_t overruns = {};
+		time_duration total = time_duration::zero();
+		time_duration min = time_duration::max();
+		time_duration max = time_duration::zero();
+		time_point start = time_clock::now();
+	};
+
+	static float to_millis(time_duration d) noexcept
+	{
+		return std::chrono::duration_cast<milliseconds_float>(d).count();
+	}
+
+	static void report_tick_stats(const server_tick_stats& stats, time_duration dt, bool fast,
+		console::basic_property<float>& avg, console::basic_property<float>& max, console::basic_property<float>& min)
+	{
+		if (stats.ticks == 0)
+			return;
+
+		const auto avg_f = to_millis(stats.total / stats.ticks);
+		const auto max_f = to_millis(stats.max);
+		const auto min_f = to_millis(stats.min);
+		avg.store(avg_f);
+		max.store(max_f);
+		min.store(min_f);
+
+		auto msg = "ticks: "s + std::to_string(stats.ticks)
+			+ ", avg: "s + std::to_string(avg_f)
+			+ "ms, min: "s + std::to_string(min_f)
+			+ "ms, max: "s + std::to_string(max_f) + "ms"s;
+
+		if (fast)
+		{
+			// throughput as a multiple of real time
+			const auto wall_time = time_clock::now() - stats.start;
+			const auto game_time = dt * stats.ticks;
+			const auto speed = wall_time == time_duration::zero() ? 0.f :
+				to_millis(game_time) / to_millis(wall_time);
+			msg += ", speed: "s + std::to_string(speed) + "x"s;
+		}
+		else
+			msg += ", overruns: "s + std::to_string(stats.overruns);
+
+		log(std::move(msg));
+		return;
+	}
+
+	static std::size_t run_server(server_hub& server, server_host* host, std::optional<std::size_t> tick_limit, bool fast)
+	{
+		const auto tick_rate = console::get_int(cvars::server_tick_rate, cvars::default_value::server_tick_rate);
+		auto avg_tick_time = console::get_float(cvars::server_avg_tick_time, cvars::default_value::server_avg_tick_time);
+		auto max_tick_time = console::get_float(cvars::server_max_tick_time, cvars::default_value::server_max_tick_time);
+		auto min_tick_time = console::get_float(cvars::server_min_tick_time, cvars::default_value::server_min_tick_time);
+
+		auto stats = server_tick_stats{};
+		auto total_ticks = std::size_t{};
+		auto next_tick = time_clock::now();
+
+		while (!tick_limit || total_ticks < *tick_limit)
+		{
+			// read the rate every tick so that it can be changed from the console
+			const auto rate = std::max(tick_rate->load(), 1);
+			const auto dt = time_duration{ seconds{ 1 } } / rate;
+
+			if (!fast)
+				std::this_thread::sleep_until(next_tick);
+
+			const auto start = time_clock::now();
+			server.update(dt);
+			if (host)
+				host->update();
+			const auto end = time_clock::now();
+			const auto tick_time = end - start;
+
+			++total_ticks;
+			++stats.ticks;
+			stats.total += tick_time;
+			stats.min = std::min(stats.min, tick_time);
+			stats.max = std::max(stats.max, tick_time);
+
+			if (!fast)
+			{
+				next_tick += dt;
+				// if we've fallen behind then start counting from now
+				//	rather than trying to catch up with a burst of ticks
+				if (next_tick < end)
+				{
+					++stats.overruns;
+					next_tick = end;
+				}
+			}
+
+			// report once for every second of game time
+			if (stats.ticks >= integer_cast<std::size_t>(rate))
+			{
+				report_tick_stats(stats, dt, fast, *avg_tick_time, *max_tick_time, *min_tick_time);
+				stats = server_tick_stats{};
+			}
+		}
+
+		const auto dt = time_duration{ seconds{ 1 } } / std::max(tick_rate->load(), 1);
+		report_tick_stats(stats, dt, fast, *avg_tick_time, *max_tick_time, *min_tick_time);
+		return total_ticks;
+	}
+
+	// feeds the recorded levels and input back into the server, checking the state hash after every tick
+	//	returns false if the state differs from the recording
+	static bool play_replay(server_hub& server, replay_reader& reader)
+	{
+		auto record = replay_record{};
+		auto ticks = std::size_t{};
+		const auto start = time_clock::now();
+		const auto start_time = server.get_time();
+		server.set_replay_playback(true);
+
+		while (reader.read(record))
+		{
+			if (const auto lvl = std::get_if<replay_level>(&record))
+			{
+				if (!server.connect_to_level(lvl->level))
+				{
+					LOGERROR("replay creates a level that isn't in the mission: " + to_string(lvl->level));
+					return false;
+				}
+			}
+			else if (const auto input = std::get_if<replay_input>(&record))
+			{
+				const auto level = server.connect_to_level(input->level);
+				if (!level)
+				{
+					LOGERROR("replay sends input to a level that isn't in the mission: " + to_string(input->level));
+					return false;
+				}
+
+				level->send_request(input->player, std::move(input->actions));
+			}
+			else if (const auto hibernation = std::get_if<replay_hibernation>(&record))
+			{
+				if (!server.play_hibernation(hibernation->level, hibernation->hibernating))
+				{
+					LOGERROR("replay hibernates a level that isn't in the mission: " + to_string(hibernation->level));
+					return false;
+				}
+			}
+			else
+			{
+				const auto& tick = std::get<replay_tick>(record);
+				server.update(tick.time - server.get_time());
+				++ticks;
+
+				if (server.get_state_hash() != tick.hash)
+				{
+					LOGERROR("replay diverged on tick " + std::to_string(ticks) + ", mission time: "
+						+ to_string(tick.time.time_since_epoch()));
+					return false;
+				}
+			}
+		}
+
+		const auto wall_time = time_clock::now() - start;
+		const auto game_time = server.get_time() - start_time;
+		const auto speed = wall_time == time_duration::zero() ? 0.f :
+			to_millis(game_time) / to_millis(wall_time);
+		LOG("replay finished after " + std::to_string(ticks) + " ticks, mission time: "
+			+ to_string(server.get_time().time_since_epoch()) + ", wall time: " + to_string(wall_time)
+			+ ", speed: " + std::to_string(speed) + "x");
+		return true;
+	}
+
+	// the state a loopback client builds from the changes it receives
+	struct loopback_client
+	{
+		std::atomic_bool joined = false;
+		std::atomic_bool stop = false;
+		// set if the client couldn't join or failed while running
+		string error;
+		entity_id player_entity = bad_entity;
+		game_state state;
+		extra_state<game_system> extras;
+		std::size_t updates = {};
+		std::size_t bytes_received = {};
+		std::size_t round_trips = {};
+		float round_trip_total = {};
+		float round_trip_max = {};
+	};
+
+	static unique_id first_level(const mission& m) noexcept
+	{
+		if (!std::empty(m.inline_levels))
+			return m.inline_levels.front().name;
+		if (!std::empty(m.external_levels))
+			return m.external_levels.front().name;
+		return unique_zero;
+	}
+
+	// joins the host through 127.0.0.1 the same way a remote process would
+	//	sends input every update, and applies the changes it receives to its own copy of the level
+	static void run_loopback_client(loopback_client& c, const unsigned short port, const string slot,
+		const unique_id input_action, const time_duration dt)
+	{
+		try
+		{
+			auto client = connect_to_server("127.0.0.1"sv, port, slot);
+			const auto slot_id = data::find_uid(slot);
+			c.player_entity = client->get_player_obj(slot_id).id;
+			c.joined = true;
+
+			const auto level = client->connect_to_level(first_level(client->get_mission()));
+			if (!level)
+				throw server_error{ "loopback client couldn't connect to the missions first level" };
+
+			auto round_trip = console::get_float(cvars::client_net_round_trip, cvars::default_value::client_net_round_trip);
+			auto bytes_received = console::get_int(cvars::client_net_bytes_received, cvars::default_value::client_net_bytes_received);
+			auto changes = exported_curves{};
+			auto x = int32{};
+			while (!c.stop)
+			{
+				level->send_request(slot_id, { action{ input_action, ++x } });
+				// the round trip cvar only changes when the host echoes our input back
+				round_trip->store(0.f);
+				client->update(dt);
+				level->get_changes(changes);
+				state_api::apply_changes(changes, c.state, c.extras);
+
+				++c.updates;
+				c.bytes_received += integer_cast<std::size_t>(std::max(bytes_received->load(), 0));
+				if (const auto rt = round_trip->load(); rt > 0.f)
+				{
+					++c.round_trips;
+					c.round_trip_total += rt;
+					c.round_trip_max = std::max(c.round_trip_max, rt);
+				}
+
+				std::this_thread::sleep_for(dt);
+			}
+		}
+		catch (const std::exception& e)
+		{
+			c.error = e.what();
+		}
+
+		c.joined = true;
+		return;
+	}
+
+	// runs the server with a server_host and a client on another thread connected through it
+	//	checks that the client joined as the right player, that its input reached the host,
+	//	and that the objects it built from the changes exist on the host
+	//	then logs the bandwidth and round trip, returns false if a check failed
+	static bool run_loopback(server_hub& server, const unsigned short port, const string& slot, const std::size_t ticks)
+	{
+		const auto tick_rate = console::get_int(cvars::server_tick_rate, cvars::default_value::server_tick_rate);
+		const auto dt = time_duration{ seconds{ 1 } } / std::max(tick_rate->load(), 1);
+		auto bytes_sent = console::get_int(cvars::server_net_bytes_sent, cvars::default_value::server_net_bytes_sent);
+
+		auto host = server_host{ server, port };
+		// give the action a name before the client joins, so it's in the id table the client is sent
+		const auto input_action = data::get_uid("loopback-input"sv);
+		const auto expected_player = server.get_player_obj(data::find_uid(slot)).id;
+
+		auto client = loopback_client{};
+		auto client_thread = std::thread{ run_loopback_client, std::ref(client), port, slot, input_action, dt };
+
+		// the client blocks while joining, so keep the host accepting until it's in
+		const auto join_timeout = time_clock::now() + seconds{ 10 };
+		while (!client.joined && time_clock::now() < join_timeout)
+		{
+			host.update();
+			std::this_thread::sleep_for(milliseconds{ 1 });
+		}
+
+		auto total_sent = std::size_t{};
+		const auto start = time_clock::now();
+		auto next_tick = start;
+		for (auto i = std::size_t{}; client.joined && i < ticks; ++i)
+		{
+			std::this_thread::sleep_until(next_tick);
+			next_tick += dt;
+			server.update(dt);
+			host.update();
+			total_sent += integer_cast<std::size_t>(std::max(bytes_sent->load(), 0));
+		}
+		const auto wall_time = time_clock::now() - start;
+
+		client.stop = true;
+		client_thread.join();
+
+		auto ok = true;
+		const auto fail = [&ok](string msg) {
+			LOGERROR("loopback: " + msg);
+			ok = false;
+			return;
+		};
+
+		if (!std::empty(client.error))
+			fail(client.error);
+		if (client.player_entity != expected_player)
+			fail("client joined with the wrong player object, ids weren't synced");
+		if (client.round_trips == 0)
+			fail("the host never echoed the clients input");
+
+		const auto level = server.connect_to_level(first_level(server.get_mission()));
+		const auto host_state = level ? level->get_interface() : nullptr;
+		if (!host_state)
+			fail("the first level isn't available on the host");
+		else
+		{
+			const auto& host_objects = host_state->get_state().object_creation_time;
+			if (client.extras.objects.size() == 0 && host_objects.size() != 0)
+				fail("the client didn't receive any objects");
+			for (const auto& o : client.extras.objects)
+			{
+				if (!host_objects.contains(o.id))
+					fail("the client has an object the host never created: " + to_string(o.id));
+			}
+		}
+
+		const auto seconds_run = std::max(std::chrono::duration_cast<seconds_float>(wall_time).count(), 0.001f);
+		const auto round_trip_avg = client.round_trips == 0 ? 0.f :
+			client.round_trip_total / static_cast<float>(client.round_trips);
+		LOG("loopback: " + std::to_string(ticks) + " ticks, " + std::to_string(client.extras.objects.size())
+			+ " objects on the client, sent: " + std::to_string(static_cast<float>(total_sent) / 1024.f / seconds_run)
+			+ "KiB/s, received: " + std::to_string(static_cast<float>(client.bytes_received) / 1024.f / seconds_run)
+			+ "KiB/s, round trip avg: " + std::to_string(round_trip_avg) + "ms, max: "
+			+ std::to_string(client.round_trip_max) + "ms");
+		return ok;
+	}
+
+	int hades_server_main(int argc, char* argv[], std::string_view game,
+		register_resource_types_fn resource_fn)
+	{
+		std::ios_base::sync_with_stdio(false);
+
+		auto commands = make_command_list(argc, argv);
+
+		auto server_console = Console{};
+		auto data_man = data::data_system{};
+		auto pool = thread_pool{};
+
+		//record the console as logger, property provider and command line
+		console::log = &server_console;
+		console::set_property_provider(&server_console);
+		console::system_object = &server_console;
+		detail::set_shared_thread_pool(&pool);
+
+		create_core_console_variables();
+		server_console.set(cvars::game_name, game);
+
+		register_core_resources(data_man);
+		RegisterCommonResources(data_man);
+		data::detail::set_data_manager_ptr(&data_man);
+
+		data::set_default_parser(data::make_parser_f{ data::make_yaml_parser });
+		data::set_default_parser(data::make_parser2_f{ data::make_yaml_parser });
+		data::set_parser(data::make_parser_f{ data::make_yaml_parser }, ".yaml");
+		data::set_parser(data::make_parser2_f{ data::make_yaml_parser }, ".yaml");
+		data::set_default_writer(data::make_writer_f{ data::make_yaml_writer });
+
+		register_game_server_resources(data_man);
+		if (resource_fn)
+			std::invoke(resource_fn, data_man);
+
+		try
+		{
+			const auto load_game = [&data_man](const argument_list& command) {
+				if (command.size() != 1)
+				{
+					LOGERROR("game command expects a single argument"sv);
+					return false;
+				}
+
+				data_man.load_game(to_string(command.front()));
+				return true;
+			};
+
+			const auto game_str = server_console.getString(cvars::game_name)->load();
+			if (!handle_command(commands, "game"sv, load_game))
+			{
+				if (game_str.empty())
+					throw logic_error{ "Failed to provide a game name" };
+				std::invoke(load_game, argument_list{ game_str });
+			}
+
+			handle_command(commands, "mod"sv, [&data_man](const argument_list& command) {
+				if (command.size() != 1)
+				{
+					LOGERROR("mod command expects a single argument"sv);
+					return false;
+				}
+
+				data_man.add_mod("./"s + to_string(command.front()));
+				return true;
+				});
+
+			data_man.update_all_links();
+
+			auto mission_path = std::optional<string>{};
+			handle_command(commands, "mission"sv, [&mission_path](const argument_list& command) {
+				if (command.size() != 1)
+				{
+					LOGERROR("mission command expects a single argument"sv);
+					return false;
+				}
+
+				mission_path = to_string(command.front());
+				return true;
+				});
+
+			auto slot_name = std::optional<string>{};
+			handle_command(commands, "slot"sv, [&slot_name](const argument_list& command) {
+				if (command.size() != 1)
+				{
+					LOGERROR("slot command expects a single argument"sv);
+					return false;
+				}
+
+				slot_name = to_string(command.front());
+				return true;
+				});
+
+			auto tick_limit = std::optional<std::size_t>{};
+			handle_command(commands, "ticks"sv, [&tick_limit](const argument_list& command) {
+				if (command.size() != 1)
+				{
+					LOGERROR("ticks command expects a single argument"sv);
+					return false;
+				}
+
+				tick_limit = from_string<std::size_t>(command.front());
+				return true;
+				});
+
+			auto listen_port = std::optional<unsigned short>{};
+			handle_command(commands, "listen"sv, [&listen_port](const argument_list& command) {
+				if (command.size() > 1)
+				{
+					LOGERROR("listen command expects a port or no arguments"sv);
+					return false;
+				}
+
+				listen_port = command.empty() ?
+					integer_cast<unsigned short>(console::get_int(cvars::server_port, cvars::default_value::server_port)->load())
+					: from_string<unsigned short>(command.front());
+				return true;
+				});
+
+			auto record_path = std::optional<string>{};
+			handle_command(commands, "record"sv, [&record_path](const argument_list& command) {
+				if (command.size() != 1)
+				{
+					LOGERROR("record command expects a single argument"sv);
+					return false;
+				}
+
+				record_path = to_string(command.front());
+				return true;
+				});
+
+			auto replay_path = std::optional<string>{};
+			handle_command(commands, "replay"sv, [&replay_path](const argument_list& command) {
+				if (command.size() != 1)
+				{
+					LOGERROR("replay command expects a single argument"sv);
+					return false;
+				}
+
+				replay_path = to_string(command.front());
+				return true;
+				});
+
+			auto fast = false;
+			handle_command(commands, "fast"sv, [&fast](const argument_list&) {
+				fast = true;
+				return true;
+				});
+
+			auto loopback = false;
+			handle_command(commands, "loopback"sv, [&loopback](const argument_list&) {
+				loopback = true;
+				return true;
+				});
+
+			//pass anything else to the console, so that cvars can be set
+			for (auto& c : commands)
+				server_console.run_command(c);
+
+			if (replay_path)
+			{
+				// the replay contains the mission and player slot it was recorded with
+				auto reader = replay_reader{ *replay_path };
+				auto server = create_server(make_save_from_mission(deserialise_mission(reader.mission())), reader.player_slot());
+				LOG("replaying: " + *replay_path);
+				const auto result = play_replay(*server, reader);
+				try_write_server_log();
+				return result ? EXIT_SUCCESS : EXIT_FAILURE;
+			}
+
+			if (!mission_path)
+			{
+				LOGERROR("a mission must be provided with -mission <path>"sv);
+				try_write_server_log();
+				return EXIT_FAILURE;
+			}
+
+			const auto mission_source = files::read_file(*mission_path);
+			auto m = deserialise_mission(mission_source);
+			if (!slot_name && std::empty(m.players))
+			{
+				LOGERROR("mission has no player slots: " + *mission_path);
+				try_write_server_log();
+				return EXIT_FAILURE;
+			}
+
+			const auto first_slot = slot_name ? unique_zero : m.players.front().id;
+			auto server = slot_name ? create_server(make_save_from_mission(std::move(m)), *slot_name)
+				: create_server(make_save_from_mission(std::move(m)), first_slot);
+
+			auto replay = std::optional<replay_writer>{};
+			if (record_path)
+			{
+				replay.emplace(*record_path, mission_source, slot_name ? *slot_name : data::get_as_string(first_slot));
+				server->set_replay_writer(&*replay);
+			}
+
+			if (loopback)
+			{
+				const auto port = listen_port ? *listen_port :
+					integer_cast<unsigned short>(console::get_int(cvars::server_port, cvars::default_value::server_port)->load());
+				const auto result = run_loopback(*server, port, slot_name ? *slot_name : data::get_as_string(first_slot),
+					tick_limit.value_or(300));
+				try_write_server_log();
+				return result ? EXIT_SUCCESS : EXIT_FAILURE;
+			}
+
+			auto host = std::optional<server_host>{};
+			if (listen_port)
+				host.emplace(*server, *listen_port);
+
+			LOG("server started: " + *mission_path);
+			const auto start = time_clock::now();
+			const auto ticks = run_server(*server, host ? &*host : nullptr, tick_limit, fast);
+			const auto wall_time = time_clock::now() - start;
+
+			LOG("server stopped after " + std::to_string(ticks) + " ticks, mission time: "
+				+ to_string(server->get_time().time_since_epoch()) + ", wall time: " + to_string(wall_time));
+		}
+		catch (const std::exception& e)
+		{
+			log_error("Unhandled exception"sv);
+			log_error(e.what());
+			try_write_server_log();
+			throw;
+		}
+		catch (...)
+		{
+			log_error("Unexpected exception"sv);
+			try_write_server_log();
+			throw;
+		}
+
+		try_write_server_log();
+		return EXIT_SUCCESS;
+	}
+}
@@ -33,6 +33,27 @@ namespace hades
 		//server vars
 		constexpr auto server_threadcount = "s_threads"; // [[deprecated]] number of threads to use in the game server
 														// -1 = auto, 0/1 = no threading, otherwise the number of threads to use
+		constexpr auto server_parallel_levels = "s_parallel_levels"; // if true, levels are ticked at the same time on the thread pool
+		constexpr auto server_archetype_storage = "s_archetype_storage"; // if true, new levels store object curves grouped by object type
+		constexpr auto server_curve_compaction = "s_curve_compaction"; // if true, old curve keyframes are removed from levels on the thread pool
+		constexpr auto server_curve_history = "s_curve_history"; // seconds of curve history to keep, for curves that don't set their own; 0 = keep everything
+		constexpr auto server_curve_compaction_interval = "s_curve_compaction_interval"; // seconds of level time between compacting a levels curves
+		constexpr auto server_frame_arena_overflow = "s_frame_arena_overflow"; // reports the number of allocations during the last update that didn't fit in the levels frame arenas
+		constexpr auto server_update_allocations = "s_update_allocations"; // reports the number of heap allocations made while updating the levels during the last update, this should be zero once they have warmed up, requires building with HADES_COUNT_ALLOCATIONS
+		constexpr auto server_cold_storage = "s_cold_storage"; // if true, destroyed objects are compressed into cold storage rather than discarded
+		constexpr auto server_cold_storage_spill = "s_cold_storage_spill"; // if true, new levels write their cold storage to a temp file
+		constexpr auto server_snapshot_history = "s_snapshot_history"; // seconds of level snapshots to keep for server_hub::rewind; 0 = no snapshots; levels that keep snapshots also record dirty curves(as s_dirty_tracking)
+		constexpr auto server_dirty_tracking = "s_dirty_tracking"; // if true, new levels record which curves were written to each tick
+		constexpr auto server_tick_rate = "s_tickrate"; // number of ticks per second for the dedicated server
+		constexpr auto server_avg_tick_time = "s_avg_tick_time"; // reports the average tick time of the dedicated server over the last second in ms
+		constexpr auto server_max_tick_time = "s_max_tick_time"; // reports the longest tick time of the dedicated server over the last second in ms
+		constexpr auto server_min_tick_time = "s_min_tick_time"; // reports the shortest tick time of the dedicated server over the last second in ms
+		constexpr auto server_port = "s_port"; // port that server_host listens on for remote clients
+		constexpr auto server_net_bytes_sent = "s_net_bytes_sent"; // reports the number of bytes sent to remote clients during the last server_host update
+		constexpr auto server_interest_management = "s_interest_management"; // if true, new levels only send remote clients the objects near their view
+		constexpr auto server_interest_cell_size = "s_interest_cell_size"; // size of the cells in the interest grid, in world units
+		constexpr auto server_hibernate_after = "s_hibernate_after"; // seconds a level can go unused before it is compressed and unloaded; 0 = never
+		constexpr auto server_hibernated_levels = "s_hibernated_levels"; // reports the number of levels that are currently hibernating
 		//client vars
 		constexpr auto client_tick_rate = "c_tickrate"; //number of ticks to calculate per second
 		constexpr auto client_avg_tick_time = "c_avg_tick_time"; // reports the average tick time of the frame in ms
@@ -43,6 +64,8 @@ namespace hades
 		constexpr auto client_previous_frametime = "c_previous_frametime"; // reports time taken to generate the last frame
 		constexpr auto client_average_frametime = "c_average_frametime"; // reports time taken to generate the last frame
 		constexpr auto client_tick_count = "c_ticks_per_frame"; // reports number of ticks taken to generate the previous frame
+		constexpr auto client_net_bytes_received = "c_net_bytes_received"; // reports the number of bytes received from a remote server during the last update
+		constexpr auto client_net_round_trip = "c_net_round_trip"; // reports the time between sending input to a remote server and receiving the reply in ms
 		constexpr auto client_log_to_file = "c_log_to_file_enabled"; // reports if file logging is enabled (see: c_log_to_file)
 
 		// mod vars
@@ -74,6 +97,27 @@ namespace hades
 			constexpr auto render_drawtime = 0.f;
 
 			constexpr auto server_threadcount = 0; // deprecated
+			constexpr auto server_parallel_levels = false;
+			constexpr auto server_archetype_storage = false;
+			constexpr auto server_curve_compaction = false;
+			constexpr auto server_curve_history = 30.f;
+			constexpr auto server_curve_compaction_interval = 5.f;
+			constexpr auto server_frame_arena_overflow = 0;
+			constexpr auto server_update_allocations = 0;
+			constexpr auto server_cold_storage = false;
+			constexpr auto server_cold_storage_spill = false;
+			constexpr auto server_snapshot_history = 0.f;
+			constexpr auto server_dirty_tracking = false;
+			constexpr auto server_tick_rate = 30;
+			constexpr auto server_avg_tick_time = 0.f;
+			constexpr auto server_max_tick_time = 0.f;
+			constexpr auto server_min_tick_time = 0.f;
+			constexpr auto server_port = 34500;
+			constexpr auto server_net_bytes_sent = 0;
+			constexpr auto server_interest_management = false;
+			constexpr auto server_interest_cell_size = 256.f;
+			constexpr auto server_hibernate_after = 0.f;
+			constexpr auto server_hibernated_levels = 0;
 
 			constexpr auto client_tickrate = 30;
 			constexpr auto client_avg_tick_time = 0.f;
@@ -84,6 +128,8 @@ namespace hades
 			constexpr auto client_previous_frametime = -1.f; 
 			constexpr auto client_average_frametime = -1.f;
 			constexpr auto client_tick_count = 0;
+			constexpr auto client_net_bytes_received = 0;
+			constexpr auto client_net_round_trip = 0.f;
 #ifdef NDEBUG
 			constexpr auto client_log_to_file = false;
 #else
@@ -45,6 +45,9 @@ namespace hades::resources
 		};
 		template<typename T>
 		using curve_default_value_t = typename curve_default_value_type<T>::type;
+
+		// returns a new key for each call
+		std::size_t make_curve_key() noexcept;
 	}
 
 	using curve_default_value = detail::curve_default_value_t<curve_types::type_pack>;
@@ -53,6 +56,20 @@ namespace hades::resources
 
 	struct curve_t {};
 
+	// controls how much of a curves history is kept in the game state
+	//	see: state_api::compact_curves
+	struct curve_retention
+	{
+		// length of history to keep, zero uses the s_curve_history cvar
+		time_duration history = time_duration::zero();
+		// maximum number of keyframes to keep, zero for no limit
+		std::size_t keyframe_limit = 0;
+		// remove keyframes that don't change the curves value
+		// on step curves, keyframes equal to their neighbours
+		// on linear curves, keyframes on the line between their neighbours
+		bool collapse = false;
+	};
+
 	struct curve : public resource_type<curve_t>
 	{
 		void serialise(const data::data_manager&, data::writer&) const final override;
@@ -64,6 +81,10 @@ namespace hades::resources
 		bool hidden = false; // don't show the curve in level editor
 		
 		curve_default_value default_value{};
+		curve_retention retention;
+		// unique small integer for each curve
+		//	used to index object variable layouts, see resources::object
+		std::size_t key = detail::make_curve_key();
 	};
 
 	[[nodiscard]] curve_default_value reset_default_value(const curve &c);
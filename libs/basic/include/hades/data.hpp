@@ -362,6 +362,12 @@ namespace hades
 				return get_uid_impl(name);
 			}
 
+			// every name that has been given an id, used to match up ids with another process
+			std::vector<std::pair<unique_id, string>> get_all_names() const
+			{
+				return get_all_names_impl();
+			}
+
 		protected:
 			// called by register_resource_type
 			virtual void register_type(std::string_view name, resources::parser_func parser) = 0;
@@ -376,6 +382,7 @@ namespace hades
 			virtual const string& get_as_string_impl(unique_id id) const noexcept = 0;
 			virtual unique_id get_uid_impl(std::string_view name) const = 0;
 			virtual unique_id get_uid_impl(std::string_view name) = 0;
+			virtual std::vector<std::pair<unique_id, string>> get_all_names_impl() const = 0;
 
 			virtual const std::filesystem::path& _current_data_file() const noexcept = 0;
 
@@ -429,6 +436,11 @@ namespace hades
 		const string& get_as_string(unique_id id);
 		//returns UniqueId::zero if the name cannot be assiciated with an id
 		unique_id get_uid(std::string_view name);
+		// returns UniqueId::zero if the name hasn't been given an id yet
+		//	unlike get_uid, this never creates a new id
+		unique_id find_uid(std::string_view name);
+		// every name that has an id, see: data_manager::get_all_names
+		std::vector<std::pair<unique_id, string>> get_all_names();
 		const mod& get_mod(unique_id id);
 
 		// get all ids / names for resources of a particular type
@@ -15,9 +15,10 @@
 
 namespace hades::zip
 {
+	// level is a zlib compression level, Z_BEST_SPEED suits data that is compressed every frame
 	template<typename Ty>
 		requires std::is_trivially_copy_constructible_v<Ty>
-	std::vector<std::byte> deflate(std::span<Ty> stream)
+	std::vector<std::byte> deflate(std::span<Ty> stream, int level = Z_BEST_COMPRESSION)
 	{
 		::z_stream deflate_stream;
 		deflate_stream.zalloc = Z_NULL;
@@ -29,7 +30,7 @@ namespace hades::zip
 		deflate_stream.next_in = reinterpret_cast<const Bytef*>(stream.data()); // input char array
 
 		// the actual compression work.
-		auto ret = deflateInit(&deflate_stream, Z_BEST_COMPRESSION);
+		auto ret = deflateInit(&deflate_stream, level);
 		if (ret != Z_OK)
 			throw archive_error{ deflate_stream.msg };
 
@@ -57,9 +58,9 @@ namespace hades::zip
 		requires requires (const Cont& cont) {
 		std::span{ cont };
 	}
-	std::vector<std::byte> deflate(const Cont& cont)
+	std::vector<std::byte> deflate(const Cont& cont, int level = Z_BEST_COMPRESSION)
 	{
-		return deflate(std::span{ cont });
+		return deflate(std::span{ cont }, level);
 	}
 
 	template<typename Ty>
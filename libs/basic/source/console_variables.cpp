@@ -22,6 +22,27 @@ namespace hades
 				constexpr auto server_threads = int32{ 0 };
 		#endif
 		console::create_property(cvars::server_threadcount, server_threads);
+		console::create_property(cvars::server_parallel_levels, cvars::default_value::server_parallel_levels);
+		console::create_property(cvars::server_archetype_storage, cvars::default_value::server_archetype_storage);
+		console::create_property(cvars::server_curve_compaction, cvars::default_value::server_curve_compaction);
+		console::create_property(cvars::server_curve_history, cvars::default_value::server_curve_history);
+		console::create_property(cvars::server_curve_compaction_interval, cvars::default_value::server_curve_compaction_interval);
+		console::create_property(cvars::server_frame_arena_overflow, cvars::default_value::server_frame_arena_overflow, true);
+		console::create_property(cvars::server_update_allocations, cvars::default_value::server_update_allocations, true);
+		console::create_property(cvars::server_cold_storage, cvars::default_value::server_cold_storage);
+		console::create_property(cvars::server_cold_storage_spill, cvars::default_value::server_cold_storage_spill);
+		console::create_property(cvars::server_snapshot_history, cvars::default_value::server_snapshot_history);
+		console::create_property(cvars::server_dirty_tracking, cvars::default_value::server_dirty_tracking);
+		console::create_property(cvars::server_tick_rate, cvars::default_value::server_tick_rate);
+		console::create_property(cvars::server_avg_tick_time, cvars::default_value::server_avg_tick_time, true);
+		console::create_property(cvars::server_max_tick_time, cvars::default_value::server_max_tick_time, true);
+		console::create_property(cvars::server_min_tick_time, cvars::default_value::server_min_tick_time, true);
+		console::create_property(cvars::server_port, cvars::default_value::server_port);
+		console::create_property(cvars::server_net_bytes_sent, cvars::default_value::server_net_bytes_sent, true);
+		console::create_property(cvars::server_interest_management, cvars::default_value::server_interest_management);
+		console::create_property(cvars::server_interest_cell_size, cvars::default_value::server_interest_cell_size);
+		console::create_property(cvars::server_hibernate_after, cvars::default_value::server_hibernate_after);
+		console::create_property(cvars::server_hibernated_levels, cvars::default_value::server_hibernated_levels, true);
 
 		console::create_property(cvars::client_tick_rate, cvars::default_value::client_tickrate);
 		console::create_property(cvars::client_avg_tick_time, cvars::default_value::client_avg_tick_time, true);
@@ -32,6 +53,8 @@ namespace hades
 		console::create_property(cvars::client_previous_frametime, cvars::default_value::client_previous_frametime, true);
 		console::create_property(cvars::client_average_frametime, cvars::default_value::client_average_frametime, true);
 		console::create_property(cvars::client_tick_count, cvars::default_value::client_tick_count, true);
+		console::create_property(cvars::client_net_bytes_received, cvars::default_value::client_net_bytes_received, true);
+		console::create_property(cvars::client_net_round_trip, cvars::default_value::client_net_round_trip, true);
 		console::create_property(cvars::client_log_to_file, cvars::default_value::client_log_to_file, true);
 
 		console::create_property<std::string_view>(cvars::game_name, cvars::default_value::game_name, true);
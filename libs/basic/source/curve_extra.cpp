@@ -1,5 +1,7 @@
 #include "hades/curve_extra.hpp"
 
+#include <atomic>
+
 #include "hades/parser.hpp"
 #include "hades/writer.hpp"
 
@@ -24,6 +26,15 @@ namespace hades
 
 namespace hades::resources
 {
+	namespace detail
+	{
+		std::size_t make_curve_key() noexcept
+		{
+			static auto next_key = std::atomic<std::size_t>{};
+			return next_key.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
 	//curve_variable_type_from_string
 	static curve_variable_type read_variable_type(std::string_view s) noexcept
 	{
@@ -169,6 +180,9 @@ namespace hades::resources
 		//			sync: default: false //true if this should be syncronised to the client
 		//			save: default false //true if this should be saved when creating a save file
 		//			locked: default false // if true, the curve cannot be edited in the level editor
+		//			history: default: 0s // length of history to keep, 0s uses s_curve_history
+		//			keyframe-limit: default: 0 // max keyframes to keep, 0 for no limit
+		//			collapse-keyframes: default: false // remove keyframes that don't change the curve
 		//			default: value, [value1, value2, value3, ...] etc
 
 		//these are loaded into the game instance before anything else
@@ -199,6 +213,9 @@ namespace hades::resources
 			//new_curve->save = get_scalar(*c, "save"sv, new_curve->save);
 			new_curve->locked = get_scalar(*c, "locked"sv, new_curve->locked);
 			new_curve->hidden = get_scalar(*c, "hidden"sv, new_curve->hidden);
+			new_curve->retention.history = get_scalar(*c, "history"sv, new_curve->retention.history);
+			new_curve->retention.keyframe_limit = get_scalar(*c, "keyframe-limit"sv, new_curve->retention.keyframe_limit);
+			new_curve->retention.collapse = get_scalar(*c, "collapse-keyframes"sv, new_curve->retention.collapse);
 
 			if (old_type != new_curve->data_type)
 				new_curve->default_value = reset_default_value(*new_curve);
@@ -429,6 +446,9 @@ namespace hades::resources
 		//			sync: default: false //true if this should be syncronised to the client
 		//			locked: default false // if true, the curve cannot be edited in the level editor
 		//			hidden: default false
+		//			history: default: 0s
+		//			keyframe-limit: default: 0
+		//			collapse-keyframes: default: false
 		//			default: value, [value1, value2, value3, ...] etc
 
 		w.start_map(d.get_as_string(id));
@@ -443,6 +463,12 @@ namespace hades::resources
 			w.write("locked"sv, to_string(locked));
 		if (hidden)
 			w.write("hidden"sv, to_string(hidden));
+		if (retention.history != time_duration::zero())
+			w.write("history"sv, hades::to_string(retention.history));
+		if (retention.keyframe_limit != 0)
+			w.write("keyframe-limit"sv, retention.keyframe_limit);
+		if (retention.collapse)
+			w.write("collapse-keyframes"sv, to_string(retention.collapse));
 
 		if (is_set(default_value))
 		{
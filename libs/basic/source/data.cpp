@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <shared_mutex>
+#include <utility>
 
 #include "hades/exceptions.hpp"
 
@@ -348,6 +349,16 @@ namespace hades
 			return detail::get_data_manager().get_uid(name);
 		}
 
+		unique_id find_uid(std::string_view name)
+		{
+			return std::as_const(detail::get_data_manager()).get_uid(name);
+		}
+
+		std::vector<std::pair<unique_id, string>> get_all_names()
+		{
+			return detail::get_data_manager().get_all_names();
+		}
+
 		const mod& get_mod(unique_id id)
 		{
 			return detail::get_data_manager().get_mod(id);
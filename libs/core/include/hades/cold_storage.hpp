@@ -0,0 +1,107 @@
+#ifndef HADES_COLD_STORAGE_HPP
+#define HADES_COLD_STORAGE_HPP
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "hades/entity_id.hpp"
+#include "hades/exceptions.hpp"
+#include "hades/objects.hpp"
+
+// cold storage holds the curves of objects that were destroyed a while ago
+//	so that they don't take up space in the game states colonies, while still
+//	being available for replays and rewinding
+// objects are packed into a byte buffer, once the buffer is large enough it
+//	is compressed into a block, blocks can optionally be written to a temp file
+
+namespace hades
+{
+	class cold_storage_error : public runtime_error
+	{
+	public:
+		using runtime_error::runtime_error;
+	};
+
+	// NOTE: the stored data holds ptrs to resources and is only valid
+	//		for the current process, it must not be written into save files
+	class cold_object_store
+	{
+	public:
+		// the amount of packed object data collected before compressing it into a block
+		static constexpr auto block_size = std::size_t{ 64 * 1024 };
+
+		cold_object_store() noexcept = default;
+		cold_object_store(const cold_object_store&) = delete;
+		cold_object_store(cold_object_store&&) noexcept = default;
+		cold_object_store& operator=(const cold_object_store&) = delete;
+		cold_object_store& operator=(cold_object_store&&) noexcept = default;
+
+		// packs the object into the store
+		//	an object already stored with the same id is replaced
+		void insert(const object_save_instance&);
+		bool contains(entity_id) const noexcept;
+		// unpacks the object, returns nullopt if it isn't in the store
+		//	not thread safe if spilling to disk
+		//exception: cold_storage_error if the stored data is corrupt
+		std::optional<object_save_instance> find(entity_id) const;
+		// unpacks every object in the store, sorted by id
+		//	each block is only decompressed once, so this is much faster than calling find for each object
+		//	not thread safe if spilling to disk
+		//exception: cold_storage_error if the stored data is corrupt
+		std::vector<object_save_instance> get_all() const;
+
+		std::size_t size() const noexcept
+		{
+			return std::size(_index);
+		}
+
+		// memory used by packed and compressed objects, doesn't include blocks stored on disk
+		std::size_t memory_usage() const noexcept;
+
+		// if true, blocks are written to a temp file rather than kept in memory
+		//	blocks that are already in memory stay there
+		void set_spill_to_disk(bool);
+		// zlib compression level used for new blocks, from 1(fastest) to 9(smallest)
+		//	defaults to 1, blocks are compressed during the tick that fills them
+		void set_compression_level(int) noexcept;
+
+	private:
+		struct entry
+		{
+			// _blocks.size() while the object is still in _pending
+			std::size_t block;
+			std::size_t offset;
+			std::size_t size;
+		};
+
+		struct block
+		{
+			std::vector<std::byte> data;
+			std::size_t uncompressed_size = {};
+			// used if data was written to the spill file
+			long file_offset = -1;
+			std::size_t file_size = {};
+		};
+
+		void _compress_pending();
+		std::vector<std::byte> _read_block(const block&) const;
+
+		struct file_closer
+		{
+			void operator()(std::FILE*) const noexcept;
+		};
+
+		std::unordered_map<entity_id, entry> _index;
+		std::vector<block> _blocks;
+		std::vector<std::byte> _pending;
+		std::unique_ptr<std::FILE, file_closer> _spill_file;
+		bool _spill_to_disk = false;
+		int _compression_level = 1;
+	};
+}
+
+#endif //!HADES_COLD_STORAGE_HPP
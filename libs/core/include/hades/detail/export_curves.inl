@@ -0,0 +1,164 @@
+#include "hades/export_curves.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+#include "hades/data.hpp"
+#include "hades/tuple.hpp"
+
+namespace hades
+{
+	template<typename Func>
+	void for_each_unique_id(exported_curves& e, Func&& f)
+	{
+		for (auto& o : e.created_objects)
+			std::invoke(f, o.object_type);
+
+		std::apply([&f](auto&... lists) {
+			const auto visit_list = [&f]<typename T>(std::vector<curve_export_set<T>>& list) {
+				for (auto& set : list)
+				{
+					std::invoke(f, set.variable);
+					if constexpr (std::is_same_v<T, unique_id>)
+					{
+						for (auto& [t, value] : set.keyframes)
+							std::invoke(f, value);
+					}
+					else if constexpr (std::is_same_v<T, curve_types::collection_unique>)
+					{
+						for (auto& [t, value] : set.keyframes)
+						{
+							for (auto& id : value)
+								std::invoke(f, id);
+						}
+					}
+				}
+				return;
+			};
+
+			(visit_list(lists), ...);
+			return;
+			}, e.curves);
+		return;
+	}
+}
+
+namespace hades::state_api
+{
+	namespace detail
+	{
+		template<typename T>
+		void apply_curve_set(game_obj& o, const curve_export_set<T>& set, game_state& s)
+		{
+			if (std::empty(set.keyframes))
+				return;
+
+			call_with_keyframe_style<T>(set.style, [&]<template<typename> typename CurveType>() {
+				auto curve = get_object_property_ptr<CurveType, T>(o, set.variable);
+				if (!curve)
+				{
+					if (find_object_variable(o, set.variable))
+						throw export_error{ "exported curve doesn't match the type of the objects curve" };
+
+					insert_object_property<CurveType, T>(o, set.variable, s, CurveType<T>{});
+					curve = get_object_property_ptr<CurveType, T>(o, set.variable);
+					assert(curve);
+				}
+
+				// the server may have replaced keyframes that we already have
+				const auto& [first_time, first_value] = set.keyframes.front();
+				curve->replace_keyframes(first_time, first_value);
+				const auto last = end(set.keyframes);
+				for (auto iter = next(begin(set.keyframes)); iter != last; ++iter)
+					curve->add_keyframe(iter->first, iter->second);
+				return;
+				});
+			return;
+		}
+	}
+
+	template<typename GameSystem>
+	void export_changes(const time_point since, const game_state& s, const extra_state<GameSystem>& e, exported_curves& out)
+	{
+		out.clear();
+		out.since = since;
+
+		// only visits the objects created or destroyed after since
+		s.object_creation_time.for_each_after(since, [&e, &out](const entity_id id, const time_point t) {
+			// erased objects can't be sent
+			const auto obj = e.objects.find(id);
+			if (!obj)
+				return;
+
+			assert(obj->object_type);
+			out.created_objects.emplace_back(exported_curves::exported_object{ id, obj->object_type->id, t });
+			return;
+			});
+
+		s.object_destruction_time.for_each_after(since, [&out](const entity_id id, const time_point t) {
+			out.destroyed_objects.emplace_back(id, t);
+			return;
+			});
+
+		for (const auto& [name, curve] : s.names)
+		{
+			const auto& keyframes = curve.keyframes();
+			const auto first = std::upper_bound(std::begin(keyframes), std::end(keyframes), since, [](const time_point t, const auto& k) noexcept {
+				return t < k.time;
+				});
+
+			for (auto iter = first; iter != std::end(keyframes); ++iter)
+				out.entity_names.emplace_back(exported_curves::exported_name{ name, iter->time, iter->value.id });
+		}
+
+		for (const auto& o : e.objects)
+			detail::export_object_curves(o, since, out);
+
+		detail::sort_exported_curves(out);
+		return;
+	}
+
+	template<typename GameSystem>
+	void apply_changes(const exported_curves& changes, game_state& s, extra_state<GameSystem>& e)
+	{
+		for (const auto& o : changes.created_objects)
+		{
+			if (!e.objects.find(o.id))
+			{
+				const auto obj = e.objects.insert(game_obj{ o.id, data::get<resources::object>(o.object_type), {} });
+				assert(obj);
+				detail::assign_archetype_row(*obj, s);
+			}
+
+			s.object_creation_time.insert_or_assign(o.id, o.creation_time);
+			if (!(o.id < s.next_id))
+				s.next_id = next(o.id);
+		}
+
+		for (const auto& [id, t] : changes.destroyed_objects)
+			s.object_destruction_time.insert_or_assign(id, t);
+
+		for (const auto id : changes.left_objects)
+		{
+			const auto obj = e.objects.find(id);
+			if (obj)
+				erase_object(*obj, s, e);
+		}
+
+		for (const auto& n : changes.entity_names)
+			s.names[n.name].add_keyframe(n.time, object_ref{ n.entity });
+
+		tuple_for_each(changes.curves, [&s, &e](const auto& list) {
+			for (const auto& set : list)
+			{
+				const auto obj = e.objects.find(set.entity);
+				if (obj)
+					detail::apply_curve_set(*obj, set, s);
+			}
+			return;
+			});
+
+		return;
+	}
+}
@@ -1,5 +1,6 @@
 #include "hades/game_api.hpp"
 
+#include <algorithm>
 #include <type_traits>
 
 #include "hades/data.hpp"
@@ -9,16 +10,46 @@ namespace hades
 {
 	namespace detail
 	{
-		template<typename T, typename GameSystem>
-		T& get_level_local_ref_imp(const unique_id id, extra_state<GameSystem>& extras)
+		// Key is either a unique_id or a state_api::level_local_handle<T>
+		template<typename T, typename Key, typename GameSystem>
+		T& get_level_local_ref_imp(const Key key, extra_state<GameSystem>& extras)
 		{
-			return state_api::get_level_local_ref<T>(id, extras);
+			return state_api::get_level_local_ref<T>(key, extras);
 		}
 
-		template<typename T, typename GameSystem>
-		void set_level_local_value_imp(const unique_id id, T value, extra_state<GameSystem>& extras)
+		template<typename T, typename Key, typename GameSystem>
+		void set_level_local_value_imp(const Key key, T value, extra_state<GameSystem>& extras)
 		{
-			return state_api::set_level_local_value<T>(id, std::move(value), extras);
+			return state_api::set_level_local_value<T>(key, std::move(value), extras);
+		}
+
+		// level locals aren't part of the declared system access, so two systems that don't
+		//	conflict could still write the same local
+		inline void check_level_local_access()
+		{
+			if (get_game_data_ptr()->concurrent_tick)
+				throw system_error{ "Cannot use level locals while systems are being ticked concurrently; don't declare access for systems that use level locals" };
+			return;
+		}
+
+		// records a curve being written to in the current level, see: state_api::enable_dirty_tracking
+		//	systems ticked concurrently record into their own list
+		inline void mark_curve_dirty(game_interface& level, const entity_id e, const variable_id v)
+		{
+			const auto data = get_game_data_ptr();
+			// systems ticked concurrently can only write the curves they declared
+			assert(!data->concurrent_tick || !data->write_curves ||
+				std::ranges::find(*data->write_curves, v) != std::end(*data->write_curves));
+
+			auto& journal = level.get_extras().dirty_curves;
+			if (!journal.enabled)
+				return;
+
+			if (data->dirty_curves && data->level_data == &level)
+				data->dirty_curves->push_back(dirty_curve{ e, v });
+			else
+				journal.current.push_back(dirty_curve{ e, v });
+			return;
 		}
 	}
 
@@ -29,16 +60,17 @@ namespace hades
 		T& get_system_data()
 		{
 			auto ptr = detail::get_game_data_ptr();
-			assert(ptr->system_data->has_value());
-			auto ret = std::any_cast<T>(ptr->system_data);
-			assert(ret);
-			return *ret;
+			if (!ptr->system_data)
+				throw system_error{ "System data isn't available outside of a system, such as in deferred level calls" };
+			return ptr->system_data->template get<T>();
 		}
 
 		template<typename T>
 		void set_system_data(T value)
 		{
 			auto ptr = detail::get_game_data_ptr();
+			if (!ptr->system_data)
+				throw system_error{ "System data isn't available outside of a system, such as in deferred level calls" };
 			ptr->system_data->emplace<std::decay_t<T>>(std::move(value));
 		}
 	}
@@ -52,6 +84,7 @@ namespace hades
 		template<typename T>
 		T& get_level_local_ref(unique_id id)
 		{
+			detail::check_level_local_access();
 			auto ptr = detail::get_game_level_ptr();
 			return detail::get_level_local_ref_imp<T>(id, ptr->get_extras());
 		}
@@ -59,10 +92,51 @@ namespace hades
 		template<typename T>
 		void set_level_local_value(unique_id id, T value)
 		{
+			detail::check_level_local_access();
 			auto ptr = detail::get_game_level_ptr();
 			detail::set_level_local_value_imp<T>(id, std::move(value), ptr->get_extras());
 			return;
 		}
+
+		template<typename T>
+		T& get_level_local_ref(const state_api::level_local_handle<T> h)
+		{
+			detail::check_level_local_access();
+			auto ptr = detail::get_game_level_ptr();
+			return detail::get_level_local_ref_imp<T>(h, ptr->get_extras());
+		}
+
+		template<typename T>
+		void set_level_local_value(const state_api::level_local_handle<T> h, std::type_identity_t<T> value)
+		{
+			detail::check_level_local_access();
+			auto ptr = detail::get_game_level_ptr();
+			detail::set_level_local_value_imp<T>(h, std::move(value), ptr->get_extras());
+			return;
+		}
+
+		template<typename Func, typename... Handles>
+		void for_each_chunk(Func&& f, Handles... handles)
+		{
+			auto ptr = detail::get_game_level_ptr();
+			if (!ptr->get_extras().dirty_curves.enabled)
+			{
+				state_api::for_each_chunk(ptr->get_state(), std::forward<Func>(f), handles...);
+				return;
+			}
+
+			// the columns are writable, so every visited row is assumed to have been written
+			state_api::for_each_chunk(ptr->get_state(), [&f, ptr, handles...](auto& chunk) {
+				std::invoke(f, chunk);
+				chunk.for_each_row([&chunk, ptr, handles...](const std::size_t row) {
+					const auto e = chunk.get_entity(row);
+					(detail::mark_curve_dirty(*ptr, e, handles.id), ...);
+					return;
+					});
+				return;
+				}, handles...);
+			return;
+		}
 	}
 
 	namespace game::level::object
@@ -74,7 +148,22 @@ namespace hades
 			static_assert(curve_types::is_curve_type_v<T>);
 			const auto g_ptr = hades::detail::get_game_level_ptr();
 			auto& obj = state_api::get_object(o, g_ptr->get_extras());
-			return state_api::get_object_property_ref<CurveType, T>(obj, v);
+			auto& curve = state_api::get_object_property_ref<CurveType, T>(obj, v);
+			if constexpr (!std::is_same_v<CurveType<T>, const_curve<T>>)
+				hades::detail::mark_curve_dirty(*g_ptr, obj.id, v);
+			return curve;
+		}
+
+		template<template<typename> typename CurveType, typename T>
+		state_api::get_property_return_t<CurveType, T>&
+			get_property_ref(object_ref& o, const state_api::property_handle<CurveType, T> h)
+		{
+			const auto g_ptr = hades::detail::get_game_level_ptr();
+			auto& obj = state_api::get_object(o, g_ptr->get_extras());
+			auto& curve = state_api::get_object_property_ref(obj, h);
+			if constexpr (!std::is_same_v<CurveType<T>, const_curve<T>>)
+				hades::detail::mark_curve_dirty(*g_ptr, obj.id, h.id);
+			return curve;
 		}
 	}
 
@@ -85,10 +174,8 @@ namespace hades
 		T &get_system_data() noexcept
 		{
 			auto ptr = detail::get_render_data_ptr();
-			assert(ptr->system_data->has_value());
-			auto ret = std::any_cast<T>(ptr->system_data);
-			assert(ret);
-			return *ret;
+			assert(ptr->system_data);
+			return ptr->system_data->template get<T>();
 		}
 
 		template<typename T>
@@ -134,6 +221,18 @@ namespace hades
 			return detail::set_level_local_value_imp(id, std::move(value), *detail::get_render_extra_ptr());
 		}
 
+		template<typename T>
+		T& get_level_local_ref(const state_api::level_local_handle<T> h)
+		{
+			return detail::get_level_local_ref_imp<T>(h, *detail::get_render_extra_ptr());
+		}
+
+		template<typename T>
+		void set_level_local_value(const state_api::level_local_handle<T> h, std::type_identity_t<T> value)
+		{
+			return detail::set_level_local_value_imp<T>(h, std::move(value), *detail::get_render_extra_ptr());
+		}
+
 		namespace object
 		{
 			template<template<typename> typename CurveType, typename T>
@@ -144,6 +243,14 @@ namespace hades
 				auto& obj = state_api::get_object(o, *hades::detail::get_render_extra_ptr());
 				return state_api::get_object_property_ref<CurveType, T>(obj, v);
 			}
+
+			template<template<typename> typename CurveType, typename T>
+			const state_api::get_property_return_t<CurveType, T>&
+				get_property_ref(object_ref& o, const state_api::property_handle<CurveType, T> h)
+			{
+				auto& obj = state_api::get_object(o, *hades::detail::get_render_extra_ptr());
+				return state_api::get_object_property_ref(obj, h);
+			}
 		}
 	}
 }
@@ -1,38 +1,67 @@
 #include "hades/game_state.hpp"
 
+#include <algorithm>
+#include <functional>
+#include <numeric>
+
 #include "hades/tuple.hpp"
 
 namespace hades::state_api
 {
 	namespace detail
 	{
+		// adds the curve into the game_state database
+		//	then records a ptr to the data in the game object
 		template<template<typename> typename CurveType, typename T>
-		static inline void create_object_property(game_obj& object, const unique_id curve_id,
-			game_state& state, std::vector<object_save_instance::saved_curve::saved_keyframe> value)
+		static inline void insert_object_property(game_obj& object, const unique_id curve_id,
+			game_state& state, CurveType<T> curve)
 		{
 			static_assert(!std::is_same_v<CurveType<T>, const_curve<T>>);
-			//add the curve and value into the game_state database
-			//then record a ptr to the data in the game object
-			auto& colony = std::get<game_state::data_colony<CurveType, T>>(state.state_data);
-			auto curve = CurveType<T>{};
-
-			curve.reserve(size(value));
-			for (const auto& [time, frame_value] : value)
-				curve.add_keyframe(time, std::move(std::get<T>(frame_value)));
+			using field_type = state_field<CurveType<T>>;
+			auto field = static_cast<field_type*>(nullptr);
+			if (object.archetype_row != game_obj::no_archetype_row)
+			{
+				// store in the objects archetype if it has a column for this curve
+				const auto arch = state.archetypes.find(object.object_type);
+				assert(arch);
+				if (const auto column = arch->template find_column<field_type>(curve_id); column)
+				{
+					field = &column->get_field(object.archetype_row);
+					*field = field_type{ object.id, curve_id, std::move(curve) };
+				}
+			}
 
-			auto iter = colony.insert(state_field<CurveType<T>>{
-				object.id, curve_id, std::move(curve) 
-			});
+			if (!field)
+			{
+				auto& colony = std::get<game_state::data_colony<CurveType, T>>(state.state_data);
+				auto iter = colony.insert(field_type{
+					object.id, curve_id, std::move(curve) 
+				});
+				field = &*iter;
+			}
 
 			using entry_type = typename game_obj::var_entry;
 			object.object_variables.push_back(entry_type{
 				curve_id,
-				static_cast<void*>(&*iter),
+				static_cast<void*>(field),
 				get_curve_info<CurveType, T>()
 			});
 			return;
 		}
 
+		template<template<typename> typename CurveType, typename T>
+		static inline void create_object_property(game_obj& object, const unique_id curve_id,
+			game_state& state, std::vector<object_save_instance::saved_curve::saved_keyframe> value)
+		{
+			auto curve = CurveType<T>{};
+			curve.reserve(size(value));
+			for (const auto& [time, frame_value] : value)
+				curve.add_keyframe(time, std::move(std::get<T>(frame_value)));
+
+			insert_object_property<CurveType, T>(object, curve_id, state, std::move(curve));
+			return;
+		}
+
 		struct make_object_visitor
 		{
 			const resources::curve& c;
@@ -87,6 +116,42 @@ namespace hades::state_api
 			void operator()(const std::monostate) { assert(false); throw logic_error{ "monostate in game_state.inl" }; return; }
 		};
 
+		// gives the object a row in its archetype, if archetypes are enabled
+		//	must be called before the objects curves are created
+		inline void assign_archetype_row(game_obj& o, game_state& s)
+		{
+			assert(o.object_type);
+			if (s.archetype_storage)
+				o.archetype_row = s.archetypes.find_or_create(*o.object_type).insert(o.id);
+			return;
+		}
+
+		// sorts the objects variables into the slots listed in its types variable_layout
+		//	any variables that aren't in the layout are placed at the end
+		inline void apply_variable_layout(game_obj& o)
+		{
+			assert(o.object_type);
+			const auto& layout = o.object_type->variable_layout;
+			std::ranges::sort(o.object_variables, {}, [&layout](const game_obj::var_entry& e) {
+				return std::pair{ !std::ranges::binary_search(layout, e.id), e.id };
+				});
+			return;
+		}
+
+		// returns the entry for the variable, or nullptr
+		inline const game_obj::var_entry* find_object_variable(const game_obj& g, const variable_id v) noexcept
+		{
+			assert(g.object_type);
+			const auto slot = resources::object_functions::get_variable_slot(*g.object_type, v);
+			if (slot < size(g.object_variables) && g.object_variables[slot].id == v)
+				return &g.object_variables[slot];
+
+			// variables that were added to the object, rather than its type
+			// or objects that were created before the layout was changed
+			const auto iter = std::ranges::find(g.object_variables, v, &game_obj::var_entry::id);
+			return iter == end(g.object_variables) ? nullptr : &*iter;
+		}
+
 		template<typename GameSystem>
 		inline object_ref make_object_impl(const object_instance& o, time_point t, game_state& s, extra_state<GameSystem>& e)
 		{
@@ -96,18 +161,39 @@ namespace hades::state_api
 			// insert always returns a valid ptr
             auto obj = e.objects.insert(game_obj{ id, o.obj_type, {} });
 			assert(obj);
+			assign_archetype_row(*obj, s);
 
-			auto curves = get_all_curves(o);
-
-			for (auto& c : curves)
+			// instances that don't add curves are created from their types prototype
+			//	which is already in variable_layout order
+			if (empty(o.curves))
 			{
-                assert(c.curve_ptr);
-				assert(!c.value.valueless_by_exception());
-				assert(resources::is_set(c.value));
-				if (c.curve_ptr->frame_style == keyframe_style::const_t)
-					continue;
-                std::visit(detail::make_object_visitor{ *c.curve_ptr, s,
-					*obj, std::vector{ object_save_instance::saved_curve::saved_keyframe{t, c.value} } }, c.value);
+				const auto& type_curves = resources::object_functions::get_all_curves(*o.obj_type);
+				const auto& object_curves = o.obj_type->prototype.object_curves;
+				obj->object_variables.reserve(size(object_curves));
+				for (const auto i : object_curves)
+				{
+					const auto& c = type_curves[i];
+					assert(c.curve_ptr);
+					assert(resources::is_set(c.value));
+					std::visit(detail::make_object_visitor{ *c.curve_ptr, s,
+						*obj, std::vector{ object_save_instance::saved_curve::saved_keyframe{t, c.value} } }, c.value);
+				}
+			}
+			else
+			{
+				const auto curves = get_all_curves(o);
+				for (auto& c : curves)
+				{
+					assert(c.curve_ptr);
+					assert(!c.value.valueless_by_exception());
+					assert(resources::is_set(c.value));
+					if (c.curve_ptr->frame_style == keyframe_style::const_t)
+						continue;
+					std::visit(detail::make_object_visitor{ *c.curve_ptr, s,
+						*obj, std::vector{ object_save_instance::saved_curve::saved_keyframe{t, c.value} } }, c.value);
+				}
+
+				apply_variable_layout(*obj);
 			}
 
 			if (!empty(o.name_id))
@@ -125,6 +211,7 @@ namespace hades::state_api
 			// insert always returns a valid ptr
             auto obj = e.objects.insert(game_obj{ id, o.obj_type, {} });
 			assert(obj);
+			assign_archetype_row(*obj, s);
 
 			//list of curve ids
 			auto ids = std::vector<unique_id>{};
@@ -159,6 +246,8 @@ namespace hades::state_api
                 std::visit(detail::make_object_visitor{*c.curve_ptr, s, *obj, keyframes}, keyframes[0].value);
 			}
 
+			apply_variable_layout(*obj);
+
 			if (!empty(o.name_id))
 				name_object(o.name_id, { id, obj }, t, s);
 
@@ -178,8 +267,8 @@ namespace hades::state_api
 			if (e.objects.find(o.id) != nullptr)
 				throw object_id_collision{ "tried to restore an object that has a matching id to a currently living object" };
 			const auto obj = detail::make_object_impl(o, o.creation_time, s, e);
-			s.object_creation_time[o.id] = o.creation_time;
-			s.object_destruction_time[o.id] = o.destruction_time;
+			s.object_creation_time.insert_or_assign(o.id, o.creation_time);
+			s.object_destruction_time.insert_or_assign(o.id, o.destruction_time);
 
 			// TODO: attach_system_from_load should accept a ptr, we have a ptr to the system in sys
 			for (const auto& sys : resources::object_functions::get_systems(*o.obj_type))
@@ -200,7 +289,7 @@ namespace hades::state_api
 		if (o.id != bad_entity)
 			throw game_state_error{ "tried to create object with preset id" };
 		auto obj = detail::make_object_impl(o, t, s, e);
-		s.object_creation_time[obj.id] = t;
+		s.object_creation_time.insert_or_assign(obj.id, t);
 
 		// TODO: we have a ptr to the system in sys, pass that into the extra state
 		for (const auto& sys : resources::object_functions::get_systems(*o.obj_type))
@@ -368,6 +457,7 @@ namespace hades::state_api
 	{
 		const auto id = increment(state.next_id);
         auto new_obj = extra.objects.insert(game_obj{ id, obj.object_type, {} });
+		detail::assign_archetype_row(*new_obj, state);
 
 		//copy all object properties
 		for (const auto& var_entry : obj.object_variables)
@@ -377,7 +467,7 @@ namespace hades::state_api
 			detail::call_with_curve_info(var_entry.info, functor);
 		}
 
-		state.object_creation_time[id] = t;
+		state.object_creation_time.insert_or_assign(id, t);
 		const auto ref = object_ref{ id, new_obj };
 		//attach all systems
 		// TODO: we have a ptr to the system in sys, pass that into the extra state
@@ -387,6 +477,88 @@ namespace hades::state_api
 		return ref;
 	}
 
+	namespace detail
+	{
+		// reserves room in the curves colony for count more curves
+		struct reserve_colony_functor
+		{
+			game_state& state;
+			std::size_t count;
+
+			template<template <typename> typename CurveType, typename VarType>
+			void operator()()
+			{
+				auto& colony = std::get<game_state::data_colony<CurveType, VarType>>(state.state_data);
+				colony.reserve(colony.size() + count);
+				return;
+			}
+		};
+	}
+
+	template<typename GameSystem>
+	std::vector<object_ref> make_objects(const std::span<const object_instance> instances,
+		const time_point t, game_state& s, extra_state<GameSystem>& e)
+	{
+		if (std::ranges::any_of(instances, [](const entity_id id) noexcept {
+			return id != bad_entity;
+			}, &object_instance::id))
+			throw game_state_error{ "tried to create object with preset id" };
+
+		const auto instance_count = size(instances);
+		// group the instances by type, keep the original order so that ids are
+		// assigned to objects of the same type in the order they were passed
+		auto order = std::vector<std::size_t>(instance_count);
+		std::iota(begin(order), end(order), std::size_t{});
+		std::ranges::stable_sort(order, std::less<>{}, [instances](const std::size_t i) noexcept {
+			return instances[i].obj_type;
+			});
+
+		e.objects.reserve(e.objects.size() + instance_count);
+		s.object_creation_time.reserve(s.object_creation_time.size() + instance_count);
+
+		auto out = std::vector<object_ref>(instance_count);
+		auto group_refs = std::vector<object_ref>{};
+		auto first = begin(order);
+		const auto last = end(order);
+		while (first != last)
+		{
+			const auto obj_type = instances[*first].obj_type;
+			assert(obj_type);
+			const auto group_end = std::find_if(first, last, [instances, obj_type](const std::size_t i) noexcept {
+				return instances[i].obj_type != obj_type;
+				});
+			const auto group_size = integer_cast<std::size_t>(std::distance(first, group_end));
+
+			// archetype storage holds the types curves in its own columns
+			if (!s.archetype_storage)
+			{
+				const auto& type_curves = resources::object_functions::get_all_curves(*obj_type);
+				for (const auto i : obj_type->prototype.object_curves)
+				{
+					const auto c = type_curves[i].curve_ptr;
+					assert(c);
+					detail::call_with_curve_info({ c->frame_style, c->data_type },
+						detail::reserve_colony_functor{ s, group_size });
+				}
+			}
+
+			group_refs.clear();
+			group_refs.reserve(group_size);
+			for (; first != group_end; ++first)
+			{
+				const auto obj = detail::make_object_impl(instances[*first], t, s, e);
+				s.object_creation_time.insert_or_assign(obj.id, t);
+				out[*first] = obj;
+				group_refs.emplace_back(obj);
+			}
+
+			for (const auto& sys : resources::object_functions::get_systems(*obj_type))
+				e.systems.attach_system(group_refs, sys.id());
+		}
+
+		return out;
+	}
+
 	template<typename GameSystem>
 	void destroy_object(object_ref o, time_point t, game_state& s, extra_state<GameSystem>& e)
 	{
@@ -402,6 +574,8 @@ namespace hades::state_api
 		public:
 			game_state& s;
 			void* var;
+			hades::detail::archetype* arch = nullptr;
+			std::size_t row = game_obj::no_archetype_row;
 
 			template<template<typename> typename CurveType, typename T>
 			void operator()()
@@ -410,6 +584,14 @@ namespace hades::state_api
 
 				using namespace std::string_literals;
 				const auto entry = static_cast<state_field<CurveType<T>>*>(var);
+				// archetype rows are released by erase_object
+				if (arch)
+				{
+					const auto column = arch->find_column(entry->id);
+					if (column && column->get(row) == var)
+						return;
+				}
+
 				//TODO: search the colony for the target vars more efficiently
 				auto& list = std::get<game_state::data_colony<CurveType, T>>(s.state_data);
 				const auto iter = list.get_iterator(entry);
@@ -428,17 +610,152 @@ namespace hades::state_api
 	template<typename GameSystem>
 	void erase_object(game_obj& o, game_state& s, extra_state<GameSystem>& e)
 	{
+		const auto arch = o.archetype_row == game_obj::no_archetype_row ?
+			nullptr : s.archetypes.find(o.object_type);
 		for (const auto& entry : o.object_variables)
 		{
 			auto info = entry.info;
-			auto visitor = detail::erase_object_visitor{ s, entry.var };
+			auto visitor = detail::erase_object_visitor{ s, entry.var, arch, o.archetype_row };
 			detail::call_with_curve_info(info, visitor);
 		}
+
+		if (arch)
+			arch->erase(o.archetype_row);
+
 		o.object_variables.clear();
+		o.archetype_row = game_obj::no_archetype_row;
 		e.objects.erase(&o);
 		return;
 	}
 
+	template<typename GameSystem>
+	void move_to_cold_storage(game_obj& o, game_state& s, extra_state<GameSystem>& e)
+	{
+		s.cold_objects.insert(extract_object(o, s));
+		erase_object(o, s, e);
+		return;
+	}
+
+	namespace detail
+	{
+		// value comparison used when collapsing keyframes
+		//	interpolated values rarely land exactly on the original keyframes
+		struct compact_equal
+		{
+			template<typename T>
+			bool operator()(const T& a, const T& b) const noexcept
+			{
+				if constexpr (requires { float_near_equal(a, b); })
+					return float_near_equal(a, b);
+				else
+					return a == b;
+			}
+		};
+
+		class compact_curve_visitor
+		{
+		public:
+			void* var;
+			const resources::curve_retention& retention;
+			time_point last_compaction;
+			time_point now;
+			time_duration history;
+
+			template<template<typename> typename CurveType, typename T>
+			void operator()()
+			{
+				auto& c = static_cast<state_field<CurveType<T>>*>(var)->data;
+				if constexpr (!std::is_same_v<CurveType<T>, pulse_curve<T>>)
+				{
+					if (retention.collapse)
+						c.collapse_keyframes(last_compaction, now, compact_equal{});
+				}
+
+				if (history != time_duration::zero())
+					c.trim_history(now - history);
+				if (retention.keyframe_limit != 0)
+					c.trim_keyframes(retention.keyframe_limit, now);
+				return;
+			}
+		};
+
+		// returns nullptr if the variable isn't one of the objects type curves
+		inline const resources::curve* find_variable_curve(const game_obj& o, const std::size_t index, const game_obj::var_entry& entry)
+		{
+			assert(o.object_type);
+			const auto& type = *o.object_type;
+			const auto& curves = resources::object_functions::get_all_curves(type);
+			// variables are stored in variable_layout order, see: apply_variable_layout
+			const auto& object_curves = type.prototype.object_curves;
+			if (index < size(object_curves))
+			{
+				const auto curve = curves[object_curves[index]].curve_ptr;
+				if (curve->id == entry.id)
+					return curve;
+			}
+
+			// variables that were added to the object, rather than its type
+			if (!resources::object_functions::has_curve(type, entry.id))
+				return nullptr;
+			return resources::object_functions::get_curve(type, entry.id).curve_ptr;
+		}
+	}
+
+	template<typename GameSystem>
+	void compact_curves(const time_point last_compaction, const time_point now, const time_duration default_history, extra_state<GameSystem>& e)
+	{
+		const auto default_retention = resources::curve_retention{};
+		for (auto& o : e.objects)
+		{
+			for (auto i = std::size_t{}; i < size(o.object_variables); ++i)
+			{
+				const auto& entry = o.object_variables[i];
+				const auto curve = detail::find_variable_curve(o, i, entry);
+				const auto& retention = curve ? curve->retention : default_retention;
+				const auto history = retention.history == time_duration::zero() ?
+					default_history : retention.history;
+
+				auto visitor = detail::compact_curve_visitor{ entry.var, retention, last_compaction, now, history };
+				detail::call_with_curve_info(entry.info, visitor);
+			}
+		}
+		return;
+	}
+
+	template<typename GameSystem>
+	void enable_dirty_tracking(const bool enable, extra_state<GameSystem>& e) noexcept
+	{
+		e.dirty_curves.enabled = enable;
+		if (!enable)
+		{
+			e.dirty_curves.current.clear();
+			e.dirty_curves.last_tick.clear();
+		}
+		return;
+	}
+
+	template<typename GameSystem>
+	std::span<const dirty_curve> get_dirty_curves(const extra_state<GameSystem>& e) noexcept
+	{
+		return e.dirty_curves.last_tick;
+	}
+
+	template<typename GameSystem>
+	void finish_dirty_tick(extra_state<GameSystem>& e)
+	{
+		auto& journal = e.dirty_curves;
+		if (!journal.enabled)
+			return;
+
+		std::sort(begin(journal.current), end(journal.current));
+		const auto last = std::unique(begin(journal.current), end(journal.current));
+		journal.current.erase(last, end(journal.current));
+		// keep the old list's memory for the next tick
+		std::swap(journal.current, journal.last_tick);
+		journal.current.clear();
+		return;
+	}
+
 	template<typename GameSystem>
 	object_ref get_object_ref(std::string_view s, time_point t, game_state& g, extra_state<GameSystem>& e) noexcept
 	{
@@ -562,12 +879,9 @@ namespace hades::state_api
 			}
 			else
 			{
-				for (auto& entry : g.object_variables)
-				{
-					if (entry.id == v &&
-						entry.info == get_curve_info<CurveType, T>())
-						return &(static_cast<state_field<CurveType<T>>*>(entry.var)->data);
-				}
+				const auto entry = find_object_variable(g, v);
+				if (entry && entry->info == get_curve_info<CurveType, T>())
+					return &(static_cast<state_field<CurveType<T>>*>(entry->var)->data);
 
 				return nullptr;
 			}
@@ -590,17 +904,15 @@ namespace hades::state_api
 			}
 			else
 			{
-				for (auto& entry : g.object_variables)
+				const auto entry = find_object_variable(g, v);
+				if (entry)
 				{
-					if (entry.id == v)
-					{
-						if (entry.info == get_curve_info<CurveType, T>())
-							return static_cast<state_field<CurveType<T>>*>(entry.var)->data;
-						else
-							throw object_property_wrong_type{ "attempted to get property using the wrong type, requested: "
-							+ to_string(get_curve_info<CurveType, T>()) + "; stored: "
-							+ to_string(entry.info) };
-					}
+					if (entry->info == get_curve_info<CurveType, T>())
+						return static_cast<state_field<CurveType<T>>*>(entry->var)->data;
+					else
+						throw object_property_wrong_type{ "attempted to get property using the wrong type, requested: "
+						+ to_string(get_curve_info<CurveType, T>()) + "; stored: "
+						+ to_string(entry->info) };
 				}
 
 				assert(false);
@@ -637,6 +949,104 @@ namespace hades::state_api
         return detail::get_object_property_ptr<CurveType, T>(o, v);
 	}
 
+	template<template<typename> typename CurveType, typename T>
+	property_handle<CurveType, T> make_property_handle(const resources::curve& c)
+	{
+		static_assert(curve_types::is_curve_type_v<T> && (linear_interpable<T> || !std::is_same_v<CurveType<T>, linear_curve<T>>),
+			"T must be one of the curve types listed in curve_types::type_pack, if T is a collection type, string or bool, then CurveType cannot be linear_curve");
+
+		constexpr auto info = get_curve_info<CurveType, T>();
+		if (std::pair{ c.frame_style, c.data_type } != info)
+		{
+			throw object_property_wrong_type{ "attempted to make property handle using the wrong type, requested: "
+				+ to_string(info) + "; curve: " + to_string(std::pair{ c.frame_style, c.data_type }) };
+		}
+
+		return { c.id, c.key };
+	}
+
+	template<template<typename> typename CurveType, typename T>
+	property_handle<CurveType, T> make_property_handle(const variable_id v)
+	{
+		return make_property_handle<CurveType, T>(*data::get<resources::curve>(v));
+	}
+
+	namespace detail
+	{
+		// returns the entry for the handle, or nullptr
+		template<template<typename> typename CurveType, typename T>
+		inline const game_obj::var_entry* find_object_variable(const game_obj& g, const property_handle<CurveType, T> h) noexcept
+		{
+			assert(g.object_type);
+			const auto& slots = g.object_type->variable_key_slots;
+			if (h.key < size(slots))
+			{
+				const auto slot = slots[h.key];
+				if (slot < size(g.object_variables) && g.object_variables[slot].id == h.id)
+				{
+					assert(g.object_variables[slot].info == (get_curve_info<CurveType, T>()));
+					return &g.object_variables[slot];
+				}
+			}
+
+			return find_object_variable(g, h.id);
+		}
+
+		template<template<typename> typename CurveType, typename T>
+		inline get_property_return_t<CurveType, T>* get_object_property_ptr(const game_obj& g, const property_handle<CurveType, T> h) noexcept
+		{
+			if constexpr (std::is_same_v<CurveType<T>, const_curve<T>>)
+				return get_object_property_ptr<CurveType, T>(g, h.id);
+			else
+			{
+				const auto entry = find_object_variable(g, h);
+				return entry ? &(static_cast<state_field<CurveType<T>>*>(entry->var)->data) : nullptr;
+			}
+		}
+
+		template<template<typename> typename CurveType, typename T>
+		inline get_property_return_t<CurveType, T>& get_object_property_ref(const game_obj& g, const property_handle<CurveType, T> h)
+		{
+			if constexpr (std::is_same_v<CurveType<T>, const_curve<T>>)
+				return get_object_property_ref<CurveType, T>(g, h.id);
+			else
+			{
+				const auto entry = find_object_variable(g, h);
+				if (!entry)
+					throw object_property_not_found{ "object missing expected property " + to_string(h.id) };
+				return static_cast<state_field<CurveType<T>>*>(entry->var)->data;
+			}
+		}
+	}
+
+	template<template<typename> typename CurveType, typename T>
+	const get_property_return_t<CurveType, T>&
+		get_object_property_ref(const game_obj& o, const property_handle<CurveType, T> h)
+	{
+		return detail::get_object_property_ref(o, h);
+	}
+
+	template<template<typename> typename CurveType, typename T>
+	get_property_return_t<CurveType, T>&
+		get_object_property_ref(game_obj& o, const property_handle<CurveType, T> h)
+	{
+		return detail::get_object_property_ref(o, h);
+	}
+
+	template<template<typename> typename CurveType, typename T>
+	const get_property_return_t<CurveType, T>*
+		get_object_property_ptr(const game_obj& o, const property_handle<CurveType, T> h) noexcept
+	{
+		return detail::get_object_property_ptr(o, h);
+	}
+
+	template<template<typename> typename CurveType, typename T>
+	get_property_return_t<CurveType, T>*
+		get_object_property_ptr(game_obj& o, const property_handle<CurveType, T> h) noexcept
+	{
+		return detail::get_object_property_ptr(o, h);
+	}
+
 	template<typename GameSystem>
 	const tag_list& get_object_tags(object_ref o, const extra_state<GameSystem>& e)
 	{
@@ -644,9 +1054,142 @@ namespace hades::state_api
 		return get_object_tags(obj);
 	}
 
+	template<typename Func, typename... Handles>
+	void for_each_chunk(game_state& s, Func&& f, Handles... handles)
+	{
+		static_assert(sizeof...(Handles) > 0);
+		for (auto& arch : s.archetypes)
+		{
+			const auto columns = std::tuple{
+				arch.template find_column<typename Handles::field_type>(handles.id, handles.key)...
+			};
+
+			const auto has_columns = std::apply([](const auto... c) noexcept {
+				return ((c != nullptr) && ...);
+				}, columns);
+
+			if (!has_columns)
+				continue;
+
+			const auto chunks = arch.chunk_count();
+			for (auto i = std::size_t{}; i < chunks; ++i)
+			{
+				const auto rows = arch.occupied_rows(i);
+				if (rows == std::uint64_t{})
+					continue;
+
+				std::apply([&](const auto... c) {
+					auto chunk = archetype_chunk<typename Handles::field_type...>{
+						arch.object_type(), rows, arch.chunk_entities(i), c->chunk_data(i)...
+					};
+					std::invoke(f, chunk);
+					return;
+					}, columns);
+			}
+		}
+
+		return;
+	}
+
+	namespace detail
+	{
+		template<typename T>
+		void destroy_level_local(void* p) noexcept
+		{
+			delete static_cast<T*>(p);
+			return;
+		}
+
+		template<typename T>
+		level_local_handle<T> find_level_local_handle(const unique_id id)
+		{
+			// games that don't use handles skip the registry lock and lookup
+			if (hades::detail::level_local_count() == std::size_t{})
+				return {};
+
+			const auto local = hades::detail::find_level_local(id, &hades::detail::level_local_type_tag<T>);
+			if (local)
+				return { local->slot };
+			return {};
+		}
+
+		template<typename T, typename GameSystem>
+		hades::detail::level_local_slot& get_level_local_slot(const level_local_handle<T> h, extra_state<GameSystem>& extras)
+		{
+			assert(h.slot != std::numeric_limits<std::size_t>::max());
+			auto& slots = extras.level_local_slots;
+			// slots are made for every registered handle when a level is loaded
+			//	this only happens if a handle was made after this level was created
+			//	other systems may be holding slot references during a concurrent tick
+			//	but level locals can't be used then, see: declare_system_access
+			if (h.slot >= size(slots))
+			{
+				assert(!hades::detail::try_get_game_data_ptr() ||
+					!hades::detail::try_get_game_data_ptr()->concurrent_tick);
+				slots.resize(h.slot + 1);
+			}
+			return slots[h.slot];
+		}
+	}
+
+	template<typename T>
+	level_local_handle<T> make_level_local_handle(const unique_id id)
+	{
+		return { hades::detail::register_level_local(id, &hades::detail::level_local_type_tag<T>) };
+	}
+
+	template<typename T, typename GameSystem>
+	T& get_level_local_ref(const level_local_handle<T> h, extra_state<GameSystem>& extras)
+	{
+		auto& slot = detail::get_level_local_slot(h, extras);
+		if (!slot.value)
+		{
+			static_assert(std::is_default_constructible_v<T>);
+			slot.value = { new T{}, &detail::destroy_level_local<T> };
+			slot.type = &hades::detail::level_local_type_tag<T>;
+		}
+
+		assert(slot.type == &hades::detail::level_local_type_tag<T>);
+		return *static_cast<T*>(slot.value.get());
+	}
+
+	template<typename T, typename GameSystem>
+	const T& get_level_local_ref(const level_local_handle<T> h, const extra_state<GameSystem>& extras)
+	{
+		assert(h.slot != std::numeric_limits<std::size_t>::max());
+		const auto& slots = extras.level_local_slots;
+		if (h.slot >= size(slots) || !slots[h.slot].value)
+			throw level_local_not_found{ "Level local not found" };
+
+		const auto& slot = slots[h.slot];
+		assert(slot.type == &hades::detail::level_local_type_tag<T>);
+		return *static_cast<const T*>(slot.value.get());
+	}
+
+	template<typename T, typename GameSystem>
+	void set_level_local_value(const level_local_handle<T> h, std::type_identity_t<T> value, extra_state<GameSystem>& extras)
+	{
+		auto& slot = detail::get_level_local_slot(h, extras);
+		if (slot.value)
+		{
+			assert(slot.type == &hades::detail::level_local_type_tag<T>);
+			*static_cast<T*>(slot.value.get()) = std::move(value);
+		}
+		else
+		{
+			slot.value = { new T{ std::move(value) }, &detail::destroy_level_local<T> };
+			slot.type = &hades::detail::level_local_type_tag<T>;
+		}
+		return;
+	}
+
 	template<typename T, typename GameSystem>
 	T& get_level_local_ref(const unique_id id, extra_state<GameSystem>& extras)
 	{
+		if (const auto h = detail::find_level_local_handle<T>(id);
+			h.slot != std::numeric_limits<std::size_t>::max())
+			return get_level_local_ref(h, extras);
+
         auto val = extras.level_locals.template try_get<T>(id);
 		if (val) return *val;
 
@@ -664,6 +1207,10 @@ namespace hades::state_api
 	template<typename T, typename GameSystem>
 	const T& get_level_local_ref(unique_id id, const extra_state<GameSystem>& extra)
 	{
+		if (const auto h = detail::find_level_local_handle<T>(id);
+			h.slot != std::numeric_limits<std::size_t>::max())
+			return get_level_local_ref(h, extra);
+
 		try
 		{
             return extra.level_locals.template get_ref<T>(id);
@@ -681,7 +1228,74 @@ namespace hades::state_api
 	template<typename T, typename GameSystem>
 	void set_level_local_value(const unique_id id, T value, extra_state<GameSystem>& extras)
 	{
+		if (const auto h = detail::find_level_local_handle<T>(id);
+			h.slot != std::numeric_limits<std::size_t>::max())
+			return set_level_local_value(h, std::move(value), extras);
+
 		extras.level_locals.set(any_map<unique_id>::allow_overwrite, id, std::move(value));
 		return;
 	}
 }
+
+namespace hades::detail
+{
+	template<typename Pred>
+	void object_time_map::erase_if(Pred&& pred)
+	{
+		if (std::erase_if(_times, pred) == 0)
+			return;
+
+		std::erase_if(_by_time, [this](const std::pair<time_point, entity_id>& entry) {
+			return !_times.contains(entry.second);
+			});
+		return;
+	}
+
+	template<typename Func>
+	void object_time_map::for_each_after(const time_point t, Func&& f) const
+	{
+		const auto first = std::upper_bound(std::begin(_by_time), std::end(_by_time), t,
+			[](const time_point t, const std::pair<time_point, entity_id>& entry) noexcept {
+				return t < entry.first;
+			});
+
+		for (auto iter = first; iter != std::end(_by_time); ++iter)
+			std::invoke(f, iter->second, iter->first);
+		return;
+	}
+
+	template<typename Field>
+	struct field_curve_info;
+
+	template<template<typename> typename CurveType, typename T>
+	struct field_curve_info<state_field<CurveType<T>>>
+	{
+		static constexpr auto value = get_curve_info<CurveType, T>();
+	};
+
+	template<typename Field>
+	archetype_column<Field>* archetype::find_column(const variable_id v) noexcept
+	{
+		const auto column = find_column(v);
+		if (column && column->info == field_curve_info<Field>::value)
+			return static_cast<archetype_column<Field>*>(column);
+		return nullptr;
+	}
+
+	template<typename Field>
+	archetype_column<Field>* archetype::find_column(const variable_id v, const std::size_t curve_key) noexcept
+	{
+		const auto& slots = _object_type->variable_key_slots;
+		if (curve_key < std::size(slots))
+		{
+			const auto slot = slots[curve_key];
+			if (slot < std::size(_columns) && _columns[slot]->id == v)
+			{
+				assert(_columns[slot]->info == field_curve_info<Field>::value);
+				return static_cast<archetype_column<Field>*>(_columns[slot].get());
+			}
+		}
+
+		return find_column<Field>(v);
+	}
+}
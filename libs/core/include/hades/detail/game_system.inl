@@ -22,7 +22,7 @@ namespace hades
 
 			const auto new_system = hades::data::get<SystemResource>(sys);
 			sys_r.emplace_back(new_system);
-            return systems.emplace_back(System{ new_system, {}, {}, {}, {} });
+            return systems.emplace_back(System{ new_system });
 		}
 
 		template<typename SystemResource, typename System>
@@ -39,11 +39,96 @@ namespace hades
 		}
 	}
 
+	namespace detail
+	{
+		// comparison for keeping sleeping_ents as a min heap
+		struct activates_later
+		{
+			bool operator()(const object_time& a, const object_time& b) const noexcept
+			{
+				return a.next_activation > b.next_activation;
+			}
+		};
+
+		inline bool is_attached(const name_list& ents, object_ref e) noexcept
+		{
+			return std::ranges::find_if(ents, [e](auto&& ent) {
+				return ent.object == e;
+				}) != std::end(ents);
+		}
+	}
+
+	namespace detail
+	{
+		// returns true if the two systems cannot be ticked at the same time
+		template<typename SystemResource>
+		inline bool systems_conflict(const SystemResource& a, const SystemResource& b) noexcept
+		{
+			if constexpr (std::is_same_v<SystemResource, resources::system>)
+			{
+				if (!a.access_declared || !b.access_declared)
+					return true;
+
+				const auto writes_to = [](const SystemResource& w, const SystemResource& other) noexcept {
+					return std::ranges::any_of(w.write_curves, [&other](const unique_id c) noexcept {
+						return std::ranges::find(other.read_curves, c) != std::end(other.read_curves)
+							|| std::ranges::find(other.write_curves, c) != std::end(other.write_curves);
+						});
+				};
+
+				return writes_to(a, b) || writes_to(b, a);
+			}
+			else
+			{
+				// render systems all share the render output
+				return true;
+			}
+		}
+	}
+
+	template<typename SystemType>
+	inline const std::vector<typename system_behaviours<SystemType>::tick_stage>&
+		system_behaviours<SystemType>::get_tick_schedule()
+	{
+		if (_scheduled_systems == size(_systems))
+			return _tick_schedule;
+
+		// each system is placed in the stage after the last
+		// system it conflicts with, this keeps conflicting systems
+		// in their installed order
+		// systems without a tick function are left out of the schedule
+		_tick_schedule.clear();
+		const auto system_count = size(_systems);
+		auto stages = std::vector<std::size_t>(system_count, std::size_t{});
+		for (auto i = std::size_t{}; i < system_count; ++i)
+		{
+			if (!_systems[i].system->tick)
+				continue;
+
+			auto stage = std::size_t{};
+			for (auto j = std::size_t{}; j < i; ++j)
+			{
+				if (_systems[j].system->tick && stages[j] >= stage &&
+					detail::systems_conflict(*_systems[i].system, *_systems[j].system))
+					stage = stages[j] + 1;
+			}
+
+			stages[i] = stage;
+			if (stage == size(_tick_schedule))
+				_tick_schedule.emplace_back();
+			_tick_schedule[stage].emplace_back(&_systems[i]);
+		}
+
+		_scheduled_systems = system_count;
+		return _tick_schedule;
+	}
+
 	template<typename SystemType>
 	inline void system_behaviours<SystemType>::set_attached(unique_id i, name_list c)
 	{
 		auto& s = detail::find_system(i, _systems, _new_systems);
 		s.attached_entities = std::move(c);
+		s.sleeping_ents.clear();
 		return;
 	}
 
@@ -61,35 +146,29 @@ namespace hades
 			std::sort(std::begin(prev), std::end(prev));
 			std::sort(std::begin(next), std::end(next));
 
-			static auto output = resources::curve_types::collection_object_ref{};
-			output.clear();
-
+			// the lists are cleared rather than replaced, so they keep their memory
+			// new ents is the ents that have been added since last time
+			s.new_ents.clear();
 			std::set_difference(std::begin(next), std::end(next),
 				std::begin(prev), std::end(prev),
-				std::back_inserter(output));
-
-			// new ents is the ents that have been added since last time
-			s.new_ents = std::move(output);
-
-			output.clear();
+				std::back_inserter(s.new_ents));
 
+			//removed ents is the ents that have been destroyed
+			s.removed_ents.clear();
 			std::set_difference(std::begin(prev), std::end(prev),
 				std::begin(next), std::end(next),
-				std::back_inserter(output));
-
-			//removed ents is the ents that have been destroyed
-			s.removed_ents = std::move(output);
+				std::back_inserter(s.removed_ents));
 		}
 
 		return;
 	}
 
 	template<typename SystemType>
-	inline name_list system_behaviours<SystemType>::get_new_entities(SystemType &sys)
+	inline frame_name_list system_behaviours<SystemType>::get_new_entities(SystemType &sys, std::pmr::memory_resource* m)
 	{
 		// preserve the capacity of sys.new_ents
 		// out will only allocate as much as it needs
-		auto out = sys.new_ents;
+		auto out = frame_name_list{ begin(sys.new_ents), end(sys.new_ents), m };
 
 		//add the new ents to attached ents
 		sys.attached_entities.insert(end(sys.attached_entities),
@@ -100,30 +179,83 @@ namespace hades
 	}
 
 	template<typename SystemType>
-	inline name_list system_behaviours<SystemType>::get_created_entities(SystemType& sys)
+	inline frame_name_list system_behaviours<SystemType>::get_created_entities(SystemType& sys, std::pmr::memory_resource* m)
 	{
-		return std::exchange(sys.created_ents, {});
+		auto out = frame_name_list{ begin(sys.created_ents), end(sys.created_ents), m };
+		sys.created_ents.clear();
+		return out;
 	}
 
 	template<typename SystemType>
-	inline name_list& system_behaviours<SystemType>::get_entities(SystemType& sys) const
+	inline name_list& system_behaviours<SystemType>::get_entities(SystemType& sys)
 	{
+		sys.attached_entities.insert(end(sys.attached_entities),
+			begin(sys.sleeping_ents), end(sys.sleeping_ents));
+		sys.sleeping_ents.clear();
 		return sys.attached_entities;
 	}
 
 	template<typename SystemType>
-	inline name_list system_behaviours<SystemType>::get_removed_entities(SystemType &sys)
+	inline name_list& system_behaviours<SystemType>::get_active_entities(SystemType& sys, time_point t)
 	{
-		const auto iter = std::partition(begin(sys.attached_entities),
-			end(sys.attached_entities), [&s = sys.removed_ents](auto& o) {
+		auto& attached = sys.attached_entities;
+		auto& sleeping = sys.sleeping_ents;
+		const auto later = detail::activates_later{};
+
+		// move entities that went to sleep since the last tick onto the heap
+		// the remaining entities keep their order
+		auto out = begin(attached);
+		for (auto& ent : attached)
+		{
+			if (ent.next_activation > t)
+			{
+				sleeping.emplace_back(ent);
+				std::ranges::push_heap(sleeping, later);
+			}
+			else
+				*out++ = ent;
+		}
+		attached.erase(out, end(attached));
+
+		// wake the entities that are due
+		while (!std::empty(sleeping) && sleeping.front().next_activation <= t)
+		{
+			std::ranges::pop_heap(sleeping, later);
+			attached.emplace_back(sleeping.back());
+			sleeping.pop_back();
+		}
+
+		return attached;
+	}
+
+	template<typename SystemType>
+	inline frame_name_list system_behaviours<SystemType>::get_removed_entities(SystemType &sys, std::pmr::memory_resource* m)
+	{
+		const auto is_kept = [&s = sys.removed_ents](auto& o) {
 			return end(s) == std::find(begin(s), end(s), o);
-		});
-		sys.removed_ents.clear();
+		};
+
+		const auto iter = std::partition(begin(sys.attached_entities),
+			end(sys.attached_entities), is_kept);
 
 		// get the removed group, so we can call disconnect on them
-		auto out = name_list{ iter, end(sys.attached_entities) };
+		auto out = frame_name_list{ iter, end(sys.attached_entities), m };
 		sys.attached_entities.erase(iter, end(sys.attached_entities));
-		
+
+		// sleeping entities can also be removed
+		if (!std::empty(sys.sleeping_ents) && !std::empty(sys.removed_ents))
+		{
+			const auto sleep_iter = std::partition(begin(sys.sleeping_ents),
+				end(sys.sleeping_ents), is_kept);
+			if (sleep_iter != end(sys.sleeping_ents))
+			{
+				out.insert(end(out), sleep_iter, end(sys.sleeping_ents));
+				sys.sleeping_ents.erase(sleep_iter, end(sys.sleeping_ents));
+				std::ranges::make_heap(sys.sleeping_ents, detail::activates_later{});
+			}
+		}
+
+		sys.removed_ents.clear();
 		return out;
 	}
 
@@ -135,15 +267,33 @@ namespace hades
 
 		// if entitys can have systems attached twice there must be a bug in the game_state
 		// code that creates or load objects
-		assert(std::ranges::find_if(system.attached_entities, [entity](auto&& ent) {
-			return ent.object == entity;
-			}) == system.attached_entities.end());
+		assert(!detail::is_attached(system.attached_entities, entity) &&
+			!detail::is_attached(system.sleeping_ents, entity));
 
 		system.new_ents.emplace_back(typename name_list::value_type{ entity, time_point::min() });
 		_dirty_systems = true;
 		return;
 	}
 
+	template<typename SystemType>
+	inline void system_behaviours<SystemType>::attach_system(const std::span<const object_ref> entities, const unique_id sys)
+	{
+		if (std::empty(entities))
+			return;
+
+		auto& system = detail::find_system<typename SystemType::system_t>(sys, _systems, _new_systems);
+		system.new_ents.reserve(size(system.new_ents) + size(entities));
+		for (const auto& entity : entities)
+		{
+			assert(!detail::is_attached(system.attached_entities, entity) &&
+				!detail::is_attached(system.sleeping_ents, entity));
+			system.new_ents.emplace_back(typename name_list::value_type{ entity, time_point::min() });
+		}
+
+		_dirty_systems = true;
+		return;
+	}
+
 	template<typename SystemType>
 	inline void system_behaviours<SystemType>::attach_system_from_load(object_ref entity, unique_id sys)
 	{
@@ -155,11 +305,8 @@ namespace hades
 		// NOTE: systems aren't stored in save files anymore, duplicate systems
 		//		 should be handled gracefully by the object loader.
 		//		 This is to catch errors that slip through.
-		auto found = std::find_if(ent_list.begin(), ent_list.end(), [entity](auto&& ent) {
-			return ent.object == entity;
-			});
-
-		if (found != ent_list.end())
+		if (detail::is_attached(ent_list, entity) ||
+			detail::is_attached(system.sleeping_ents, entity))
 		{
 			const auto message = "The requested entityid is already attached to this system. EntityId: "
 				+ to_string(entity) + ", System: " + to_string(sys);
@@ -211,6 +358,8 @@ namespace hades
 	{
 		auto& sys = detail::find_system(s, _systems, _new_systems);
 		// TODO: this might be a perf issue
+		// entities that go to sleep are moved out of attached_entities
+		// the next time the system is ticked, see: get_active_entities
 		for (auto& [entity, time] : sys.attached_entities)
 		{
 			if (e == entity)
@@ -220,6 +369,16 @@ namespace hades
 			}
 		}
 
+		for (auto& [entity, time] : sys.sleeping_ents)
+		{
+			if (e == entity)
+			{
+				time = b;
+				std::ranges::make_heap(sys.sleeping_ents, detail::activates_later{});
+				return;
+			}
+		}
+
 		throw system_error{ "Tried to sleep an entity from a system they weren't attached too" };
 		return;
 	}
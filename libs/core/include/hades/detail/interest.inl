@@ -0,0 +1,69 @@
+#include "hades/interest.hpp"
+
+#include <algorithm>
+
+namespace hades::state_api
+{
+	template<typename GameSystem>
+	void export_changes(const time_point since, const interest_changes& changes, const game_state& s,
+		const extra_state<GameSystem>& e, exported_curves& out)
+	{
+		out.clear();
+		out.since = since;
+
+		for (const auto id : changes.entered)
+		{
+			// erased objects can't be sent
+			const auto obj = e.objects.find(id);
+			if (!obj)
+				continue;
+
+			assert(obj->object_type);
+			const auto created = s.object_creation_time.find(id);
+			const auto creation_time = created == std::end(s.object_creation_time) ? time_point{} : created->second;
+			out.created_objects.emplace_back(exported_curves::exported_object{ id, obj->object_type->id, creation_time });
+			detail::export_object_curves(*obj, since, out, true);
+		}
+
+		for (const auto id : changes.stayed)
+		{
+			const auto obj = e.objects.find(id);
+			if (obj)
+				detail::export_object_curves(*obj, since, out);
+		}
+
+		out.left_objects = changes.left;
+
+		// entered objects need their destruction time even if it was set before since
+		for (const auto id : changes.entered)
+		{
+			const auto destroyed = s.object_destruction_time.find(id);
+			if (destroyed != std::end(s.object_destruction_time))
+				out.destroyed_objects.emplace_back(id, destroyed->second);
+		}
+
+		s.object_destruction_time.for_each_after(since, [&changes, &out](const entity_id id, const time_point t) {
+			const auto listed = [id](const std::vector<entity_id>& list) noexcept {
+				return std::binary_search(begin(list), end(list), id);
+			};
+
+			if (listed(changes.stayed) || listed(changes.left))
+				out.destroyed_objects.emplace_back(id, t);
+			return;
+			});
+
+		for (const auto& [name, curve] : s.names)
+		{
+			const auto& keyframes = curve.keyframes();
+			const auto first = std::upper_bound(std::begin(keyframes), std::end(keyframes), since, [](const time_point t, const auto& k) noexcept {
+				return t < k.time;
+				});
+
+			for (auto iter = first; iter != std::end(keyframes); ++iter)
+				out.entity_names.emplace_back(exported_curves::exported_name{ name, iter->time, iter->value.id });
+		}
+
+		detail::sort_exported_curves(out);
+		return;
+	}
+}
@@ -1,5 +1,7 @@
 #include "hades/level_interface.hpp"
 
+#include "hades/allocation_counter.hpp"
+#include "hades/async.hpp"
 #include "hades/properties.hpp"
 #include "hades/console_variables.hpp"
 #include "hades/players.hpp"
@@ -17,6 +19,144 @@ namespace hades
 		{
 			return set_render_data(d);
 		}
+
+		template<typename JobDataType>
+		std::pmr::memory_resource* get_frame_memory(const JobDataType& d) noexcept
+		{
+			return d.frame_memory ? d.frame_memory : std::pmr::get_default_resource();
+		}
+	}
+
+	namespace detail
+	{
+		template<typename JobDataType, typename SystemType>
+		JobDataType make_tick_job_data(const JobDataType& job_data, SystemType& s)
+		{
+			auto& sys_behaviours = *job_data.systems;
+			auto game_data = job_data;
+			game_data.entity = activated_object_view{ sys_behaviours.get_active_entities(s, job_data.current_time), job_data.current_time };
+			game_data.system = s.system->id;
+			game_data.system_data = &sys_behaviours.get_system_data(s);
+			return game_data;
+		}
+
+		// a system being ticked on the thread pool by tick_stage
+		template<typename JobDataType>
+		struct stage_job
+		{
+			JobDataType game_data;
+			const std::function<void()>* tick = nullptr;
+			// allocations are counted the same as on the thread that queued the job
+			allocation_counter* allocations = nullptr;
+			std::exception_ptr error;
+			std::atomic_bool done = false;
+		};
+
+		// tick every system in the stage, the first system is ticked on this thread
+		// and the rest are queued on the thread pool
+		// returns after all the systems have finished
+		//	the jobs are kept in frame memory, and only their address is queued
+		//	so a warmed up stage doesn't touch the heap
+		template<typename JobDataType, typename SystemType>
+		void tick_stage(const JobDataType& job_data, const std::vector<SystemType*>& stage)
+		{
+			const auto frame_memory = get_frame_memory(job_data);
+			// NOTE: job data must be created on this thread
+			//		get_active_entities updates the systems entity lists
+			auto jobs = std::pmr::vector<stage_job<JobDataType>>(size(stage) - 1, frame_memory);
+
+			// each system records the curves it writes into its own buffer,
+			// they're merged in stage order once every system has finished
+			auto dirty_curves = std::span<std::vector<dirty_curve>>{};
+			if constexpr (std::is_same_v<JobDataType, system_job_data>)
+			{
+				if (job_data.extra && job_data.extra->dirty_curves.enabled)
+				{
+					auto& buffers = job_data.extra->dirty_curves.stage_buffers;
+					if (size(buffers) < size(stage))
+						buffers.resize(size(stage));
+					dirty_curves = std::span{ buffers }.first(size(stage));
+					for (auto& buffer : dirty_curves)
+						buffer.clear();
+				}
+			}
+
+			for (auto i = std::size_t{}; i < size(jobs); ++i)
+			{
+				auto& system = *stage[i + 1];
+				auto& job = jobs[i];
+				job.game_data = make_tick_job_data(job_data, system);
+				job.tick = &system.system->tick;
+				job.allocations = current_allocation_counter();
+				if constexpr (std::is_same_v<JobDataType, system_job_data>)
+				{
+					job.game_data.concurrent_tick = true;
+					job.game_data.write_curves = &system.system->write_curves;
+					if (!std::empty(dirty_curves))
+						job.game_data.dirty_curves = &dirty_curves[i + 1];
+				}
+
+				detached_async([&job]() noexcept {
+					{
+						const auto counter = allocation_counter_scope{ job.allocations };
+						try
+						{
+							set_data(&job.game_data);
+							std::invoke(*job.tick);
+						}
+						catch (...)
+						{
+							job.error = std::current_exception();
+						}
+					}
+					// the job belongs to tick_stage once this is set
+					std::atomic_store_explicit(&job.done, true, std::memory_order_release);
+					return;
+					});
+			}
+
+			auto game_data = make_tick_job_data(job_data, *stage.front());
+			if constexpr (std::is_same_v<JobDataType, system_job_data>)
+			{
+				game_data.concurrent_tick = true;
+				game_data.write_curves = &stage.front()->system->write_curves;
+				if (!std::empty(dirty_curves))
+					game_data.dirty_curves = &dirty_curves.front();
+			}
+
+			// wait for all the systems to finish before passing on errors
+			auto error = std::exception_ptr{};
+			try
+			{
+				set_data(&game_data);
+				std::invoke(stage.front()->system->tick);
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+
+			for (auto& job : jobs)
+			{
+				help_until(job.done);
+				if (!error)
+					error = job.error;
+			}
+
+			if (!std::empty(dirty_curves))
+			{
+				auto& journal = job_data.extra->dirty_curves.current;
+				for (auto& d : dirty_curves)
+				{
+					journal.insert(end(journal), begin(d), end(d));
+					d.clear();
+				}
+			}
+
+			if (error)
+				std::rethrow_exception(error);
+			return;
+		}
 	}
 
 	// this is called before and after level update. this ensures that after a game tick, all objects have
@@ -29,11 +169,12 @@ namespace hades
 
 		assert(jdata.systems);
 		auto& sys_behaviours = *jdata.systems;
+		const auto frame_memory = detail::get_frame_memory(jdata);
 
 		while (sys_behaviours.needs_update())
 		{
 			const auto new_systems = sys_behaviours.get_new_systems();
-			const auto systems = sys_behaviours.get_systems();
+			const auto systems = sys_behaviours.get_systems(frame_memory);
 			for (const auto s : new_systems)
 			{
 				assert(s);
@@ -55,12 +196,12 @@ namespace hades
 				//pass entities that are already attached to this system
 				//this will be entities that were already in the level file
 				//or save file before this time point
-				auto current_ents = sys_behaviours.get_created_entities(*system);
+				auto current_ents = sys_behaviours.get_created_entities(*system, frame_memory);
 
 				auto game_data = jdata;
 				game_data.entity = { current_ents, time_point::min() };
 				game_data.system = s->id;
-				game_data.system_data = &sys_behaviours.get_system_data(s->id);
+				game_data.system_data = &sys_behaviours.get_system_data(*system);
 
 				detail::set_data(&game_data);
 				std::invoke(s->on_create);
@@ -69,11 +210,11 @@ namespace hades
 			// on connect
 			for (auto& s : systems)
 			{
-				auto ents = sys_behaviours.get_new_entities(*s);
+				auto ents = sys_behaviours.get_new_entities(*s, frame_memory);
 
 				if (s->system->on_connect && !std::empty(ents))
 				{
-					auto& sys_data = sys_behaviours.get_system_data(s->system->id);
+					auto& sys_data = sys_behaviours.get_system_data(*s);
 					auto game_data = jdata;
 					game_data.entity = activated_object_view{ ents, time_point::min() };
 					game_data.system = s->system->id;
@@ -87,11 +228,11 @@ namespace hades
 			// on disconnect
 			for (auto s : systems)
 			{
-				auto ents = sys_behaviours.get_removed_entities(*s);
+				auto ents = sys_behaviours.get_removed_entities(*s, frame_memory);
 
 				if (s->system->on_disconnect && !std::empty(ents))
 				{
-					auto& sys_data = sys_behaviours.get_system_data(s->system->id);
+					auto& sys_data = sys_behaviours.get_system_data(*s);
 					auto game_data = jdata;
 					game_data.entity = activated_object_view{ ents, time_point::min() };
 					game_data.system = s->system->id;
@@ -149,29 +290,33 @@ namespace hades
 		}
 
 		auto& sys_behaviours = *job_data.systems;
-		const auto systems = sys_behaviours.get_systems();
+		const auto& schedule = sys_behaviours.get_tick_schedule();
 
 		//call on_tick for systems
-		for (auto* s : systems)
+		// systems that share a stage are ticked at the same time
+		for (const auto& stage : schedule)
 		{
-			if (!s->system->tick)
-				continue;
-
-			auto& current_ents = sys_behaviours.get_entities(*s);
-
-			auto& sys_data = sys_behaviours.get_system_data(s->system->id);
-			auto game_data = job_data;
-			game_data.entity = activated_object_view{ current_ents, current_time };
-			game_data.system = s->system->id;
-			game_data.system_data = &sys_data;
-
-			detail::set_data(&game_data);
-			std::invoke(s->system->tick);
+			assert(!std::empty(stage));
+			if (size(stage) == 1)
+			{
+				auto game_data = detail::make_tick_job_data(job_data, *stage.front());
+				detail::set_data(&game_data);
+				std::invoke(stage.front()->system->tick);
+			}
+			else
+				detail::tick_stage(job_data, stage);
 		}
 
 		//update systems again, to ensure that everything has been properly called,
 		//before a possible save
 		update_systems(job_data);
+
+		if constexpr (std::is_same_v<JobDataType, system_job_data>)
+		{
+			if (job_data.extra)
+				state_api::finish_dirty_tick(*job_data.extra);
+		}
+
 		return current_time;
 	}
 }
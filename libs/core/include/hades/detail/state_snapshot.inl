@@ -0,0 +1,296 @@
+#include "hades/state_snapshot.hpp"
+
+#include <algorithm>
+
+namespace hades
+{
+	namespace detail
+	{
+		inline std::size_t snapshot_chunk_index(const entity_id id) noexcept
+		{
+			return integer_cast<std::size_t>(to_value(id)) / snapshot_chunk_size;
+		}
+
+		inline bool same_name_list(const name_list& l, const name_list& r) noexcept
+		{
+			return std::ranges::equal(l, r, [](const object_time& a, const object_time& b) noexcept {
+				return a.object.id == b.object.id && a.next_activation == b.next_activation;
+				});
+		}
+
+		template<typename SystemType>
+		bool same_system_lists(const snapshot_system<SystemType>& saved, const SystemType& sys) noexcept
+		{
+			return saved.system == sys.system &&
+				same_name_list(saved.attached_entities, sys.attached_entities) &&
+				same_name_list(saved.sleeping_ents, sys.sleeping_ents) &&
+				same_name_list(saved.new_ents, sys.new_ents) &&
+				same_name_list(saved.created_ents, sys.created_ents) &&
+				same_name_list(saved.removed_ents, sys.removed_ents);
+		}
+	}
+
+	template<typename SystemType>
+	const std::shared_ptr<const detail::snapshot_object>* state_snapshot<SystemType>::find(const entity_id id) const noexcept
+	{
+		const auto index = detail::snapshot_chunk_index(id);
+		if (index >= size(chunks) || !chunks[index])
+			return nullptr;
+
+		const auto& objects = chunks[index]->objects;
+		const auto iter = std::lower_bound(begin(objects), end(objects), id, [](const auto& o, const entity_id id) noexcept {
+			return o->id < id;
+			});
+
+		if (iter == end(objects) || (*iter)->id != id)
+			return nullptr;
+		return &*iter;
+	}
+
+	namespace state_api
+	{
+		template<typename GameSystem>
+		state_snapshot<GameSystem> take_snapshot(const time_point t, const game_state& s,
+			const extra_state<GameSystem>& e, const state_snapshot<GameSystem>* previous)
+		{
+			using object_ptr = std::shared_ptr<const hades::detail::snapshot_object>;
+			using hades::detail::snapshot_chunk_index;
+
+			auto out = state_snapshot<GameSystem>{ t, s.next_id };
+
+			// visit the objects in id order, so they can be sorted into chunks
+			auto objects = std::vector<const game_obj*>{};
+			objects.reserve(e.objects.size());
+			for (const auto& o : e.objects)
+				objects.emplace_back(&o);
+			std::sort(begin(objects), end(objects), [](const game_obj* l, const game_obj* r) noexcept {
+				return l->id < r->id;
+				});
+
+			if (!empty(objects))
+				out.chunks.resize(snapshot_chunk_index(objects.back()->id) + 1);
+
+			auto first = begin(objects);
+			const auto last = end(objects);
+			while (first != last)
+			{
+				const auto index = snapshot_chunk_index((*first)->id);
+				const auto prev_chunk = previous && index < size(previous->chunks) ?
+					previous->chunks[index] : nullptr;
+
+				auto chunk = std::vector<object_ptr>{};
+				auto changed = !prev_chunk;
+				for (; first != last && snapshot_chunk_index((*first)->id) == index; ++first)
+				{
+					const auto prev_obj = previous ? previous->find((*first)->id) : nullptr;
+					auto obj = detail::take_object_snapshot(**first, s, prev_obj ? *prev_obj : object_ptr{});
+					changed = changed || !prev_obj || obj != *prev_obj;
+					chunk.emplace_back(std::move(obj));
+				}
+
+				changed = changed || size(chunk) != size(prev_chunk->objects);
+				if (changed)
+					out.chunks[index] = std::make_shared<const hades::detail::snapshot_chunk>(
+						hades::detail::snapshot_chunk{ std::move(chunk) });
+				else
+					out.chunks[index] = prev_chunk;
+			}
+
+			out.names = detail::take_names_snapshot(s.names, previous ? previous->names : nullptr);
+
+			// systems are never uninstalled, so each system is in the same position in every snapshot
+			const auto systems = e.systems.get_systems();
+			out.systems.reserve(size(systems));
+			for (const auto sys : systems)
+			{
+				const auto i = size(out.systems);
+				if (previous && i < size(previous->systems) &&
+					hades::detail::same_system_lists(*previous->systems[i], *sys))
+				{
+					out.systems.emplace_back(previous->systems[i]);
+					continue;
+				}
+
+				out.systems.emplace_back(std::make_shared<const hades::detail::snapshot_system<GameSystem>>(
+					hades::detail::snapshot_system<GameSystem>{ sys->system, sys->attached_entities,
+					sys->sleeping_ents, sys->new_ents, sys->created_ents, sys->removed_ents }));
+			}
+
+			return out;
+		}
+
+		template<typename GameSystem>
+		state_snapshot<GameSystem> take_snapshot(const time_point t, const game_state& s, const extra_state<GameSystem>& e,
+			const state_snapshot<GameSystem>& previous, const std::span<const entity_id> changed)
+		{
+			using object_ptr = std::shared_ptr<const hades::detail::snapshot_object>;
+			using hades::detail::snapshot_chunk_index;
+
+			// the changed objects, and anything created since the previous snapshot, in id order
+			auto touched = std::vector<entity_id>{ begin(changed), end(changed) };
+			// next_id is the last id that was given out
+			for (auto id = next(previous.next_id); !(s.next_id < id); id = next(id))
+				touched.emplace_back(id);
+			std::sort(begin(touched), end(touched));
+			touched.erase(std::unique(begin(touched), end(touched)), end(touched));
+
+			auto out = state_snapshot<GameSystem>{ t, s.next_id };
+			out.chunks = previous.chunks;
+			if (!empty(touched))
+				out.chunks.resize(std::max(size(out.chunks), snapshot_chunk_index(touched.back()) + 1));
+
+			auto first = begin(touched);
+			const auto last = end(touched);
+			while (first != last)
+			{
+				// rebuild this chunk, merging the touched ids with the objects already in it
+				const auto index = snapshot_chunk_index(*first);
+				const auto& prev_chunk = out.chunks[index];
+				const auto prev_objects = prev_chunk ? std::span{ prev_chunk->objects } : std::span<const object_ptr>{};
+				auto prev_iter = begin(prev_objects);
+				const auto prev_end = end(prev_objects);
+
+				auto chunk = std::vector<object_ptr>{};
+				chunk.reserve(size(prev_objects) + 1);
+				auto changed_chunk = false;
+				for (; first != last && snapshot_chunk_index(*first) == index; ++first)
+				{
+					for (; prev_iter != prev_end && (*prev_iter)->id < *first; ++prev_iter)
+						chunk.emplace_back(*prev_iter);
+
+					const auto prev_obj = prev_iter != prev_end && (*prev_iter)->id == *first ?
+						*prev_iter++ : object_ptr{};
+
+					const auto o = e.objects.find(*first);
+					if (!o)
+					{
+						// erased, or an id that was never used
+						changed_chunk = changed_chunk || prev_obj;
+						continue;
+					}
+
+					auto obj = detail::take_object_snapshot(*o, s, prev_obj);
+					changed_chunk = changed_chunk || obj != prev_obj;
+					chunk.emplace_back(std::move(obj));
+				}
+
+				if (!changed_chunk)
+					continue;
+
+				chunk.insert(end(chunk), prev_iter, prev_end);
+				if (empty(chunk))
+					out.chunks[index] = nullptr;
+				else
+					out.chunks[index] = std::make_shared<const hades::detail::snapshot_chunk>(
+						hades::detail::snapshot_chunk{ std::move(chunk) });
+			}
+
+			out.names = detail::take_names_snapshot(s.names, previous.names);
+
+			const auto systems = e.systems.get_systems();
+			out.systems.reserve(size(systems));
+			for (const auto sys : systems)
+			{
+				const auto i = size(out.systems);
+				if (i < size(previous.systems) &&
+					hades::detail::same_system_lists(*previous.systems[i], *sys))
+				{
+					out.systems.emplace_back(previous.systems[i]);
+					continue;
+				}
+
+				out.systems.emplace_back(std::make_shared<const hades::detail::snapshot_system<GameSystem>>(
+					hades::detail::snapshot_system<GameSystem>{ sys->system, sys->attached_entities,
+					sys->sleeping_ents, sys->new_ents, sys->created_ents, sys->removed_ents }));
+			}
+
+			return out;
+		}
+
+		template<typename GameSystem>
+		restored_objects restore_snapshot(const state_snapshot<GameSystem>& snap, game_state& s, extra_state<GameSystem>& e)
+		{
+			auto out = restored_objects{};
+
+			// roll back the objects that were in the snapshot
+			//	and collect the ones that weren't
+			auto erase_list = std::vector<game_obj*>{};
+			for (auto& o : e.objects)
+			{
+				const auto saved = snap.find(o.id);
+				if (!saved || !detail::restore_object_state(o, **saved, s))
+					erase_list.emplace_back(&o);
+			}
+
+			out.erased.reserve(size(erase_list));
+			for (const auto o : erase_list)
+			{
+				out.erased.emplace_back(o->id);
+				erase_object(*o, s, e);
+			}
+
+			// recreate objects that have been erased since the snapshot
+			for (const auto& chunk : snap.chunks)
+			{
+				if (!chunk)
+					continue;
+
+				for (const auto& saved : chunk->objects)
+				{
+					if (e.objects.find(saved->id))
+						continue;
+
+					const auto obj = e.objects.insert(game_obj{ saved->id, saved->object_type, {} });
+					assert(obj);
+					detail::assign_archetype_row(*obj, s);
+					detail::insert_object_state(*obj, *saved, s);
+					out.created.emplace_back(object_ref{ saved->id, obj });
+				}
+			}
+
+			// forget objects created after the snapshot, next_id is the last id that was given out
+			const auto created_later = [last = snap.next_id](const auto& entry) noexcept {
+				return last < entry.first;
+			};
+			s.object_creation_time.erase_if(created_later);
+			s.object_destruction_time.erase_if(created_later);
+			s.next_id = snap.next_id;
+			if (snap.names)
+				s.names = *snap.names;
+
+			auto systems = e.systems.get_systems();
+			for (auto i = std::size_t{}; i < size(systems); ++i)
+			{
+				auto& sys = *systems[i];
+				if (i < size(snap.systems) && snap.systems[i]->system == sys.system)
+				{
+					const auto& saved = *snap.systems[i];
+					sys.attached_entities = saved.attached_entities;
+					sys.sleeping_ents = saved.sleeping_ents;
+					sys.new_ents = saved.new_ents;
+					sys.created_ents = saved.created_ents;
+					sys.removed_ents = saved.removed_ents;
+				}
+				else
+				{
+					// installed after the snapshot was taken
+					sys.attached_entities.clear();
+					sys.sleeping_ents.clear();
+					sys.new_ents.clear();
+					sys.created_ents.clear();
+					sys.removed_ents.clear();
+				}
+
+				// recreated objects have moved
+				for (auto list : { &sys.attached_entities, &sys.sleeping_ents, &sys.new_ents,
+					&sys.created_ents, &sys.removed_ents })
+				{
+					for (auto& o : *list)
+						o.object.ptr = e.objects.find(o.object.id);
+				}
+			}
+
+			return out;
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#ifndef HADES_DETAIL_VARINT_HPP
+#define HADES_DETAIL_VARINT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// variable length integers shared by the exported curve and replay file formats
+//	7 bits per byte, the high bit is set on every byte except the last
+//	signed integers are zigzag encoded, so small negative numbers are also written in few bytes
+namespace hades::detail
+{
+	constexpr std::uint64_t zigzag_encode(const std::int64_t v) noexcept
+	{
+		return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+	}
+
+	constexpr std::int64_t zigzag_decode(const std::uint64_t v) noexcept
+	{
+		return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+	}
+
+	inline void write_varint(std::vector<std::byte>& b, std::uint64_t v)
+	{
+		while (v >= 0x80)
+		{
+			b.push_back(std::byte{ static_cast<std::uint8_t>(v | 0x80) });
+			v >>= 7;
+		}
+		b.push_back(std::byte{ static_cast<std::uint8_t>(v) });
+		return;
+	}
+
+	inline void write_signed(std::vector<std::byte>& b, const std::int64_t v)
+	{
+		write_varint(b, zigzag_encode(v));
+		return;
+	}
+
+	// ReadByte: std::uint8_t(), reports running out of bytes itself
+	// returns nullopt if the integer doesn't fit in 64 bits
+	template<typename ReadByte>
+	std::optional<std::uint64_t> read_varint(ReadByte&& read_byte)
+	{
+		auto out = std::uint64_t{};
+		for (auto shift = 0; shift < 64; shift += 7)
+		{
+			const std::uint8_t byte = read_byte();
+			out |= std::uint64_t{ byte & 0x7Fu } << shift;
+			if ((byte & 0x80) == 0)
+				return out;
+		}
+
+		return {};
+	}
+}
+
+#endif //HADES_DETAIL_VARINT_HPP
@@ -1,48 +1,146 @@
 #ifndef HADES_EXPORTCURVES_HPP
 #define HADES_EXPORTCURVES_HPP
 
+#include <cstddef>
+#include <span>
+#include <tuple>
+#include <vector>
+
 #include "hades/curve_extra.hpp"
+#include "hades/exceptions.hpp"
 #include "hades/level_interface.hpp"
 
 //Exported curves can be streamed into packets,
 //they can also be imported into GameRenderers
 //and into game instances in order to load from file
+
+// exported curves hold the keyframes that were added to a game_state after a point in time
+//	they are collected with state_api::export_changes, packed into bytes with
+//	write_exported_curves and applied to another copy of the state with state_api::apply_changes
 namespace hades
 {
-	//exported curves, need their type
-	// curve type
-	// entity and variable id's
-	// 
+	class export_error : public runtime_error
+	{
+	public:
+		using runtime_error::runtime_error;
+	};
+
+	// the keyframes of a single curve
+	template<typename T>
+	struct curve_export_set
+	{
+		using value_type = T;
+
+		entity_id entity = bad_entity;
+		variable_id variable = variable_id::zero;
+		//the client will use the style to create the curve if the object doesn't have it
+		keyframe_style style = keyframe_style::step;
+		// in time order
+		std::vector<std::pair<time_point, T>> keyframes;
+	};
+
+	namespace detail
+	{
+		template<typename T> struct export_lists;
+		template<typename... Ts>
+		struct export_lists<std::tuple<Ts...>>
+		{
+			using type = std::tuple<std::vector<curve_export_set<Ts>>...>;
+		};
+	}
+
 	struct exported_curves
 	{
 		template<class T>
-		struct export_set
+		using export_set = curve_export_set<T>;
+
+		struct exported_object
+		{
+			entity_id id = bad_entity;
+			unique_id object_type = unique_zero;
+			time_point creation_time;
+		};
+
+		struct exported_name
 		{
+			types::string name;
+			time_point time;
 			entity_id entity = bad_entity;
-			variable_id variable = variable_id::zero;
-			//the client will use the variableid to ditermine curveType
 		};
 
-		std::vector<std::pair<entity_id, types::string>> entity_names;
-
-		//TODO: this should be synced on connection only
-		// this is covered by the unique_id sync table
-		//std::vector<std::pair<VariableId, types::string>> variable_names;
-		std::array<std::size_t, 11u> sizes;
-
-		std::vector<export_set<resources::curve_types::int_t>> int_curves;
-		std::vector<export_set<resources::curve_types::float_t>> float_curves;
-		std::vector<export_set<resources::curve_types::vec2_float>> vec2_float_curves;
-		std::vector<export_set<resources::curve_types::bool_t>> bool_curves;
-		std::vector<export_set<resources::curve_types::string>> string_curves;
-		std::vector<export_set<resources::curve_types::object_ref>> object_ref_curves;
-		std::vector<export_set<resources::curve_types::unique>> unique_curves;
-		//collection curves
-		std::vector<export_set<resources::curve_types::collection_int>> int_vector_curves;
-		std::vector<export_set<resources::curve_types::collection_float>> float_vector_curves;
-		std::vector<export_set<resources::curve_types::collection_object_ref>> object_ref_vector_curves;
-		std::vector<export_set<resources::curve_types::collection_unique>> unique_vector_curves;
+		// only keyframes after this time are included
+		time_point since;
+		std::vector<exported_object> created_objects;
+		std::vector<std::pair<entity_id, time_point>> destroyed_objects;
+		// objects the receiver should stop tracking, without them having been destroyed
+		//	see: interest.hpp
+		std::vector<entity_id> left_objects;
+		std::vector<exported_name> entity_names;
+		// a list for each type in curve_types::type_pack, sorted by entity
+		//	so that ids can be delta encoded
+		detail::export_lists<curve_types::type_pack>::type curves;
+
+		template<typename T>
+		std::vector<export_set<T>>& get() noexcept
+		{
+			return std::get<std::vector<export_set<T>>>(curves);
+		}
+
+		template<typename T>
+		const std::vector<export_set<T>>& get() const noexcept
+		{
+			return std::get<std::vector<export_set<T>>>(curves);
+		}
+
+		void clear() noexcept;
+		bool empty() const noexcept;
 	};
+
+	// appends the exported curves onto out in a compact binary format
+	//	ids are written as variable length integers, times are written as the
+	//	difference from the previous keyframe
+	//	NOTE: unique_ids are written using their process local values, both ends
+	//		must agree on the ids, see: data_manager::get_uid
+	void write_exported_curves(const exported_curves&, std::vector<std::byte>& out);
+	// replaces the contents of out
+	//exception: export_error if the data is truncated or not in the expected format
+	void read_exported_curves(std::span<const std::byte>, exported_curves& out);
+
+	// calls f(unique_id&) for every unique_id in the exported curves
+	//	object types, curve variables and the values of unique curves
+	//	used to translate ids that were written by another process
+	template<typename Func>
+	void for_each_unique_id(exported_curves&, Func&& f);
+
+	namespace state_api
+	{
+		// replaces the contents of out with every keyframe in the state that is newer than since
+		//	objects created or destroyed after since are listed as well
+		//	the cost is a check of the last keyframe in each curve, plus copying the new keyframes
+		template<typename GameSystem>
+		void export_changes(time_point since, const game_state&, const extra_state<GameSystem>&, exported_curves& out);
+
+		// applies exported changes to another copy of the state, such as a clients
+		//	listed objects that don't exist yet are created, and curves that an object is missing are added
+		//	keyframes in the state that are at or after the first exported keyframe of a curve are replaced
+		//	objects in left_objects are erased, they will be sent in full if they are listed again
+		//	curves for objects that don't exist and weren't created are skipped
+		//exception: export_error if a curve doesn't match the type of the objects curve
+		template<typename GameSystem>
+		void apply_changes(const exported_curves&, game_state&, extra_state<GameSystem>&);
+	}
+
+	namespace state_api::detail
+	{
+		// adds any keyframes newer than since from the objects curves into out
+		//	if include_current is true, the last keyframe at or before since is added as well
+		//	so that the receiver has the value of each curve at since
+		void export_object_curves(const game_obj&, time_point since, exported_curves& out, bool include_current = false);
+		// sorts each curve list by entity
+		void sort_exported_curves(exported_curves&);
+	}
 }
 
-#endif //HADES_EXPORTCURVES_HPP
\ No newline at end of file
+#include "hades/detail/export_curves.inl"
+
+#endif //HADES_EXPORTCURVES_HPP
@@ -1,7 +1,10 @@
 #ifndef HADES_GAME_API_HPP
 #define HADES_GAME_API_HPP
 
+#include <functional>
 #include <optional>
+#include <span>
+#include <type_traits>
 
 #include "hades/curve_extra.hpp"
 #include "hades/curve_types.hpp"
@@ -94,8 +97,23 @@ namespace hades
 		void restore_level() noexcept; //restores the origional level (the level set here when the system was called)
 		unique_id current_level() noexcept;
 		// TODO: report failure(only levels that are connected to by a player can be accessed)
+		// throws system_error if levels are being ticked concurrently, use defer_to_level instead
+		// throws system_error if the level isn't available, such as while it's hibernating
+		//	the level will be restored, and calls deferred to it are held until then
 		void switch_level(unique_id); // switches to requested level
-		void switch_to_mission() noexcept; // switches to mission
+		// throws system_error if levels or systems are being ticked concurrently, use defer_to_level with unique_zero instead
+		void switch_to_mission(); // switches to mission
+		// calls the function with the requested level as the current level
+		//	once every level has finished ticking, calls are made in the order that
+		//	the levels and calls were made in. pass unique_zero to call in the mission
+		//	this is always safe, even when levels are being ticked concurrently
+		//	can't be called from systems that are being ticked concurrently in the same level
+		void defer_to_level(unique_id, std::function<void()>);
+
+		// calls f(state_api::archetype_chunk&) for each chunk of objects in this level
+		//	that have all of the properties, see: state_api::for_each_chunk
+		template<typename Func, typename... Handles>
+		void for_each_chunk(Func&& f, Handles...);
 
 		//==level local values==
 		// these are not sent to clients or saved
@@ -108,6 +126,11 @@ namespace hades
 		// overwrites previous value even if it was a different type
 		template<typename T>
 		void set_level_local_value(unique_id, T);
+		// faster access for locals registered with state_api::make_level_local_handle
+		template<typename T>
+		T& get_level_local_ref(state_api::level_local_handle<T>);
+		template<typename T>
+		void set_level_local_value(state_api::level_local_handle<T>, std::type_identity_t<T>);
 
 		//==world data==
 		//world bounds in pixels
@@ -137,9 +160,23 @@ namespace hades
 				auto obj = o;
 				return get_property_ref<CurveType, T>(obj, v);
 			}
+			// faster version of the above, see: state_api::make_property_handle
+			template<template<typename> typename CurveType, typename T>
+			state_api::get_property_return_t<CurveType, T>&
+				get_property_ref(object_ref&, state_api::property_handle<CurveType, T>);
+			template<template<typename> typename CurveType, typename T>
+			state_api::get_property_return_t<CurveType, T>&
+				get_property_ref(const object_ref& o, state_api::property_handle<CurveType, T> h)
+			{
+				auto obj = o;
+				return get_property_ref(obj, h);
+			}
 
 			//creation and destruction
 			object_ref create(const object_instance&);
+			// creates many objects at once, this is faster than calling create for each one
+			//	the refs are returned in the same order as the instances
+			std::vector<object_ref> create_objects(std::span<const object_instance>);
 			object_ref clone(object_ref);
 			void destroy(object_ref);
 
@@ -148,6 +185,8 @@ namespace hades
 
 			time_point get_creation_time(object_ref);
 			const tag_list& get_tags(object_ref);
+			// faster than searching get_tags, see: object_functions::has_tag
+			bool has_tag(object_ref, unique_id);
 
 			//NOTE: this isn't a curve anymore
 			bool is_alive(object_ref&) noexcept;
@@ -173,7 +212,7 @@ namespace hades
 
 		inline bool check_tag(object_ref o, unique_id t)
 		{
-			return check_tags(o, std::array{ t })[0];
+			return hades::game::level::object::has_tag(o, t);
 		}
 	}
 
@@ -288,6 +327,11 @@ namespace hades
 		T& get_level_local_ref(unique_id);
 		template<typename T>
 		void set_level_local_value(unique_id, T value); // NOTE: should we return T& from this?
+		// faster access for locals registered with state_api::make_level_local_handle
+		template<typename T>
+		T& get_level_local_ref(state_api::level_local_handle<T>);
+		template<typename T>
+		void set_level_local_value(state_api::level_local_handle<T>, std::type_identity_t<T>);
 
 		//world info
 		world_rect_t get_world_bounds();
@@ -308,6 +352,16 @@ namespace hades
 				auto obj = o;
 				return get_property_ref<CurveType, T>(obj, v);
 			}
+			template<template<typename> typename CurveType, typename T>
+			const state_api::get_property_return_t<CurveType, T>&
+				get_property_ref(object_ref&, state_api::property_handle<CurveType, T>);
+			template<template<typename> typename CurveType, typename T>
+			const state_api::get_property_return_t<CurveType, T>&
+				get_property_ref(const object_ref& o, state_api::property_handle<CurveType, T> h)
+			{
+				auto obj = o;
+				return get_property_ref(obj, h);
+			}
 
 			const hades::linear_curve<vec2_float>& get_position(object_ref);
 			const vec2_float& get_size(object_ref);
@@ -6,7 +6,19 @@
 #include "plf_colony.h"
 #pragma warning(pop)
 
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <span>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
 #include "hades/any_map.hpp"
+#include "hades/cold_storage.hpp"
 #include "hades/curve_types.hpp"
 #include "hades/game_system.hpp"
 #include "hades/uniqueid.hpp"
@@ -51,6 +63,9 @@ namespace hades
 		using var_entry = detail::var_entry;
 		using entity_variable_list_t = std::vector<var_entry>;
 		entity_variable_list_t object_variables;
+		// the objects row in its archetype, see: game_state::archetype_storage
+		static constexpr auto no_archetype_row = std::numeric_limits<std::size_t>::max();
+		std::size_t archetype_row = no_archetype_row;
 	};
 
 	using object_name_map = unordered_map_string<step_curve<object_ref>>;
@@ -89,75 +104,72 @@ namespace hades
 		//we don't shrink the memory space
 		// we need old ptrs to remain valid, but be detectable as stale
 		// after being replaced
+		// entity ids are never reused, so the id stored in a slot acts as
+		// that slots generation, a ptr is stale once the slot id no longer
+		// matches the id in the object_ref
+		// erased slots are chained into a free list and reused by later inserts
 		class game_object_collection
 		{
+			using word_type = std::uint64_t;
+			static constexpr auto word_bits = std::size_t{ std::numeric_limits<word_type>::digits };
+
 		public:
-			static constexpr auto empty_flag = false;
-			static constexpr auto not_empty_flag = true;
+			static constexpr auto npos = std::numeric_limits<std::size_t>::max();
 
-			class iterator
+			template<bool Const>
+			class basic_iterator
 			{
 			public:
-				using v_bool_iter = std::vector<bool>::iterator;
-				using v_obj_iter = std::deque<game_obj>::iterator;
-				using iterator_category = v_obj_iter::iterator_category;
+				using collection_type = std::conditional_t<Const, const game_object_collection, game_object_collection>;
+				using iterator_category = std::forward_iterator_tag;
 				using value_type = game_obj;
-				using difference_type = v_obj_iter::difference_type;
-				using pointer = v_obj_iter::pointer;
-				using reference = v_obj_iter::reference;
-
-				iterator(v_bool_iter a, v_bool_iter a_end, v_obj_iter b) noexcept :
-					_empty_iter{ a }, _empty_end{ a_end }, _obj_iter{ b }
-				{
-					while (_empty_iter != _empty_end  && *_empty_iter == empty_flag)
-					{
-						++_empty_iter; ++_obj_iter;
-					}
-				}
+				using difference_type = std::ptrdiff_t;
+				using pointer = std::conditional_t<Const, const game_obj*, game_obj*>;
+				using reference = std::conditional_t<Const, const game_obj&, game_obj&>;
 
-				bool operator!=(const iterator& rhs) const noexcept
-				{
-					return _empty_iter != rhs._empty_iter;
-				}
+				constexpr basic_iterator() noexcept = default;
+				basic_iterator(collection_type& c, std::size_t i) noexcept :
+					_collection{ &c }, _index{ c._next_occupied(i) }
+				{}
 
-				game_obj& operator*() const
+				reference operator*() const noexcept
 				{
-					return *_obj_iter;
+					return _collection->_data[_index].object;
 				}
 
-				game_obj* operator->() const
+				pointer operator->() const noexcept
 				{
-					return &*_obj_iter;
+					return &_collection->_data[_index].object;
 				}
 
-				iterator& operator++()
+				basic_iterator& operator++() noexcept
 				{
-					++_empty_iter;
-					++_obj_iter;
-					while (_empty_iter != _empty_end && *_empty_iter == empty_flag)
-					{
-						++_empty_iter; ++_obj_iter;
-					}
+					_index = _collection->_next_occupied(_index + 1);
 					return *this;
 				}
 
-				iterator operator++(int)
+				basic_iterator operator++(int) noexcept
 				{
 					const auto old = *this;
 					operator++();
 					return old;
 				}
 
+				bool operator==(const basic_iterator&) const noexcept = default;
+
 			private:
-				v_bool_iter _empty_iter;
-				v_bool_iter _empty_end;
-				v_obj_iter _obj_iter;
+				collection_type* _collection = nullptr;
+				std::size_t _index = npos;
 			};
 
-			// returns a new game_obj in an indeterminate state
-			game_obj* insert();
+			using iterator = basic_iterator<false>;
+			using const_iterator = basic_iterator<true>;
+
 			// moves the passed game_obj into storage, then returns a ptr to it
+			//	the object must have a valid id that isn't already stored
 			game_obj* insert(game_obj); 
+			// reserves index space for count objects
+			void reserve(std::size_t count);
 			// marks the object as erased; ptrs to it will still be valid
 			// use the difference between the object id and the ref id to
 			// detect stale ptrs
@@ -173,21 +185,250 @@ namespace hades
 
 			iterator begin() noexcept
 			{
-				return { std::begin(_emptys), std::end(_emptys), std::begin(_data) };
+				return { *this, {} };
 			}
 
 			iterator end() noexcept
 			{
-				return { std::end(_emptys), std::end(_emptys), std::end(_data) };
+				return { *this, std::size(_data) };
+			}
+
+			const_iterator begin() const noexcept
+			{
+				return { *this, {} };
+			}
+
+			const_iterator end() const noexcept
+			{
+				return { *this, std::size(_data) };
 			}
 
 		private:
+			// returns the first occupied slot at or after i
+			//	or the slot count if there are none
+			std::size_t _next_occupied(std::size_t i) const noexcept
+			{
+				const auto slots = std::size(_data);
+				if (i >= slots)
+					return slots;
+
+				auto word_index = i / word_bits;
+				// mask off the slots before i
+				auto word = _occupied[word_index] & (~word_type{} << (i % word_bits));
+				const auto words = std::size(_occupied);
+				while (word == word_type{})
+				{
+					if (++word_index == words)
+						return slots;
+					word = _occupied[word_index];
+				}
+
+				return word_index * word_bits + integer_cast<std::size_t>(std::countr_zero(word));
+			}
+
+			struct slot
+			{
+				game_obj object;
+				// the next slot in the free list, only used by erased slots
+				std::size_t next_free = npos;
+			};
+
 			std::size_t _size{};
-			std::vector<bool> _emptys;
-			std::deque<game_obj> _data;
+			std::size_t _free_head = npos;
+			// one bit per slot, set if the slot holds a living object
+			std::vector<word_type> _occupied;
+			std::unordered_map<entity_id, std::size_t> _index;
+			std::deque<slot> _data;
 		};
 
 		static_assert(std::is_move_constructible_v<game_object_collection>);
+
+		// maps object ids to the time they were created or destroyed
+		//	also keeps the entries ordered by time, so the ones after a point in time
+		//	can be found without visiting the rest, see: state_api::export_changes
+		class object_time_map
+		{
+		public:
+			using map_type = std::unordered_map<entity_id, time_point>;
+			using const_iterator = map_type::const_iterator;
+
+			const_iterator find(entity_id) const;
+			// throws std::out_of_range if the id isn't in the map
+			time_point at(entity_id) const;
+			bool contains(entity_id) const;
+			void reserve(std::size_t);
+			void insert_or_assign(entity_id, time_point);
+			void erase(entity_id);
+			void clear() noexcept;
+
+			// erases every entry that pred returns true for
+			//	pred is called with a map_type::value_type
+			template<typename Pred>
+			void erase_if(Pred&&);
+
+			// calls f(entity_id, time_point) for each entry with a time after t, ordered by time
+			template<typename Func>
+			void for_each_after(time_point t, Func&& f) const;
+
+			std::size_t size() const noexcept
+			{
+				return std::size(_times);
+			}
+
+			const_iterator begin() const noexcept
+			{
+				return std::begin(_times);
+			}
+
+			const_iterator end() const noexcept
+			{
+				return std::end(_times);
+			}
+
+		private:
+			void _erase_index(entity_id, time_point) noexcept;
+
+			map_type _times;
+			// the same entries as _times, sorted by time then id
+			//	times are usually the current tick, so entries are added to the back
+			std::vector<std::pair<time_point, entity_id>> _by_time;
+		};
+
+		// archetype rows are allocated in chunks of this size
+		//	each chunk has a single word marking which rows are in use
+		constexpr auto archetype_chunk_size = std::size_t{ 64 };
+
+		class archetype_column_base
+		{
+		public:
+			using curve_info_t = std::pair<keyframe_style, curve_variable_type>;
+
+			archetype_column_base(variable_id v, curve_info_t i) noexcept : id{ v }, info{ i } {}
+			virtual ~archetype_column_base() noexcept = default;
+
+			// returns a ptr to the state_field stored in row
+			virtual void* get(std::size_t row) noexcept = 0;
+			virtual void add_chunk() = 0;
+			// replaces the state_field in row with an empty one
+			virtual void reset(std::size_t row) noexcept = 0;
+
+			const variable_id id;
+			const curve_info_t info;
+		};
+
+		template<typename Field>
+		class archetype_column final : public archetype_column_base
+		{
+		public:
+			using field_type = Field;
+			using chunk_type = std::array<Field, archetype_chunk_size>;
+			using archetype_column_base::archetype_column_base;
+
+			void* get(std::size_t row) noexcept override
+			{
+				return &get_field(row);
+			}
+
+			Field& get_field(std::size_t row) noexcept
+			{
+				return (*_chunks[row / archetype_chunk_size])[row % archetype_chunk_size];
+			}
+
+			Field* chunk_data(std::size_t chunk) noexcept
+			{
+				return _chunks[chunk]->data();
+			}
+
+			void add_chunk() override
+			{
+				_chunks.emplace_back(std::make_unique<chunk_type>());
+				return;
+			}
+
+			void reset(std::size_t row) noexcept override
+			{
+				get_field(row) = Field{};
+				return;
+			}
+
+		private:
+			// chunks are never moved, so ptrs into them remain valid
+			std::vector<std::unique_ptr<chunk_type>> _chunks;
+		};
+
+		// stores the curves of objects that share a resources::object
+		//	each curve in the types variable_layout is given a column
+		//	and each object is given a row, so the curves from neighbouring objects
+		//	are stored next to each other
+		class archetype
+		{
+		public:
+			explicit archetype(const resources::object&);
+
+			// returns the row for the new object
+			std::size_t insert(entity_id);
+			// releases the row and resets the curves stored in it
+			void erase(std::size_t row) noexcept;
+
+			// returns nullptr if this archetype has no column for the curve
+			archetype_column_base* find_column(variable_id) noexcept;
+			// as above, also returns nullptr if the column doesn't store Field
+			template<typename Field>
+			archetype_column<Field>* find_column(variable_id) noexcept;
+			// uses the object types variable_key_slots to find the column
+			template<typename Field>
+			archetype_column<Field>* find_column(variable_id, std::size_t curve_key) noexcept;
+
+			std::size_t chunk_count() const noexcept
+			{
+				return std::size(_occupied);
+			}
+
+			std::uint64_t occupied_rows(std::size_t chunk) const noexcept
+			{
+				return _occupied[chunk];
+			}
+
+			const entity_id* chunk_entities(std::size_t chunk) const noexcept
+			{
+				return &_entities[chunk * archetype_chunk_size];
+			}
+
+			const resources::object* object_type() const noexcept
+			{
+				return _object_type;
+			}
+
+		private:
+			const resources::object* _object_type = nullptr;
+			// columns in the order of the object types variable_layout
+			std::vector<std::unique_ptr<archetype_column_base>> _columns;
+			std::vector<std::uint64_t> _occupied;
+			std::vector<entity_id> _entities;
+			std::vector<std::size_t> _free_rows;
+		};
+
+		// archetypes in the order they were created
+		class archetype_collection
+		{
+		public:
+			archetype& find_or_create(const resources::object&);
+			archetype* find(const resources::object*) noexcept;
+
+			auto begin() noexcept
+			{
+				return std::begin(_archetypes);
+			}
+
+			auto end() noexcept
+			{
+				return std::end(_archetypes);
+			}
+
+		private:
+			std::deque<archetype> _archetypes;
+			std::unordered_map<const resources::object*, std::size_t> _index;
+		};
 	}
 
 	//the whole game state, this is everything that gets saved
@@ -212,11 +453,85 @@ namespace hades
 		state_data_type state_data;
 		entity_id next_id = next(bad_entity);
 		object_name_map names;
-		std::unordered_map<entity_id, time_point> object_creation_time;
-		std::unordered_map<entity_id, time_point> object_destruction_time;
-		//TODO: pull stale objects out of the main game data, so that they can be written to disk or something
+		detail::object_time_map object_creation_time;
+		detail::object_time_map object_destruction_time;
+		// if true, objects store their curves in per object type archetypes
+		//	rather than in state_data. see: state_api::for_each_chunk
+		bool archetype_storage = false;
+		detail::archetype_collection archetypes;
+		// objects that were destroyed long enough ago to be pulled out of the main game data
+		//	see: state_api::move_to_cold_storage
+		cold_object_store cold_objects;
 	};
 
+	namespace detail
+	{
+		// storage for a level local that is accessed by handle
+		//	see: state_api::level_local_handle
+		struct level_local_slot
+		{
+			using deleter_t = void(*)(void*) noexcept;
+			std::unique_ptr<void, deleter_t> value{ nullptr, nullptr };
+			const void* type = nullptr;
+		};
+
+		// each type gets a unique address, used to check level local types without RTTI
+		template<typename T>
+		inline constexpr char level_local_type_tag = {};
+
+		struct level_local_info
+		{
+			std::size_t slot;
+			const void* type;
+		};
+
+		// level local slots are shared by every level
+		// returns the slot assigned to id, assigning a new one if needed
+		//exception: state_api::level_local_wrong_type if id was registered with a different type
+		std::size_t register_level_local(unique_id, const void* type);
+		// returns nullptr if the id hasn't been registered
+		//exception: state_api::level_local_wrong_type if id was registered with a different type
+		const level_local_info* find_level_local(unique_id, const void* type);
+		// the number of slots that have been assigned
+		//	doesn't lock the registry, so it's cheap enough to check before find_level_local
+		std::size_t level_local_count() noexcept;
+	}
+
+	// a curve that was written to through the game api
+	struct dirty_curve
+	{
+		entity_id object = bad_entity;
+		variable_id variable = bad_variable;
+	};
+
+	inline bool operator==(const dirty_curve& l, const dirty_curve& r) noexcept
+	{
+		return l.object == r.object && l.variable == r.variable;
+	}
+
+	inline bool operator<(const dirty_curve& l, const dirty_curve& r) noexcept
+	{
+		return std::tie(l.object, l.variable) < std::tie(r.object, r.variable);
+	}
+
+	namespace detail
+	{
+		// records the curves written to during each tick
+		//	see: state_api::enable_dirty_tracking
+		struct dirty_journal
+		{
+			// curves written to since the last tick finished, may contain duplicates
+			std::vector<dirty_curve> current;
+			// curves written to during the last tick, sorted without duplicates
+			std::vector<dirty_curve> last_tick;
+			// one buffer per system in a concurrently ticked stage, see: tick_stage
+			//	kept between ticks so they don't need to reallocate
+			//	the frame arena isn't thread safe, so these can't come from there
+			std::vector<std::vector<dirty_curve>> stage_buffers;
+			bool enabled = false;
+		};
+	}
+
 	// non-saved state, this is generated during runtime from the actual game state.
 	// this doesn't need to be sent to clients, they load or generate their own extras
 	template<typename GameSystem>
@@ -234,6 +549,10 @@ namespace hades
 		system_behaviours<GameSystem> systems;
 		//level local data, available in all systems
 		any_map<unique_id> level_locals;
+		// level locals that have been registered with a handle
+		//	indexed by level_local_handle::slot
+		std::vector<detail::level_local_slot> level_local_slots;
+		detail::dirty_journal dirty_curves;
 	};
 
 	//functions for modifying game state
@@ -297,6 +616,13 @@ namespace hades
 		// Object creation:
 		template<typename GameSystem>
 		object_ref make_object(const object_instance&, time_point, game_state&, extra_state<GameSystem>&);
+		// creates an object for each instance, the refs are returned in the same order
+		//	instances of the same object type are created together, so storage
+		//	can be reserved up front and systems attached in one batch
+		//exception: game_state_error if any of the instances have a preset id
+		//				no objects are created if this is thrown
+		template<typename GameSystem>
+		std::vector<object_ref> make_objects(std::span<const object_instance>, time_point, game_state&, extra_state<GameSystem>&);
 		// NOTE: the new object will not have the name of the cloned object
 		template<typename GameSystem> 
 		object_ref clone_object(const game_obj&, time_point, game_state&, extra_state<GameSystem>&);
@@ -307,6 +633,33 @@ namespace hades
 		// deletes the object data and invalidates the game_obj, best to do this one frame after detaching them.
 		template<typename GameSystem>
 		void erase_object(game_obj&, game_state&, extra_state<GameSystem>&);
+		// copies the object and all of its curve keyframes into a save instance
+		object_save_instance extract_object(const game_obj&, const game_state&);
+		// stores the object in game_state::cold_objects, then erases it
+		//	the object should have been destroyed already
+		//	use restore_object with the result of cold_objects.find to bring it back
+		template<typename GameSystem>
+		void move_to_cold_storage(game_obj&, game_state&, extra_state<GameSystem>&);
+		// when enabled, curves that systems take a writable reference to through the game api
+		//	are recorded, so that exporters and saving only need to look at those curves
+		//	see: get_dirty_curves
+		template<typename GameSystem>
+		void enable_dirty_tracking(bool, extra_state<GameSystem>&) noexcept;
+		// the curves written to during the last tick, sorted by object
+		//	created and destroyed objects are not included
+		template<typename GameSystem>
+		std::span<const dirty_curve> get_dirty_curves(const extra_state<GameSystem>&) noexcept;
+		// called by update_level once each tick has finished
+		//	merges the recorded curves into the list returned by get_dirty_curves
+		template<typename GameSystem>
+		void finish_dirty_tick(extra_state<GameSystem>&);
+		// removes curve keyframes that are no longer needed, using each curves retention policy
+		//	keyframes older than now - history are removed, except the last one needed to get values at that time
+		//	default_history is used for curves that don't set their own history, zero keeps all history
+		//	only keyframes after last_compaction are collapsed, pass the previous now, or time_point{} the first time
+		//	see: resources::curve_retention
+		template<typename GameSystem>
+		void compact_curves(time_point last_compaction, time_point now, time_duration default_history, extra_state<GameSystem>&);
 		void name_object(string, object_ref, time_point, game_state&);
 		const string& get_name(object_ref, time_point, const game_state&) noexcept;
 		template<typename GameSystem>
@@ -348,6 +701,105 @@ namespace hades
 		get_property_return_t<CurveType, T>* 
 			get_object_property_ptr(game_obj&, variable_id) noexcept;
 
+		// a typed handle to an object property
+		//	resolve these once (in on_create for example) and use them instead of
+		//	the variable_id, looking up a property with a handle is O(1)
+		//	the handle can be used with objects of any type
+		template<template<typename> typename CurveType, typename T>
+		struct property_handle
+		{
+			using curve_type = CurveType<T>;
+			using field_type = state_field<CurveType<T>>;
+
+			variable_id id = bad_variable;
+			std::size_t key = std::numeric_limits<std::size_t>::max(); // see: resources::curve::key
+		};
+
+		// exceptions: object_property_wrong_type if the curve doesn't store CurveType<T>
+		template<template<typename> typename CurveType, typename T>
+		property_handle<CurveType, T> make_property_handle(const resources::curve&);
+		// as above, also throws resource_error if the curve cannot be found
+		template<template<typename> typename CurveType, typename T>
+		property_handle<CurveType, T> make_property_handle(variable_id);
+
+		template<template<typename> typename CurveType, typename T>
+		const get_property_return_t<CurveType, T>&
+			get_object_property_ref(const game_obj&, property_handle<CurveType, T>);
+		template<template<typename> typename CurveType, typename T>
+		get_property_return_t<CurveType, T>&
+			get_object_property_ref(game_obj&, property_handle<CurveType, T>);
+
+		template<template<typename> typename CurveType, typename T>
+		const get_property_return_t<CurveType, T>*
+			get_object_property_ptr(const game_obj&, property_handle<CurveType, T>) noexcept;
+		template<template<typename> typename CurveType, typename T>
+		get_property_return_t<CurveType, T>*
+			get_object_property_ptr(game_obj&, property_handle<CurveType, T>) noexcept;
+
+		// a chunk of rows from an archetype, see for_each_chunk
+		//	columns are in the same order as the handles passed to for_each_chunk
+		template<typename... Fields>
+		class archetype_chunk
+		{
+		public:
+			static constexpr auto chunk_size = detail::archetype_chunk_size;
+
+			archetype_chunk(const resources::object* o, std::uint64_t occupied,
+				const entity_id* ents, Fields*... columns) noexcept
+				: _object_type{ o }, _occupied{ occupied }, _entities{ ents }, _columns{ columns... }
+			{}
+
+			const resources::object* object_type() const noexcept
+			{
+				return _object_type;
+			}
+
+			// returns true if the row holds an object
+			bool contains(std::size_t row) const noexcept
+			{
+				return (_occupied >> row) & std::uint64_t{ 1 };
+			}
+
+			entity_id get_entity(std::size_t row) const noexcept
+			{
+				assert(contains(row));
+				return _entities[row];
+			}
+
+			template<std::size_t Column>
+			auto& get(std::size_t row) const noexcept
+			{
+				assert(contains(row));
+				return std::get<Column>(_columns)[row].data;
+			}
+
+			// calls f(row) for each row that holds an object
+			template<typename Func>
+			void for_each_row(Func&& f) const
+			{
+				auto rows = _occupied;
+				while (rows != std::uint64_t{})
+				{
+					std::invoke(f, integer_cast<std::size_t>(std::countr_zero(rows)));
+					rows &= rows - 1;
+				}
+				return;
+			}
+
+		private:
+			const resources::object* _object_type;
+			std::uint64_t _occupied;
+			const entity_id* _entities;
+			std::tuple<Fields*...> _columns;
+		};
+
+		// calls f(archetype_chunk&) for each chunk of objects that have all of the properties
+		//	rows are visited in memory order, chunks with no objects are skipped
+		//	objects that have been destroyed are visited until they are erased
+		//	only visits objects stored in archetypes, see: game_state::archetype_storage
+		template<typename Func, typename... Handles>
+		void for_each_chunk(game_state&, Func&& f, Handles...);
+
 		// Get tags
 		// Can throw object_stale_error
 		template<typename GameSystem>
@@ -355,6 +807,31 @@ namespace hades
 		const tag_list&	get_object_tags(const game_obj&) noexcept;
 
 		// level locals
+		// typed handle to a level local, accessing a local through a handle
+		// skips the id lookup and type check
+		// handles are valid for every level
+		template<typename T>
+		struct level_local_handle
+		{
+			using value_type = T;
+			std::size_t slot = std::numeric_limits<std::size_t>::max();
+		};
+
+		// registers id as a level local of type T
+		//	should be called while loading, before any levels are ticked
+		//	once registered, the unique_id functions below also use the handles storage
+		//exception: level_local_wrong_type if the id was registered with a different type
+		template<typename T>
+		level_local_handle<T> make_level_local_handle(unique_id);
+
+		template<typename T, typename GameSystem>
+		T& get_level_local_ref(level_local_handle<T>, extra_state<GameSystem>&);
+		//exception: level_local_not_found
+		template<typename T, typename GameSystem>
+		const T& get_level_local_ref(level_local_handle<T>, const extra_state<GameSystem>&);
+		template<typename T, typename GameSystem>
+		void set_level_local_value(level_local_handle<T>, std::type_identity_t<T>, extra_state<GameSystem>&);
+
 		// gets or creates a local ref
 		//exception: level_local_wrong_type thrown if a id was already used by
 		//				a value of a different type
@@ -366,6 +843,8 @@ namespace hades
 
 		// sets a game value to the passed value
 		// overwrites the previous value even if the types are different
+		//	unless the id has a handle
+		//exception: level_local_wrong_type if the id has a handle of a different type
 		template<typename T, typename GameSystem>
 		void set_level_local_value(unique_id, T, extra_state<GameSystem>&);
 
@@ -1,9 +1,10 @@
 #ifndef HADES_GAME_SYSTEM_HPP
 #define HADES_GAME_SYSTEM_HPP
 
-#include <any>
 #include <deque>
 #include <functional>
+#include <memory_resource>
+#include <span>
 #include <vector>
 
 #include "hades/curve_extra.hpp"
@@ -38,8 +39,6 @@
 
 namespace hades
 {
-	using system_data_t = std::any;
-
 	/// @brief A range over the above object_time storage
 	///			skips iterators to objects that haven't passed
 	///			their activation timer yet
@@ -47,18 +46,17 @@ namespace hades
 	{
 	public:
 		constexpr activated_object_view() noexcept = default;
-		activated_object_view(name_list& n, time_point t) noexcept : _data{ &n },
+		activated_object_view(std::span<object_time> n, time_point t) noexcept : _data{ n },
 			_activation_time{ t } {}
 
 		template<typename T>
 		class skip_iterator
 		{
 		public:
-			skip_iterator(typename name_list::iterator i, const name_list& d, time_point t) noexcept :
-				_i{ i }, _t{ t }, _data{ &d }
+			skip_iterator(object_time* i, const object_time* end, time_point t) noexcept :
+				_i{ i }, _end{ end }, _t{ t }
 			{
-				const auto end = std::end(*_data);
-				while (_i != end && _i->next_activation > t) ++_i;
+				while (_i != _end && _i->next_activation > t) ++_i;
 				return;
 			}
 
@@ -74,9 +72,8 @@ namespace hades
 
 			skip_iterator& operator++() noexcept
 			{
-				const auto end = std::end(*_data);
 				++_i;
-				while (_i != end && _i->next_activation > _t) ++_i;
+				while (_i != _end && _i->next_activation > _t) ++_i;
 				return *this;
 			}
 
@@ -98,9 +95,9 @@ namespace hades
 			}
 
 		private:
-			name_list::iterator _i;
+			object_time* _i;
+			const object_time* _end;
 			time_point _t;
-			const name_list* _data;
 		};
 
 		using iterator = skip_iterator<object_ref>;
@@ -108,33 +105,37 @@ namespace hades
 
 		iterator begin() noexcept
 		{
-			assert(_data);
-			return { _data->begin(), *_data, _activation_time };
+			return { _data.data(), _end(), _activation_time };
 		}
 
 		iterator end() noexcept
 		{
-			assert(_data);
-			return { _data->end(), *_data, _activation_time };
+			return { _data.data() + _data.size(), _end(), _activation_time};
 		}
 
 		const_iterator begin() const noexcept
 		{
-			assert(_data);
-			return { _data->begin(), *_data, _activation_time };
+			return { _data.data(), _end(), _activation_time };
 		}
 
 		const_iterator end() const noexcept
 		{
-			assert(_data);
-			return { _data->end(), *_data, _activation_time };
+			return { _data.data() + _data.size(), _end(), _activation_time };
 		}
 
 	private:
-		name_list* _data = nullptr;
+		const object_time* _end() const noexcept
+		{
+			return _data.data() + _data.size();
+		}
+
+		std::span<object_time> _data;
 		time_point _activation_time;
 	};
 
+	// name list for temporaries that only last a single tick
+	using frame_name_list = std::pmr::vector<object_time>;
+
 	template<typename SystemType>
 	class system_behaviours
 	{
@@ -142,9 +143,9 @@ namespace hades
 		using system_type = SystemType;
 		using system_resource = typename SystemType::system_t;
 
-		std::vector<SystemType*> get_systems() noexcept
+		std::pmr::vector<SystemType*> get_systems(std::pmr::memory_resource* m = std::pmr::get_default_resource())
 		{
-			auto out = std::vector<SystemType*>{};
+			auto out = std::pmr::vector<SystemType*>{ m };
 			out.reserve(size(_systems));
 			std::transform(begin(_systems), end(_systems), std::back_inserter(out), [](auto& sys) {
 				return &sys;
@@ -153,6 +154,17 @@ namespace hades
 			return out;
 		}
 
+		std::pmr::vector<const SystemType*> get_systems(std::pmr::memory_resource* m = std::pmr::get_default_resource()) const
+		{
+			auto out = std::pmr::vector<const SystemType*>{ m };
+			out.reserve(size(_systems));
+			std::transform(begin(_systems), end(_systems), std::back_inserter(out), [](const auto& sys) {
+				return &sys;
+				});
+
+			return out;
+		}
+
 		std::vector<const system_resource*> get_new_systems() noexcept
 		{
 			auto ret = std::vector<const system_resource*>{};
@@ -160,9 +172,17 @@ namespace hades
 			return ret;
 		}
 
-		system_data_t& get_system_data(unique_id key)
+		// systems grouped into stages for calling on_tick
+		// systems within a stage don't conflict with each other and can be
+		// ticked at the same time, each stage must complete before the next
+		// ticking the stages in order gives the same result as ticking every
+		// system in the order they were installed
+		using tick_stage = std::vector<SystemType*>;
+		const std::vector<tick_stage>& get_tick_schedule();
+
+		system_data_t& get_system_data(SystemType& s) noexcept
 		{
-			return _system_data[key];
+			return s.system_data;
 		}
 
 		[[deprecated]]
@@ -173,18 +193,27 @@ namespace hades
 		[[deprecated]]
 		void set_current_time(time_point);
 
+		// the following return lists allocated from the passed memory resource
 		//get entites that have been added to the system
 		//since the last frame
-		name_list get_new_entities(SystemType&);
+		frame_name_list get_new_entities(SystemType&, std::pmr::memory_resource* = std::pmr::get_default_resource());
 		// entities that have already been attached in a previous session
 		// but are being reinitialised in on_create
-		name_list get_created_entities(SystemType&);
+		frame_name_list get_created_entities(SystemType&, std::pmr::memory_resource* = std::pmr::get_default_resource());
 		//get all entities currently attached to the system
-		name_list& get_entities(SystemType&) const;
+		//	wakes any sleeping entities
+		name_list& get_entities(SystemType&);
+		// get the entities that should be ticked at time_point
+		//	entities that were put to sleep are moved out of the list
+		//	and sleeping entities that are due are moved back in
+		//	so sleeping entities cost nothing while they sleep
+		name_list& get_active_entities(SystemType&, time_point);
 		//get entities that were removed from the system last frame
-		name_list get_removed_entities(SystemType&);
+		frame_name_list get_removed_entities(SystemType&, std::pmr::memory_resource* = std::pmr::get_default_resource());
 
 		void attach_system(object_ref, unique_id);
+		// attaches every object in the list
+		void attach_system(std::span<const object_ref>, unique_id);
 		void attach_system_from_load(object_ref, unique_id);
 		[[deprecated]] void detach_system(object_ref, unique_id);
 		//remove this entity from all systems
@@ -201,7 +230,10 @@ namespace hades
 	private:
 		std::deque<SystemType> _systems;
 		std::vector<const system_resource*> _new_systems;
-		std::unordered_map<unique_id, system_data_t> _system_data;
+		std::vector<tick_stage> _tick_schedule;
+		// systems are never uninstalled, so we rebuild the schedule
+		// whenever the system count changes
+		std::size_t _scheduled_systems = {};
 		bool _dirty_systems = false;
 	};
 
@@ -212,6 +244,7 @@ namespace hades
 
 	template<typename T>
 	struct extra_state;
+	struct dirty_curve;
 
 	template<typename SystemType>
 	struct common_job_data
@@ -225,13 +258,28 @@ namespace hades
 		activated_object_view entity;
 		unique_id system = unique_zero;
 		system_data_t* system_data = nullptr;
+		// memory for temporaries that is released after the tick
+		//	nullptr to use the default resource, see: frame_arena
+		//	not thread safe, don't use from systems with concurrent_tick set
+		std::pmr::memory_resource* frame_memory = nullptr;
+	};
+
+	// a function queued to be called in another level
+	// see: game::level::defer_to_level
+	struct deferred_level_call
+	{
+		unique_id level = unique_zero;
+		std::function<void()> function;
 	};
 
 	struct system_job_data : common_job_data<game_system>
 	{
 		using get_level_fn = game_interface*(*)(unique_id);
 
+		// nullptr if other levels are being ticked at the same time as this one
 		get_level_fn get_level = nullptr;
+		// calls to be made once all levels have finished this tick
+		std::vector<deferred_level_call>* deferred_calls = nullptr;
 		//level data interface:
 		// contains units, particles, buildings, terrain
 		// per level quests and objectives
@@ -241,6 +289,14 @@ namespace hades
 		game_interface *mission_data = nullptr;
 		const std::vector<player_data>* players = nullptr;
 		time_duration dt = time_duration::zero();
+		// curves written by a concurrently ticked system are recorded here
+		//	rather than in the levels dirty_journal, see: state_api::enable_dirty_tracking
+		std::vector<dirty_curve>* dirty_curves = nullptr;
+		// true if other systems are being ticked at the same time as this one
+		bool concurrent_tick = false;
+		// the curves this system declared it writes, set while concurrent_tick is true
+		//	see: declare_system_access
+		const std::vector<unique_id>* write_curves = nullptr;
 	};
 
 	template<typename CreateFunc, typename ConnectFunc, typename DisconnectFunc, typename TickFunc, typename DestroyFunc>
@@ -252,6 +308,15 @@ namespace hades
 		return make_system(data.get_uid(name), on_create, on_connect, on_disconnect, on_tick, on_destroy, data);
 	}
 
+	// declares the curves read and written by a systems on_tick
+	//	systems that have declared their access may be ticked on the shared thread pool
+	//	at the same time as other systems that they don't conflict with.
+	//	during on_tick these systems must only access the curves they have declared
+	//	and must not create, clone or destroy objects, or use level locals
+	//	writing to an undeclared curve asserts, using level locals throws system_error
+	void declare_system_access(unique_id system, std::vector<unique_id> reads,
+		std::vector<unique_id> writes, data::data_manager&);
+
 	//program provided systems should be attatched to the renderer or 
 	//gameinstance depending on what kind of system they are
 
@@ -278,12 +343,16 @@ namespace hades
 	}
 
 	//funcs to call before a system gets control, and to clean up after
+	// game data is stored per thread, so that systems can be ticked concurrently
+	//	passing nullptr clears the game data for this thread
 	void set_game_data(system_job_data*) noexcept;
 	void set_render_data(render_job_data*) noexcept;
 
 	namespace detail
 	{
 		system_job_data* get_game_data_ptr() noexcept;
+		// nullptr if no game data has been set on this thread
+		system_job_data* try_get_game_data_ptr() noexcept;
 		unique_id get_game_level_id() noexcept;
 		game_interface* get_game_level_ptr() noexcept;
 		system_behaviours<game_system>* get_game_systems_ptr() noexcept;
@@ -291,6 +360,29 @@ namespace hades
 		render_job_data* get_render_data_ptr() noexcept;
 		const common_interface* get_render_level_ptr() noexcept;
 		extra_state<render_system>* get_render_extra_ptr() noexcept;
+
+		// sets the game data for this thread, the previous data is put back when the scope ends
+		//	even if the code inside throws
+		class game_data_scope
+		{
+		public:
+			explicit game_data_scope(system_job_data* d) noexcept
+				: _previous{ try_get_game_data_ptr() }
+			{
+				set_game_data(d);
+			}
+
+			game_data_scope(const game_data_scope&) = delete;
+			game_data_scope& operator=(const game_data_scope&) = delete;
+
+			~game_data_scope() noexcept
+			{
+				set_game_data(_previous);
+			}
+
+		private:
+			system_job_data* _previous;
+		};
 	}
 }
 
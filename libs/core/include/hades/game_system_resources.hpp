@@ -1,6 +1,13 @@
 #ifndef HADES_GAME_SYSTEM_RESOURCES_HPP
 #define HADES_GAME_SYSTEM_RESOURCES_HPP
 
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <new>
+#include <typeinfo>
+#include <utility>
 #include <vector>
 
 #include "hades/curve_types.hpp"
@@ -42,6 +49,124 @@ namespace hades
 	//using attached_ent = std::pair<object_ref, time_point>;
 	using name_list = std::vector<object_time>; // TODO: rename
 
+	namespace detail
+	{
+		// systems ticked on different threads shouldn't share cache lines
+		constexpr auto cache_line_size = std::size_t{ 64 };
+	}
+
+	// storage for a single systems data
+	//	the value is given its own cache lines
+	//	the stored type is only checked in debug builds
+	class system_data_t
+	{
+	public:
+		system_data_t() noexcept = default;
+		system_data_t(const system_data_t&) = delete;
+		system_data_t(system_data_t&& other) noexcept
+			: _data{ std::exchange(other._data, nullptr) },
+			_destroy{ std::exchange(other._destroy, nullptr) }
+#ifndef NDEBUG
+			, _type{ std::exchange(other._type, nullptr) }
+#endif
+		{}
+
+		system_data_t& operator=(const system_data_t&) = delete;
+		system_data_t& operator=(system_data_t&& other) noexcept
+		{
+			if (this == &other)
+				return *this;
+
+			reset();
+			_data = std::exchange(other._data, nullptr);
+			_destroy = std::exchange(other._destroy, nullptr);
+#ifndef NDEBUG
+			_type = std::exchange(other._type, nullptr);
+#endif
+			return *this;
+		}
+
+		~system_data_t() noexcept
+		{
+			reset();
+		}
+
+		bool has_value() const noexcept
+		{
+			return _data;
+		}
+
+		template<typename T>
+		T& get() noexcept
+		{
+			assert(_data);
+			assert(*_type == typeid(T));
+			return *static_cast<T*>(_data);
+		}
+
+		template<typename T>
+		T& emplace(T value)
+		{
+			reset();
+			const auto mem = ::operator new(_alloc_size<T>(), _alignment<T>());
+			try
+			{
+				_data = ::new (mem) T(std::move(value));
+			}
+			catch (...)
+			{
+				::operator delete(mem, _alloc_size<T>(), _alignment<T>());
+				throw;
+			}
+
+			_destroy = &_destroy_impl<T>;
+#ifndef NDEBUG
+			_type = &typeid(T);
+#endif
+			return *static_cast<T*>(_data);
+		}
+
+		void reset() noexcept
+		{
+			if (_data)
+				std::invoke(_destroy, _data);
+			_data = nullptr;
+			_destroy = nullptr;
+#ifndef NDEBUG
+			_type = nullptr;
+#endif
+			return;
+		}
+
+	private:
+		template<typename T>
+		static constexpr std::align_val_t _alignment() noexcept
+		{
+			return std::align_val_t{ std::max(alignof(T), detail::cache_line_size) };
+		}
+
+		// round up to a whole number of cache lines
+		template<typename T>
+		static constexpr std::size_t _alloc_size() noexcept
+		{
+			constexpr auto align = static_cast<std::size_t>(_alignment<T>());
+			return (sizeof(T) + align - 1) / align * align;
+		}
+
+		template<typename T>
+		static void _destroy_impl(void* p) noexcept
+		{
+			std::destroy_at(static_cast<T*>(p));
+			::operator delete(p, _alloc_size<T>(), _alignment<T>());
+			return;
+		}
+
+		void* _data = nullptr;
+		void(*_destroy)(void*) noexcept = nullptr;
+#ifndef NDEBUG
+		const std::type_info* _type = nullptr;
+#endif
+	};
 }
 
 namespace hades::resources
@@ -61,6 +186,13 @@ namespace hades::resources
 			on_destroy;			//called on system destruction: mission and player info is not available
 		//	on_event?
 
+		//curves that tick reads from and writes to
+		// systems that have declared their access can be ticked
+		// at the same time as other systems that don't conflict with them
+		// systems that haven't declared are always ticked on their own
+		std::vector<unique_id> read_curves, write_curves;
+		bool access_declared = false;
+
 		//if loaded from a manifest then it should be loaded from scripts
 		//if it's provided by the application, then source is empty, and no laoder function is provided.
 	};
@@ -89,8 +221,13 @@ namespace hades::detail
 
 		//this holds the systems, name and id, and the function that the system uses.
 		const system_t* system = nullptr;
+		// data for this system, see: game::get_system_data
+		system_data_t system_data;
 		//list of entities attached to this system, over time
 		name_list attached_entities;
+		// attached entities that are asleep, stored as a heap ordered by next_activation
+		//	see: system_behaviours::get_active_entities
+		name_list sleeping_ents;
 		name_list new_ents;
 		name_list created_ents;
 		name_list removed_ents;
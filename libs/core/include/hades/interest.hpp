@@ -0,0 +1,96 @@
+#ifndef HADES_INTEREST_HPP
+#define HADES_INTEREST_HPP
+
+#include <vector>
+
+#include "hades/collision_grid.hpp"
+#include "hades/export_curves.hpp"
+#include "hades/game_system.hpp"
+#include "hades/rectangle_math.hpp"
+
+// interest management limits the changes sent to a player to the objects near their view
+//	each level keeps an interest_grid of object positions, each player keeps an interest_set
+//	of the objects they were sent last time. every update the objects in view are compared
+//	with the set to find the objects that entered, stayed in or left the players view
+// entering objects are sent in full, staying objects only send their new keyframes,
+//	and leaving objects are listed in exported_curves::left_objects so the client can drop them
+// the cost of an update scales with the number of objects near the view, rather than with the level
+
+namespace hades
+{
+	// spatial index of the objects in a level, by position and size curve
+	//	objects without a position curve are treated as visible from anywhere
+	class interest_grid
+	{
+	public:
+		interest_grid(rect_float world_bounds, float cell_size);
+
+		// adds or moves the object, using its position and size at time t
+		void place(const game_obj&, time_point t);
+		void remove(entity_id);
+		// forgets every object, the next update will place them again
+		//	used after the level state has been replaced, such as when rewinding
+		void reset();
+
+		// places objects created since the last update, and moves objects whose
+		//	position or size was written during the last tick, or whose position
+		//	curve has keyframes after the previous update
+		//	when dirty tracking isn't enabled(see: state_api::enable_dirty_tracking)
+		//	every object is placed again
+		//	destroyed objects must be removed by the caller
+		void update(time_point, const game_state&, const extra_state<game_system>&);
+
+		// returns the objects in the cells that overlap the rect, and the objects without a position
+		//	so objects up to a cell away from the rect are included as well
+		//	sorted by id without duplicates
+		std::vector<entity_id> find(rect_float) const;
+
+	private:
+		// returns true if the objects position curve has keyframes after t
+		bool _place(const game_obj&, time_point t);
+		rect_float _clamp(rect_float) const noexcept;
+
+		rect_float _world;
+		float _cell_size;
+		uniform_collision_grid<entity_id, rect_float> _grid;
+		// sorted
+		std::vector<entity_id> _unpositioned;
+		// objects placed before the last keyframe of their position curve, sorted
+		std::vector<entity_id> _moving;
+		// every object with an id lower than this has been placed
+		entity_id _next_id = next(bad_entity);
+	};
+
+	// the objects that have been sent to a player, sorted by id
+	struct interest_set
+	{
+		std::vector<entity_id> objects;
+	};
+
+	// all lists are sorted by id
+	struct interest_changes
+	{
+		std::vector<entity_id> entered, stayed, left;
+	};
+
+	// compares the objects that are now relevant with the interest set
+	//	then replaces the set with relevant
+	//	relevant should be sorted without duplicates(see: interest_grid::find)
+	interest_changes update_interest(interest_set&, std::vector<entity_id> relevant);
+
+	namespace state_api
+	{
+		// replaces the contents of out with the changes for a single player
+		//	entered objects are listed as created, and have their curves exported from their value at since
+		//	stayed objects are exported the same as export_changes
+		//	left objects are added to left_objects
+		//	new entity names are sent for every object, as they're used to find objects rather than display them
+		template<typename GameSystem>
+		void export_changes(time_point since, const interest_changes&, const game_state&,
+			const extra_state<GameSystem>&, exported_curves& out);
+	}
+}
+
+#include "hades/detail/interest.inl"
+
+#endif //!HADES_INTEREST_HPP
@@ -2,6 +2,7 @@
 #define HADES_LEVEL_INTERFACE_HPP
 
 #include <exception>
+#include <span>
 #include <unordered_map>
 #include <vector>
 
@@ -11,6 +12,7 @@
 #include "hades/input.hpp"
 #include "hades/level.hpp"
 #include "hades/level_scripts.hpp"
+#include "hades/state_snapshot.hpp"
 #include "hades/game_system.hpp"
 #include "hades/game_types.hpp"
 #include "hades/terrain.hpp"
@@ -58,6 +60,7 @@ namespace hades
 	{
 	public:
 		virtual object_ref create_object(const object_instance&, time_point) = 0;
+		virtual std::vector<object_ref> create_objects(std::span<const object_instance>, time_point) = 0;
 		virtual object_ref clone_object(object_ref, time_point) = 0;
 		virtual void destroy_object(object_ref, time_point) = 0;
 
@@ -79,6 +82,7 @@ namespace hades
 		~game_implementation();
 
 		object_ref create_object(const object_instance&, time_point) override;
+		std::vector<object_ref> create_objects(std::span<const object_instance>, time_point) override;
 		object_ref clone_object(object_ref, time_point) override;
 		void destroy_object(object_ref, time_point) override;
 
@@ -87,6 +91,9 @@ namespace hades
 		std::vector<entity_id> get_removed_objects() noexcept override;
 
 		void name_object(std::string_view, object_ref, time_point);
+		// rolls the level back to the snapshot, see: state_api::restore_snapshot
+		//	objects that were erased or recreated are reported through get_new_objects and get_removed_objects
+		void restore_snapshot(const state_snapshot<game_system>&);
 
 		system_behaviours<game_system>& get_systems() noexcept
 		{ return _extras.systems; }
@@ -95,6 +102,7 @@ namespace hades
 		const game_state& get_state() const noexcept override { return _state; }
 		game_state& get_state() noexcept override { return _state; }
 		extra_state<game_system>& get_extras() noexcept override { return _extras; }
+		const extra_state<game_system>& get_extras() const noexcept { return _extras; }
 		const terrain_map& get_world_terrain() const noexcept override { return _terrain; }
 		world_rect_t get_world_bounds() const noexcept override {
 			return { {0.f, 0.f}, _size };
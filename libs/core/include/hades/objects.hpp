@@ -1,6 +1,9 @@
 #ifndef HADES_OBJECTS_HPP
 #define HADES_OBJECTS_HPP
 
+#include <cstdint>
+#include <limits>
+#include <utility>
 #include <vector>
 
 #include "hades/curve_extra.hpp"
@@ -80,6 +83,14 @@ namespace hades::resources
 		unloaded_curve_list curves;	// just the curves added by this object when parsed
 		curve_list all_curves; // all the curves on this object: calculated on load()
 
+		// the slots that non-const curves are stored in on game objects of this type
+		//	variable_layout: sorted curve ids, the index is the slot
+		//	variable_key_slots: the slot for each curve key(see resources::curve::key)
+		//	calculated on load()
+		static constexpr auto no_slot = std::numeric_limits<std::uint32_t>::max();
+		std::vector<unique_id> variable_layout;
+		std::vector<std::uint32_t> variable_key_slots;
+
 		//server systems
 		using system_list = std::vector<resource_link<system>>;
 		system_list systems,
@@ -93,6 +104,21 @@ namespace hades::resources
 		// tags
 		tag_list tags,
 			all_tags;
+
+		// flattened lookup data for this object and its bases, calculated on load()
+		//	object creation and curve/tag queries read this instead of walking base
+		struct prototype_data
+		{
+			// the index of each curve in all_curves, sorted by curve id
+			std::vector<std::pair<unique_id, std::uint32_t>> curve_index;
+			// the index in all_curves of each non-const curve, in variable_layout order
+			//	these are the curves created for each game object of this type
+			std::vector<std::uint32_t> object_curves;
+			// all_tags as a bitset, see: object_functions::get_tag_bit
+			std::vector<std::uint64_t> tag_bits;
+		};
+
+		prototype_data prototype;
 	};
 }
 
@@ -103,6 +129,14 @@ namespace hades::resources::object_functions
 	const std::vector<resource_link<system>>& get_systems(const object& o) noexcept;
 	const std::vector<resource_link<render_system>>& get_render_systems(const object& o) noexcept;
 	const tag_list& get_tags(const object& o) noexcept;
+	// each tag used by a loaded object is given a bit in object::prototype_data::tag_bits
+	//	returns no_tag_bit if no loaded object has the tag
+	constexpr auto no_tag_bit = std::numeric_limits<std::size_t>::max();
+	std::size_t get_tag_bit(unique_id);
+	// checks the prototypes tag bitset
+	bool has_tag(const object&, unique_id);
+	// as above, for a bit returned from get_tag_bit
+	bool has_tag_bit(const object&, std::size_t) noexcept;
 	struct inherited_tag_entry
 	{
 		unique_id tag, object;
@@ -117,6 +151,8 @@ namespace hades::resources::object_functions
 	// add curve to object, overriding inherited values
 	// or update the default value for this curve.
 	void add_curve(object&, unique_id, std::optional<curve_default_value> = {});
+	// returns object::no_slot if the curve isn't stored on objects of this type
+	std::uint32_t get_variable_slot(const object& o, unique_id) noexcept;
 	bool has_curve(const object& o, const curve& c) noexcept;
 	bool has_curve(const object& o, unique_id) noexcept;
 	//NOTE: the following curve functions throw curve_not_found if the object doesn't have that curve
@@ -0,0 +1,130 @@
+#ifndef HADES_REPLAY_HPP
+#define HADES_REPLAY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "hades/exceptions.hpp"
+#include "hades/files.hpp"
+#include "hades/game_state.hpp"
+#include "hades/game_system.hpp"
+#include "hades/input.hpp"
+#include "hades/time.hpp"
+
+// replays record the input sent to each level, and a hash of the game state after each tick
+//	playing the input back into a server created from the same mission must produce the same
+//	hashes, the first tick with a different hash is where the simulation diverged
+// the file starts with the mission source and player slot, followed by a stream of records
+//	unique_ids are written as names the first time they're used, so the file can be
+//	played back by another process
+
+namespace hades
+{
+	class replay_error : public runtime_error
+	{
+	public:
+		using runtime_error::runtime_error;
+	};
+
+	// a level was created, levels must be created in the same order when playing back
+	struct replay_level
+	{
+		unique_id level = unique_zero;
+	};
+
+	// actions sent to a level before a tick
+	struct replay_input
+	{
+		unique_id level = unique_zero;
+		unique_id player = unique_zero;
+		// the level time when the input was sent
+		time_point time;
+		std::vector<action> actions;
+	};
+
+	// the mission time and state hash after a tick
+	struct replay_tick
+	{
+		time_point time;
+		std::uint64_t hash = {};
+	};
+
+	// a level was hibernated after a tick, or woken before one, see: s_hibernate_after
+	//	levels woken by get_level aren't recorded, the same call wakes them when playing back
+	struct replay_hibernation
+	{
+		unique_id level = unique_zero;
+		bool hibernating = false;
+	};
+
+	using replay_record = std::variant<replay_level, replay_input, replay_tick, replay_hibernation>;
+
+	class replay_writer
+	{
+	public:
+		// mission is the mission source, see: serialise(const mission&)
+		//exception: replay_error if the file can't be opened
+		replay_writer(const std::filesystem::path&, std::string_view mission, std::string_view player_slot);
+
+		void record_level(unique_id level);
+		void record_input(unique_id level, unique_id player, time_point, const std::vector<action>&);
+		void record_tick(time_point, std::uint64_t hash);
+		void record_hibernation(unique_id level, bool hibernating);
+
+	private:
+		std::size_t _name_index(unique_id);
+		void _write_buffer();
+
+		files::ofstream _file;
+		std::unordered_map<unique_id, std::size_t> _names;
+		// records are packed here before being written to the file
+		std::vector<std::byte> _buffer;
+		time_point _last_tick;
+	};
+
+	class replay_reader
+	{
+	public:
+		//exception: replay_error if the file can't be opened or isn't a replay
+		explicit replay_reader(const std::filesystem::path&);
+
+		const string& mission() const noexcept
+		{
+			return _mission;
+		}
+
+		const string& player_slot() const noexcept
+		{
+			return _player_slot;
+		}
+
+		// reads the next record into out, returns false at the end of the file
+		//exception: replay_error if the file is truncated or corrupt
+		bool read(replay_record& out);
+
+	private:
+		files::ifstream _file;
+		string _mission;
+		string _player_slot;
+		// ids in the order they were named in the file
+		std::vector<unique_id> _names;
+		time_point _last_tick;
+	};
+
+	namespace state_api
+	{
+		// hashes the objects, their curves and names in the state
+		//	each curve is hashed with its variable id, its last keyframe and every keyframe after since
+		//	pass the time of the previous tick, so every keyframe written since then is checked
+		//	older keyframes and the number of keyframes aren't hashed, they depend on compaction and cold storage
+		//	settings, so those don't need to match the ones the replay was recorded with
+		//	unique_ids are hashed by name, so the result is the same in every process
+		std::uint64_t hash_state(time_point since, const game_state&, const extra_state<game_system>&);
+	}
+}
+
+#endif //!HADES_REPLAY_HPP
@@ -0,0 +1,135 @@
+#ifndef HADES_STATE_SNAPSHOT_HPP
+#define HADES_STATE_SNAPSHOT_HPP
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "hades/game_state.hpp"
+
+// snapshots are a point in time copy of a game_state and the system attachments
+//	in its extra_state, used for rollback and rewinding.
+// a snapshot shares everything that didn't change with the snapshot that was taken before it
+//	curves are compared by version(see: basic_curve::version), and only the curves
+//	that were written to are copied. objects are grouped into chunks by id, so a
+//	snapshot only holds new memory for the chunks that contain a changed object
+// take_snapshot can be given the objects that changed(eg. from the dirty curve list), so that
+//	the rest of the objects are shared without being looked at
+// not included: system data, level locals and cold storage
+
+namespace hades
+{
+	namespace detail
+	{
+		struct snapshot_curve
+		{
+			variable_id id = bad_variable;
+			std::pair<keyframe_style, curve_variable_type> info; // curve_info_t
+			std::uint64_t version = {};
+			// a copy of the CurveType<T> described by info
+			std::shared_ptr<const void> curve;
+		};
+
+		struct snapshot_object
+		{
+			entity_id id = bad_entity;
+			const resources::object* object_type = nullptr;
+			time_point creation_time;
+			std::optional<time_point> destruction_time;
+			// in the same order as game_obj::object_variables
+			std::vector<snapshot_curve> curves;
+		};
+
+		constexpr auto snapshot_chunk_size = std::size_t{ 64 };
+
+		// objects whose ids are in the same range of snapshot_chunk_size ids, sorted by id
+		struct snapshot_chunk
+		{
+			std::vector<std::shared_ptr<const snapshot_object>> objects;
+		};
+
+		template<typename SystemType>
+		struct snapshot_system
+		{
+			const typename SystemType::system_t* system = nullptr;
+			name_list attached_entities;
+			name_list sleeping_ents;
+			name_list new_ents;
+			name_list created_ents;
+			name_list removed_ents;
+		};
+	}
+
+	// built by state_api::take_snapshot
+	template<typename SystemType>
+	struct state_snapshot
+	{
+		time_point time;
+		entity_id next_id = bad_entity;
+		// indexed by id / snapshot_chunk_size, nullptr if the chunk has no objects
+		std::vector<std::shared_ptr<const detail::snapshot_chunk>> chunks;
+		std::shared_ptr<const object_name_map> names;
+		std::vector<std::shared_ptr<const detail::snapshot_system<SystemType>>> systems;
+
+		// returns nullptr if the object wasn't in the snapshot
+		const std::shared_ptr<const detail::snapshot_object>* find(entity_id) const noexcept;
+	};
+
+	namespace state_api
+	{
+		// objects changed by restore_snapshot
+		//	so that clients can be told about them
+		struct restored_objects
+		{
+			// objects that were recreated from the snapshot
+			std::vector<object_ref> created;
+			// objects that were erased because they didn't exist when the snapshot was taken
+			std::vector<entity_id> erased;
+		};
+
+		// copies the game state, sharing anything that hasn't changed since previous
+		//	previous should be the last snapshot taken of this state, or nullptr
+		//	the cost is a version check for each curve, plus a copy of each curve that changed
+		//	should be called between ticks
+		template<typename GameSystem>
+		state_snapshot<GameSystem> take_snapshot(time_point, const game_state&,
+			const extra_state<GameSystem>&, const state_snapshot<GameSystem>* previous = nullptr);
+
+		// as above, but only the objects in changed, and objects created since previous, are looked at
+		//	every other chunk and object is shared with previous without checking it
+		//	changed must contain every object that was written to or erased since previous was taken,
+		//	in any order; with dirty tracking on this is get_dirty_curves plus the erased objects
+		//	the cost is a pointer copy for each chunk, plus the cost above for each changed object
+		template<typename GameSystem>
+		state_snapshot<GameSystem> take_snapshot(time_point, const game_state&, const extra_state<GameSystem>&,
+			const state_snapshot<GameSystem>& previous, std::span<const entity_id> changed);
+
+		// returns the state to the way it was when the snapshot was taken
+		//	only curves that have changed since then are copied back
+		//	objects created since then are erased, and objects erased since then are recreated
+		//	should be called between ticks
+		template<typename GameSystem>
+		restored_objects restore_snapshot(const state_snapshot<GameSystem>&, game_state&, extra_state<GameSystem>&);
+	}
+
+	namespace state_api::detail
+	{
+		// returns previous if nothing in the object has changed
+		std::shared_ptr<const hades::detail::snapshot_object> take_object_snapshot(const game_obj&,
+			const game_state&, const std::shared_ptr<const hades::detail::snapshot_object>& previous);
+		// copies changed curves back into the object, and restores its creation and destruction times
+		//	returns false if the objects curves don't match the snapshot, the object should be recreated instead
+		bool restore_object_state(game_obj&, const hades::detail::snapshot_object&, game_state&);
+		// adds the snapshot curves to an object that has no curves, and restores its creation and destruction times
+		void insert_object_state(game_obj&, const hades::detail::snapshot_object&, game_state&);
+		// returns previous if none of the names have changed
+		std::shared_ptr<const object_name_map> take_names_snapshot(const object_name_map&,
+			const std::shared_ptr<const object_name_map>& previous);
+	}
+}
+
+#include "hades/detail/state_snapshot.inl"
+
+#endif //!HADES_STATE_SNAPSHOT_HPP
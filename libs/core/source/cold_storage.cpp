@@ -0,0 +1,351 @@
+#include "hades/cold_storage.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "hades/deflate.hpp"
+#include "hades/logging.hpp"
+#include "hades/utility.hpp"
+
+namespace hades
+{
+	namespace
+	{
+		using byte_buffer = std::vector<std::byte>;
+		using byte_span = std::span<const std::byte>;
+
+		void write_raw(byte_buffer& b, const void* data, const std::size_t size)
+		{
+			const auto pos = std::size(b);
+			b.resize(pos + size);
+			if (size != 0)
+				std::memcpy(b.data() + pos, data, size);
+			return;
+		}
+
+		void read_raw(byte_span& b, void* out, const std::size_t size)
+		{
+			if (std::size(b) < size)
+				throw cold_storage_error{ "cold storage data is truncated" };
+			if (size != 0)
+				std::memcpy(out, b.data(), size);
+			b = b.subspan(size);
+			return;
+		}
+
+		template<typename T>
+		void write_value(byte_buffer& b, const T& value)
+		{
+			if constexpr (std::is_same_v<T, std::monostate>)
+				return;
+			else if constexpr (std::is_same_v<T, object_ref>)
+				// the ptr will be stale by the time this is read
+				write_value(b, value.id);
+			else if constexpr (std::is_same_v<T, string>)
+			{
+				write_value(b, std::size(value));
+				write_raw(b, value.data(), std::size(value));
+			}
+			else if constexpr (curve_types::is_collection_type_v<T>)
+			{
+				write_value(b, std::size(value));
+				for (const auto& v : value)
+					write_value(b, v);
+			}
+			else
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				write_raw(b, &value, sizeof(T));
+			}
+			return;
+		}
+
+		// reads a count and checks that there is enough data left for it
+		std::size_t read_count(byte_span& b, const std::size_t element_size)
+		{
+			auto count = std::size_t{};
+			read_raw(b, &count, sizeof(count));
+			if (element_size != 0 && count > std::size(b) / element_size)
+				throw cold_storage_error{ "cold storage data is truncated" };
+			return count;
+		}
+
+		template<typename T>
+		T read_value(byte_span& b)
+		{
+			if constexpr (std::is_same_v<T, std::monostate>)
+				return {};
+			else if constexpr (std::is_same_v<T, object_ref>)
+				return object_ref{ read_value<entity_id>(b), nullptr };
+			else if constexpr (std::is_same_v<T, string>)
+			{
+				auto out = string(read_count(b, 1), '\0');
+				read_raw(b, out.data(), std::size(out));
+				return out;
+			}
+			else if constexpr (curve_types::is_collection_type_v<T>)
+			{
+				const auto count = read_count(b, 1);
+				auto out = T{};
+				out.reserve(count);
+				for (auto i = std::size_t{}; i < count; ++i)
+					out.emplace_back(read_value<typename T::value_type>(b));
+				return out;
+			}
+			else
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				auto out = T{};
+				read_raw(b, &out, sizeof(T));
+				return out;
+			}
+		}
+
+		void write_curve_value(byte_buffer& b, const resources::curve_default_value& v)
+		{
+			write_value(b, integer_cast<std::uint8_t>(v.index()));
+			std::visit([&b](const auto& value) {
+				write_value(b, value);
+				return;
+				}, v);
+			return;
+		}
+
+		template<std::size_t... Index>
+		resources::curve_default_value read_curve_value_impl(byte_span& b, const std::size_t index, std::index_sequence<Index...>)
+		{
+			using variant_t = resources::curve_default_value;
+			auto out = variant_t{};
+			const auto found = ((index == Index ?
+				(out.template emplace<Index>(read_value<std::variant_alternative_t<Index, variant_t>>(b)), true) :
+				false) || ...);
+
+			if (!found)
+				throw cold_storage_error{ "unexpected curve type in cold storage" };
+			return out;
+		}
+
+		resources::curve_default_value read_curve_value(byte_span& b)
+		{
+			const auto index = read_value<std::uint8_t>(b);
+			return read_curve_value_impl(b, index,
+				std::make_index_sequence<std::variant_size_v<resources::curve_default_value>>{});
+		}
+
+		void write_object(byte_buffer& b, const object_save_instance& o)
+		{
+			write_value(b, reinterpret_cast<std::uintptr_t>(o.obj_type));
+			write_value(b, o.id);
+			write_value(b, o.name_id);
+			write_value(b, o.creation_time);
+			write_value(b, o.destruction_time);
+			write_value(b, std::size(o.curves));
+			for (const auto& c : o.curves)
+			{
+				write_value(b, reinterpret_cast<std::uintptr_t>(c.curve));
+				write_value(b, std::size(c.keyframes));
+				for (const auto& k : c.keyframes)
+				{
+					write_value(b, k.time);
+					write_curve_value(b, k.value);
+				}
+			}
+			return;
+		}
+
+		object_save_instance read_object(byte_span b)
+		{
+			auto o = object_save_instance{};
+			o.obj_type = reinterpret_cast<const resources::object*>(read_value<std::uintptr_t>(b));
+			o.id = read_value<entity_id>(b);
+			o.name_id = read_value<string>(b);
+			o.creation_time = read_value<time_point>(b);
+			o.destruction_time = read_value<time_point>(b);
+			const auto curve_count = read_count(b, sizeof(std::uintptr_t));
+			o.curves.reserve(curve_count);
+			for (auto i = std::size_t{}; i < curve_count; ++i)
+			{
+				auto& c = o.curves.emplace_back();
+				c.curve = reinterpret_cast<const resources::curve*>(read_value<std::uintptr_t>(b));
+				const auto keyframe_count = read_count(b, sizeof(time_point));
+				c.keyframes.reserve(keyframe_count);
+				for (auto j = std::size_t{}; j < keyframe_count; ++j)
+				{
+					auto& k = c.keyframes.emplace_back();
+					k.time = read_value<time_point>(b);
+					k.value = read_curve_value(b);
+				}
+			}
+
+			return o;
+		}
+	}
+
+	void cold_object_store::insert(const object_save_instance& o)
+	{
+		const auto offset = std::size(_pending);
+		try
+		{
+			write_object(_pending, o);
+		}
+		catch (...)
+		{
+			_pending.resize(offset);
+			throw;
+		}
+
+		// if the id was already stored, then the old data is left unreferenced in its block
+		_index.insert_or_assign(o.id, entry{ std::size(_blocks), offset, std::size(_pending) - offset });
+		if (std::size(_pending) >= block_size)
+			_compress_pending();
+		return;
+	}
+
+	bool cold_object_store::contains(const entity_id id) const noexcept
+	{
+		return _index.contains(id);
+	}
+
+	std::optional<object_save_instance> cold_object_store::find(const entity_id id) const
+	{
+		const auto iter = _index.find(id);
+		if (iter == end(_index))
+			return std::nullopt;
+
+		const auto& e = iter->second;
+		if (e.block == std::size(_blocks))
+			return read_object(byte_span{ _pending }.subspan(e.offset, e.size));
+
+		const auto bytes = _read_block(_blocks[e.block]);
+		if (e.offset + e.size > std::size(bytes))
+			throw cold_storage_error{ "cold storage block is smaller than expected" };
+		return read_object(byte_span{ bytes }.subspan(e.offset, e.size));
+	}
+
+	std::vector<object_save_instance> cold_object_store::get_all() const
+	{
+		// group the objects by block, so that each block is only read once
+		auto entries = std::vector<const entry*>{};
+		entries.reserve(std::size(_index));
+		for (const auto& [id, e] : _index)
+			entries.emplace_back(&e);
+
+		std::sort(begin(entries), end(entries), [](const entry* l, const entry* r) noexcept {
+			return std::tie(l->block, l->offset) < std::tie(r->block, r->offset);
+			});
+
+		auto out = std::vector<object_save_instance>{};
+		out.reserve(std::size(entries));
+		auto bytes = std::vector<std::byte>{};
+		auto current_block = std::size(_blocks);
+		for (const auto e : entries)
+		{
+			if (e->block == std::size(_blocks))
+			{
+				out.emplace_back(read_object(byte_span{ _pending }.subspan(e->offset, e->size)));
+				continue;
+			}
+
+			if (e->block != current_block)
+			{
+				bytes = _read_block(_blocks[e->block]);
+				current_block = e->block;
+			}
+
+			if (e->offset + e->size > std::size(bytes))
+				throw cold_storage_error{ "cold storage block is smaller than expected" };
+			out.emplace_back(read_object(byte_span{ bytes }.subspan(e->offset, e->size)));
+		}
+
+		std::sort(begin(out), end(out), [](const object_save_instance& l, const object_save_instance& r) noexcept {
+			return l.id < r.id;
+			});
+		return out;
+	}
+
+	std::size_t cold_object_store::memory_usage() const noexcept
+	{
+		auto total = std::size(_pending);
+		for (const auto& b : _blocks)
+			total += std::size(b.data);
+		return total;
+	}
+
+	void cold_object_store::set_spill_to_disk(const bool spill)
+	{
+		_spill_to_disk = spill;
+		return;
+	}
+
+	void cold_object_store::set_compression_level(const int level) noexcept
+	{
+		_compression_level = std::clamp(level, 1, 9);
+		return;
+	}
+
+	void cold_object_store::_compress_pending()
+	{
+		auto b = block{ zip::deflate(_pending, _compression_level), std::size(_pending) };
+
+		if (_spill_to_disk && !_spill_file)
+		{
+			// tmpfile is removed automatically once it's closed
+			_spill_file.reset(std::tmpfile());
+			if (!_spill_file)
+			{
+				LOGWARNING("Unable to create a file for cold storage, keeping objects in memory");
+				_spill_to_disk = false;
+			}
+		}
+
+		if (_spill_to_disk)
+		{
+			const auto file = _spill_file.get();
+			if (std::fseek(file, 0, SEEK_END) == 0)
+			{
+				const auto offset = std::ftell(file);
+				const auto written = std::fwrite(b.data.data(), 1, std::size(b.data), file);
+				if (offset >= 0 && written == std::size(b.data))
+				{
+					b.file_offset = offset;
+					b.file_size = written;
+					b.data = {};
+				}
+				else
+					LOGWARNING("Failed to write cold storage block to disk, keeping it in memory");
+			}
+		}
+
+		_blocks.emplace_back(std::move(b));
+		_pending.clear();
+		return;
+	}
+
+	std::vector<std::byte> cold_object_store::_read_block(const block& b) const
+	{
+		if (b.file_offset < 0)
+			return zip::inflate<std::byte>(b.data, b.uncompressed_size);
+
+		assert(_spill_file);
+		const auto file = _spill_file.get();
+		auto data = std::vector<std::byte>(b.file_size);
+		if (std::fseek(file, b.file_offset, SEEK_SET) != 0 ||
+			std::fread(data.data(), 1, b.file_size, file) != b.file_size)
+			throw cold_storage_error{ "unable to read cold storage block from disk" };
+
+		return zip::inflate<std::byte>(data, b.uncompressed_size);
+	}
+
+	void cold_object_store::file_closer::operator()(std::FILE* f) const noexcept
+	{
+		std::fclose(f);
+		return;
+	}
+}
@@ -1,3 +1,468 @@
 #include "hades/export_curves.hpp"
 
-//TODO: remove this file
\ No newline at end of file
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "hades/tuple.hpp"
+#include "hades/detail/varint.hpp"
+
+namespace hades
+{
+	namespace
+	{
+		using byte_buffer = std::vector<std::byte>;
+		using byte_span = std::span<const std::byte>;
+
+		// increase this whenever the layout below is changed
+		constexpr auto export_format_version = std::uint8_t{ 2 };
+
+		void write_byte(byte_buffer& b, const std::uint8_t v)
+		{
+			b.push_back(std::byte{ v });
+			return;
+		}
+
+		using detail::write_varint;
+		using detail::write_signed;
+
+		void write_raw(byte_buffer& b, const void* data, const std::size_t size)
+		{
+			const auto pos = std::size(b);
+			b.resize(pos + size);
+			if (size != 0)
+				std::memcpy(b.data() + pos, data, size);
+			return;
+		}
+
+		void write_string(byte_buffer& b, const types::string& s)
+		{
+			write_varint(b, std::size(s));
+			write_raw(b, s.data(), std::size(s));
+			return;
+		}
+
+		void write_time(byte_buffer& b, const time_point t, const time_point previous)
+		{
+			write_signed(b, (t - previous).count());
+			return;
+		}
+
+		void write_entity(byte_buffer& b, const entity_id e, const entity_id previous)
+		{
+			write_signed(b, std::int64_t{ to_value(e) } - std::int64_t{ to_value(previous) });
+			return;
+		}
+
+		template<typename T>
+		void write_value(byte_buffer& b, const T& value)
+		{
+			if constexpr (std::is_same_v<T, bool>)
+				write_byte(b, value ? 1 : 0);
+			else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+				write_signed(b, value);
+			else if constexpr (std::is_same_v<T, types::string>)
+				write_string(b, value);
+			else if constexpr (std::is_same_v<T, object_ref>)
+				write_varint(b, to_value(value.id));
+			else if constexpr (std::is_same_v<T, unique_id>)
+				write_varint(b, value.get());
+			else if constexpr (std::is_same_v<T, time_duration>)
+				write_signed(b, value.count());
+			else if constexpr (curve_types::is_collection_type_v<T>)
+			{
+				write_varint(b, std::size(value));
+				for (const auto& v : value)
+					write_value(b, v);
+			}
+			else
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				write_raw(b, &value, sizeof(T));
+			}
+			return;
+		}
+
+		template<typename T>
+		void write_curve_list(byte_buffer& b, const std::vector<curve_export_set<T>>& list, const time_point since)
+		{
+			write_varint(b, std::size(list));
+			auto prev_entity = bad_entity;
+			for (const auto& set : list)
+			{
+				write_entity(b, set.entity, prev_entity);
+				prev_entity = set.entity;
+				write_varint(b, set.variable.get());
+				write_byte(b, enum_type(set.style));
+				write_varint(b, std::size(set.keyframes));
+				auto prev_time = since;
+				for (const auto& [t, value] : set.keyframes)
+				{
+					write_time(b, t, prev_time);
+					prev_time = t;
+					write_value(b, value);
+				}
+			}
+			return;
+		}
+
+		[[noreturn]] void throw_truncated()
+		{
+			throw export_error{ "exported curve data is truncated" };
+		}
+
+		std::uint8_t read_byte(byte_span& b)
+		{
+			if (std::empty(b))
+				throw_truncated();
+			const auto out = std::to_integer<std::uint8_t>(b.front());
+			b = b.subspan(1);
+			return out;
+		}
+
+		std::uint64_t read_varint(byte_span& b)
+		{
+			const auto out = detail::read_varint([&b] { return read_byte(b); });
+			if (!out)
+				throw export_error{ "exported curve data contains an invalid integer" };
+			return *out;
+		}
+
+		std::int64_t read_signed(byte_span& b)
+		{
+			return detail::zigzag_decode(read_varint(b));
+		}
+
+		template<typename T>
+		T read_integer(byte_span& b)
+		{
+			using limits = std::numeric_limits<T>;
+			if constexpr (std::is_signed_v<T>)
+			{
+				const auto v = read_signed(b);
+				if (v < limits::min() || v > limits::max())
+					throw export_error{ "exported curve data contains an integer that is out of range" };
+				return static_cast<T>(v);
+			}
+			else
+			{
+				const auto v = read_varint(b);
+				if (v > limits::max())
+					throw export_error{ "exported curve data contains an integer that is out of range" };
+				return static_cast<T>(v);
+			}
+		}
+
+		void read_raw(byte_span& b, void* out, const std::size_t size)
+		{
+			if (std::size(b) < size)
+				throw_truncated();
+			if (size != 0)
+				std::memcpy(out, b.data(), size);
+			b = b.subspan(size);
+			return;
+		}
+
+		// every element uses at least one byte, so a count larger than
+		// the remaining data must be corrupt
+		std::size_t read_count(byte_span& b)
+		{
+			const auto count = read_varint(b);
+			if (count > std::size(b))
+				throw_truncated();
+			return integer_cast<std::size_t>(count);
+		}
+
+		types::string read_string(byte_span& b)
+		{
+			auto out = types::string(read_count(b), '\0');
+			read_raw(b, out.data(), std::size(out));
+			return out;
+		}
+
+		unique_id read_unique_id(byte_span& b)
+		{
+			const auto value = read_varint(b);
+			auto out = unique_id{};
+			static_assert(sizeof(out) == sizeof(value) && std::is_trivially_copyable_v<unique_id>);
+			std::memcpy(&out, &value, sizeof(out));
+			return out;
+		}
+
+		time_point read_time(byte_span& b, const time_point previous)
+		{
+			return previous + time_duration{ read_signed(b) };
+		}
+
+		entity_id read_entity(byte_span& b, const entity_id previous)
+		{
+			using value_type = entity_id::value_type;
+			const auto v = std::int64_t{ to_value(previous) } + read_signed(b);
+			if (v < std::numeric_limits<value_type>::min() || v > std::numeric_limits<value_type>::max())
+				throw export_error{ "exported curve data contains an invalid entity id" };
+			return entity_id{ static_cast<value_type>(v) };
+		}
+
+		keyframe_style read_style(byte_span& b)
+		{
+			const auto style = keyframe_style{ read_byte(b) };
+			if (style >= keyframe_style::const_t)
+				throw export_error{ "exported curve data contains an invalid keyframe style" };
+			return style;
+		}
+
+		template<typename T>
+		T read_value(byte_span& b)
+		{
+			if constexpr (std::is_same_v<T, bool>)
+				return read_byte(b) != 0;
+			else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+				return read_integer<T>(b);
+			else if constexpr (std::is_same_v<T, types::string>)
+				return read_string(b);
+			else if constexpr (std::is_same_v<T, object_ref>)
+				return object_ref{ entity_id{ read_integer<entity_id::value_type>(b) } };
+			else if constexpr (std::is_same_v<T, unique_id>)
+				return read_unique_id(b);
+			else if constexpr (std::is_same_v<T, time_duration>)
+				return time_duration{ read_signed(b) };
+			else if constexpr (curve_types::is_collection_type_v<T>)
+			{
+				const auto count = read_count(b);
+				auto out = T{};
+				out.reserve(count);
+				for (auto i = std::size_t{}; i < count; ++i)
+					out.emplace_back(read_value<typename T::value_type>(b));
+				return out;
+			}
+			else
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				auto out = T{};
+				read_raw(b, &out, sizeof(T));
+				return out;
+			}
+		}
+
+		template<typename T>
+		void read_curve_list(byte_span& b, std::vector<curve_export_set<T>>& list, const time_point since)
+		{
+			const auto count = read_count(b);
+			list.reserve(count);
+			auto prev_entity = bad_entity;
+			for (auto i = std::size_t{}; i < count; ++i)
+			{
+				auto& set = list.emplace_back();
+				set.entity = prev_entity = read_entity(b, prev_entity);
+				set.variable = read_unique_id(b);
+				set.style = read_style(b);
+				const auto keyframes = read_count(b);
+				set.keyframes.reserve(keyframes);
+				auto prev_time = since;
+				for (auto j = std::size_t{}; j < keyframes; ++j)
+				{
+					prev_time = read_time(b, prev_time);
+					set.keyframes.emplace_back(prev_time, read_value<T>(b));
+				}
+			}
+			return;
+		}
+	}
+
+	void exported_curves::clear() noexcept
+	{
+		created_objects.clear();
+		destroyed_objects.clear();
+		left_objects.clear();
+		entity_names.clear();
+		std::apply([](auto&... list) noexcept {
+			(list.clear(), ...);
+			return;
+			}, curves);
+		return;
+	}
+
+	bool exported_curves::empty() const noexcept
+	{
+		auto no_curves = true;
+		tuple_for_each(curves, [&no_curves](const auto& list) noexcept {
+			no_curves = no_curves && std::empty(list);
+			return;
+			});
+
+		return no_curves && std::empty(created_objects) &&
+			std::empty(destroyed_objects) && std::empty(left_objects) &&
+			std::empty(entity_names);
+	}
+
+	void write_exported_curves(const exported_curves& c, std::vector<std::byte>& out)
+	{
+		write_byte(out, export_format_version);
+		write_signed(out, c.since.time_since_epoch().count());
+
+		write_varint(out, std::size(c.created_objects));
+		auto prev_entity = bad_entity;
+		for (const auto& o : c.created_objects)
+		{
+			write_entity(out, o.id, prev_entity);
+			prev_entity = o.id;
+			write_varint(out, o.object_type.get());
+			write_time(out, o.creation_time, c.since);
+		}
+
+		write_varint(out, std::size(c.destroyed_objects));
+		prev_entity = bad_entity;
+		for (const auto& [id, t] : c.destroyed_objects)
+		{
+			write_entity(out, id, prev_entity);
+			prev_entity = id;
+			write_time(out, t, c.since);
+		}
+
+		write_varint(out, std::size(c.left_objects));
+		prev_entity = bad_entity;
+		for (const auto id : c.left_objects)
+		{
+			write_entity(out, id, prev_entity);
+			prev_entity = id;
+		}
+
+		write_varint(out, std::size(c.entity_names));
+		for (const auto& n : c.entity_names)
+		{
+			write_string(out, n.name);
+			write_varint(out, to_value(n.entity));
+			write_time(out, n.time, c.since);
+		}
+
+		tuple_for_each(c.curves, [&out, since = c.since](const auto& list) {
+			write_curve_list(out, list, since);
+			return;
+			});
+		return;
+	}
+
+	void read_exported_curves(std::span<const std::byte> b, exported_curves& out)
+	{
+		out.clear();
+		if (read_byte(b) != export_format_version)
+			throw export_error{ "exported curve data was written by an incompatible version" };
+
+		out.since = time_point{ time_duration{ read_signed(b) } };
+
+		const auto created = read_count(b);
+		out.created_objects.reserve(created);
+		auto prev_entity = bad_entity;
+		for (auto i = std::size_t{}; i < created; ++i)
+		{
+			auto& o = out.created_objects.emplace_back();
+			o.id = prev_entity = read_entity(b, prev_entity);
+			o.object_type = read_unique_id(b);
+			o.creation_time = read_time(b, out.since);
+		}
+
+		const auto destroyed = read_count(b);
+		out.destroyed_objects.reserve(destroyed);
+		prev_entity = bad_entity;
+		for (auto i = std::size_t{}; i < destroyed; ++i)
+		{
+			prev_entity = read_entity(b, prev_entity);
+			out.destroyed_objects.emplace_back(prev_entity, read_time(b, out.since));
+		}
+
+		const auto left = read_count(b);
+		out.left_objects.reserve(left);
+		prev_entity = bad_entity;
+		for (auto i = std::size_t{}; i < left; ++i)
+			out.left_objects.emplace_back(prev_entity = read_entity(b, prev_entity));
+
+		const auto names = read_count(b);
+		out.entity_names.reserve(names);
+		for (auto i = std::size_t{}; i < names; ++i)
+		{
+			auto& n = out.entity_names.emplace_back();
+			n.name = read_string(b);
+			n.entity = entity_id{ read_integer<entity_id::value_type>(b) };
+			n.time = read_time(b, out.since);
+		}
+
+		// read in the same order as write_exported_curves
+		std::apply([&b, since = out.since](auto&... list) {
+			(read_curve_list(b, list, since), ...);
+			return;
+			}, out.curves);
+
+		if (!std::empty(b))
+			throw export_error{ "unexpected data after the end of the exported curves" };
+		return;
+	}
+}
+
+namespace hades::state_api::detail
+{
+	namespace
+	{
+		struct export_curve_visitor
+		{
+			const game_obj::var_entry& entry;
+			entity_id id;
+			time_point since;
+			exported_curves& out;
+			bool include_current;
+
+			template<template<typename> typename CurveType, typename T>
+			void operator()()
+			{
+				const auto& keyframes = static_cast<const state_field<CurveType<T>>*>(entry.var)->data.keyframes();
+				// most curves won't have changed, so check the last keyframe before searching
+				if (std::empty(keyframes) || (!include_current && keyframes.back().time <= since))
+					return;
+
+				auto first = std::upper_bound(std::begin(keyframes), std::end(keyframes), since, [](const time_point t, const auto& k) noexcept {
+					return t < k.time;
+					});
+
+				if (include_current && first != std::begin(keyframes))
+					--first;
+
+				auto& set = out.get<T>().emplace_back(curve_export_set<T>{ id, entry.id, entry.info.first });
+				set.keyframes.reserve(integer_cast<std::size_t>(std::distance(first, std::end(keyframes))));
+				for (auto iter = first; iter != std::end(keyframes); ++iter)
+					set.keyframes.emplace_back(iter->time, iter->value);
+				return;
+			}
+		};
+	}
+
+	void export_object_curves(const game_obj& o, const time_point since, exported_curves& out, const bool include_current)
+	{
+		for (const auto& entry : o.object_variables)
+			call_with_curve_info(entry.info, export_curve_visitor{ entry, o.id, since, out, include_current });
+		return;
+	}
+
+	void sort_exported_curves(exported_curves& c)
+	{
+		std::sort(begin(c.created_objects), end(c.created_objects), [](const auto& l, const auto& r) noexcept {
+			return l.id < r.id;
+			});
+
+		std::sort(begin(c.destroyed_objects), end(c.destroyed_objects), [](const auto& l, const auto& r) noexcept {
+			return l.first < r.first;
+			});
+
+		std::sort(begin(c.left_objects), end(c.left_objects));
+
+		const auto by_entity = [](const auto& l, const auto& r) noexcept {
+			return l.entity == r.entity ? l.variable < r.variable : l.entity < r.entity;
+		};
+
+		std::apply([by_entity](auto&... list) {
+			(std::sort(begin(list), end(list), by_entity), ...);
+			return;
+			}, c.curves);
+		return;
+	}
+}
@@ -66,7 +66,8 @@ namespace hades
 		void destroy_system_data()
 		{
 			auto game_data_ptr = detail::get_game_data_ptr();
-			assert(game_data_ptr->system_data);
+			if (!game_data_ptr->system_data)
+				throw system_error{ "System data isn't available outside of a system, such as in deferred level calls" };
 			game_data_ptr->system_data->reset();
 		}
 	}
@@ -88,17 +89,35 @@ namespace hades
 		void switch_level(unique_id id)
 		{
 			auto ptr = detail::get_game_data_ptr();
-			detail::change_level(std::invoke(ptr->get_level, id), id);
+			if (!ptr->get_level)
+				throw system_error{ "Cannot switch level while levels are being ticked concurrently; use defer_to_level" };
+			const auto level = std::invoke(ptr->get_level, id);
+			if (!level)
+				throw system_error{ "Cannot switch to a level that isn't available, it may be hibernating; use defer_to_level" };
+			detail::change_level(level, id);
 			return;
 		}
 
-		void switch_to_mission() noexcept
+		void switch_to_mission()
 		{
 			auto ptr = detail::get_game_data_ptr();
+			// other levels and systems read the mission while they're being ticked
+			if (!ptr->get_level || ptr->concurrent_tick)
+				throw system_error{ "Cannot switch to the mission while levels are being ticked concurrently; use defer_to_level" };
 			detail::change_level(ptr->mission_data, {});
 			return;
 		}
 
+		void defer_to_level(unique_id id, std::function<void()> f)
+		{
+			auto ptr = detail::get_game_data_ptr();
+			assert(!ptr->concurrent_tick);
+			if (!ptr->deferred_calls)
+				throw system_error{ "Deferred level calls aren't available here" };
+			ptr->deferred_calls->emplace_back(deferred_level_call{ id, std::move(f) });
+			return;
+		}
+
 		world_rect_t get_world_bounds()
 		{
 			const auto ptr = detail::get_game_level_ptr();
@@ -122,6 +141,8 @@ namespace hades
 
 		object_ref create(const object_instance& obj)
 		{
+			// systems ticked concurrently cannot change the object list
+			assert(!hades::detail::get_game_data_ptr()->concurrent_tick);
 			auto ptr = hades::detail::get_game_level_ptr();
 			assert(obj.id == bad_entity);
 			auto new_obj = ptr->create_object(obj, get_time());
@@ -129,14 +150,26 @@ namespace hades
 			return new_obj;
 		}
 
+		std::vector<object_ref> create_objects(const std::span<const object_instance> objs)
+		{
+			// systems ticked concurrently cannot change the object list
+			assert(!hades::detail::get_game_data_ptr()->concurrent_tick);
+			auto ptr = hades::detail::get_game_level_ptr();
+			return ptr->create_objects(objs, get_time());
+		}
+
 		object_ref clone(object_ref o)
 		{
+			// systems ticked concurrently cannot change the object list
+			assert(!hades::detail::get_game_data_ptr()->concurrent_tick);
 			auto ptr = hades::detail::get_game_level_ptr();
 			return ptr->clone_object(o, get_time());
 		}
 
 		void destroy(object_ref e)
 		{
+			// systems ticked concurrently cannot change the object list
+			assert(!hades::detail::get_game_data_ptr()->concurrent_tick);
 			auto ptr = hades::detail::get_game_level_ptr();
 			ptr->destroy_object(e, get_time());
 			return;
@@ -145,6 +178,8 @@ namespace hades
 		void sleep_system(object_ref o, time_point t)
 		{
 			auto game_ptr = hades::detail::get_game_data_ptr();
+			if (game_ptr->system == unique_zero)
+				throw system_error{ "Cannot sleep entities outside of a system, such as in deferred level calls" };
 			auto sys_ptr = hades::detail::get_game_systems_ptr();
 			sys_ptr->sleep_entity(o, game_ptr->system, t);
 			return;
@@ -167,6 +202,14 @@ namespace hades
 			return resources::object_functions::get_tags(*obj.object_type);
 		}
 
+		bool has_tag(object_ref o, const unique_id t)
+		{
+			const auto game_data_ptr = hades::detail::get_game_level_ptr();
+			auto& extra = game_data_ptr->get_extras();
+			const auto& obj = state_api::get_object(o, extra);
+			return resources::object_functions::has_tag(*obj.object_type, t);
+		}
+
 		bool is_alive(object_ref& o) noexcept
 		{
 			auto ptr = hades::detail::get_game_level_ptr();
@@ -1,91 +1,350 @@
 #include "hades/game_state.hpp"
 
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+
+#include "hades/data.hpp"
+
 namespace hades::detail
 {
-	constexpr auto bad_size = std::numeric_limits<std::size_t>::max();
-	static constexpr std::size_t find_first_empty(const std::vector<bool>& e) noexcept
+	namespace
 	{
-		const auto siz = size(e);
-		for (auto i = std::size_t{}; i < siz; ++i)
+		struct level_local_registry
+		{
+			std::shared_mutex mut;
+			std::unordered_map<unique_id, level_local_info> locals;
+			// size of locals, readable without taking the lock
+			std::atomic_size_t count = {};
+		};
+
+		level_local_registry& get_level_local_registry() noexcept
 		{
-			if (e[i] == game_object_collection::empty_flag)
-				return i;
+			static auto registry = level_local_registry{};
+			return registry;
+		}
+
+		void check_level_local_type(const unique_id id, const level_local_info& l, const void* type)
+		{
+			using namespace std::string_literals;
+			if (l.type != type)
+			{
+				throw state_api::level_local_wrong_type{ "Level local: "s + to_string(id) +
+					", was registered with a different type"s };
+			}
+			return;
 		}
-		return bad_size;
 	}
 
-	game_obj* game_object_collection::insert()
+	std::size_t register_level_local(const unique_id id, const void* type)
 	{
-		const auto empty_index = find_first_empty(_emptys);
-		++_size;
-		if (empty_index > std::size(_emptys))
+		auto& reg = get_level_local_registry();
+		const auto lock = std::scoped_lock{ reg.mut };
+		const auto iter = reg.locals.find(id);
+		if (iter != end(reg.locals))
 		{
-			// this is why we're not noexcept
-			_emptys.emplace_back(not_empty_flag);
-			return &_data.emplace_back(game_obj{});
+			check_level_local_type(id, iter->second, type);
+			return iter->second.slot;
 		}
 
-		_emptys[empty_index] = not_empty_flag;
-		return &_data[empty_index];
+		const auto slot = size(reg.locals);
+		reg.locals.emplace(id, level_local_info{ slot, type });
+		reg.count.store(size(reg.locals), std::memory_order_release);
+		return slot;
+	}
+
+	const level_local_info* find_level_local(const unique_id id, const void* type)
+	{
+		auto& reg = get_level_local_registry();
+		const auto lock = std::shared_lock{ reg.mut };
+		const auto iter = reg.locals.find(id);
+		if (iter == end(reg.locals))
+			return nullptr;
+
+		check_level_local_type(id, iter->second, type);
+		// unordered_map nodes are stable, and entries are never removed
+		return &iter->second;
+	}
+
+	std::size_t level_local_count() noexcept
+	{
+		return get_level_local_registry().count.load(std::memory_order_acquire);
+	}
+
+	void game_object_collection::reserve(const std::size_t count)
+	{
+		_index.reserve(count);
+		_occupied.reserve((count + word_bits - 1) / word_bits);
+		return;
 	}
 
 	game_obj* game_object_collection::insert(game_obj o)
 	{
-		auto ptr = insert();
-		*ptr = std::move(o);
-		return ptr;
+		assert(o.id != bad_entity);
+		auto index = _free_head;
+		const auto new_slot = index == npos;
+		if (new_slot)
+		{
+			// this is why we're not noexcept
+			index = std::size(_data);
+			if (index % word_bits == 0)
+				_occupied.emplace_back();
+			_data.emplace_back();
+		}
+
+		[[maybe_unused]] const auto [iter, inserted] = _index.try_emplace(o.id, index);
+		assert(inserted);
+
+		auto& s = _data[index];
+		if (!new_slot)
+			_free_head = std::exchange(s.next_free, npos);
+
+		s.object = std::move(o);
+		_occupied[index / word_bits] |= word_type{ 1 } << (index % word_bits);
+		++_size;
+		return &s.object;
 	}
 
 	void game_object_collection::erase(game_obj* o) noexcept
 	{
 		assert(o);
-		const auto size = std::size(_emptys);
-		for (auto i = std::size_t{}; i < size; ++i)
+		const auto iter = _index.find(o->id);
+		if (iter == std::end(_index))
+			return;
+
+		const auto index = iter->second;
+		auto& s = _data[index];
+		assert(&s.object == o);
+		_index.erase(iter);
+		s.object.id = bad_entity;
+		s.next_free = std::exchange(_free_head, index);
+		_occupied[index / word_bits] &= ~(word_type{ 1 } << (index % word_bits));
+		--_size;
+		return;
+	}
+
+	const game_obj* game_object_collection::find(const entity_id e) const noexcept
+	{
+		const auto iter = _index.find(e);
+		return iter == std::end(_index) ? nullptr : &_data[iter->second].object;
+	}
+
+	game_obj* game_object_collection::find(const entity_id e) noexcept
+	{
+		const auto iter = _index.find(e);
+		return iter == std::end(_index) ? nullptr : &_data[iter->second].object;
+	}
+
+	object_time_map::const_iterator object_time_map::find(const entity_id id) const
+	{
+		return _times.find(id);
+	}
+
+	time_point object_time_map::at(const entity_id id) const
+	{
+		return _times.at(id);
+	}
+
+	bool object_time_map::contains(const entity_id id) const
+	{
+		return _times.contains(id);
+	}
+
+	void object_time_map::reserve(const std::size_t count)
+	{
+		_times.reserve(count);
+		_by_time.reserve(count);
+		return;
+	}
+
+	void object_time_map::insert_or_assign(const entity_id id, const time_point t)
+	{
+		const auto [iter, inserted] = _times.try_emplace(id, t);
+		if (!inserted)
 		{
-			if (_data[i].id == o->id)
-			{
-				_emptys[i] = empty_flag;
-				_data[i].id = bad_entity;
-				--_size;
+			if (iter->second == t)
 				return;
-			}
+			_erase_index(id, iter->second);
+			iter->second = t;
 		}
 
+		const auto entry = std::pair{ t, id };
+		if (std::empty(_by_time) || _by_time.back() < entry)
+			_by_time.emplace_back(entry);
+		else
+			_by_time.insert(std::upper_bound(std::begin(_by_time), std::end(_by_time), entry), entry);
 		return;
 	}
 
-	template<typename EmptyList, typename DataDeque>
-	auto game_obj_find_impl(const entity_id e, EmptyList& emptys, DataDeque& data) 
-		-> std::conditional_t<std::is_const_v<EmptyList>, const game_obj*, game_obj*>
+	void object_time_map::erase(const entity_id id)
 	{
-		const auto siz = std::size(emptys);
-		for (auto i = std::size_t{}; i < siz; ++i)
+		const auto iter = _times.find(id);
+		if (iter == std::end(_times))
+			return;
+
+		_erase_index(id, iter->second);
+		_times.erase(iter);
+		return;
+	}
+
+	void object_time_map::clear() noexcept
+	{
+		_times.clear();
+		_by_time.clear();
+		return;
+	}
+
+	void object_time_map::_erase_index(const entity_id id, const time_point t) noexcept
+	{
+		const auto entry = std::pair{ t, id };
+		const auto iter = std::lower_bound(std::begin(_by_time), std::end(_by_time), entry);
+		assert(iter != std::end(_by_time) && *iter == entry);
+		_by_time.erase(iter);
+		return;
+	}
+
+	archetype::archetype(const resources::object& o) : _object_type{ &o }
+	{
+		_columns.resize(std::size(o.variable_layout));
+		for (const auto& c : o.all_curves)
 		{
-			auto ptr = &data[i];
-			if (ptr->id == e)
-			{
-				if (emptys[i] == game_object_collection::empty_flag)
-					return nullptr;
-				else
-					return ptr;
-			}
+			assert(c.curve_ptr);
+			const auto slot = resources::object_functions::get_variable_slot(o, c.curve_ptr->id);
+			if (slot == resources::object::no_slot)
+				continue;
+
+			const auto info = archetype_column_base::curve_info_t{ c.curve_ptr->frame_style, c.curve_ptr->data_type };
+			state_api::detail::call_with_curve_info(info, [&]<template<typename> typename CurveType, typename T>() {
+				_columns[slot] = std::make_unique<archetype_column<state_field<CurveType<T>>>>(c.curve_ptr->id, info);
+				return;
+			});
 		}
-		return nullptr;
+
+		assert(std::ranges::none_of(_columns, [](const auto& c) noexcept { return c == nullptr; }));
+		return;
 	}
 
-	const game_obj* game_object_collection::find(const entity_id e) const noexcept
+	std::size_t archetype::insert(const entity_id e)
+	{
+		if (std::empty(_free_rows))
+		{
+			// add a new chunk to every column
+			// this is why we're not noexcept
+			const auto first_row = std::size(_entities);
+			for (auto& c : _columns)
+				c->add_chunk();
+			_occupied.emplace_back();
+			_entities.resize(first_row + archetype_chunk_size, bad_entity);
+			// reserve enough for every row, so that erase doesn't have to allocate
+			_free_rows.reserve(std::size(_entities));
+			// push in reverse, so that the lowest rows are used first
+			for (auto i = std::size(_entities); i > first_row; --i)
+				_free_rows.emplace_back(i - 1);
+		}
+
+		const auto row = _free_rows.back();
+		_free_rows.pop_back();
+		_entities[row] = e;
+		_occupied[row / archetype_chunk_size] |= std::uint64_t{ 1 } << (row % archetype_chunk_size);
+		return row;
+	}
+
+	void archetype::erase(const std::size_t row) noexcept
 	{
-		return game_obj_find_impl(e, _emptys, _data);
+		assert(row < std::size(_entities));
+		assert(_entities[row] != bad_entity);
+		for (auto& c : _columns)
+			c->reset(row);
+		_entities[row] = bad_entity;
+		_occupied[row / archetype_chunk_size] &= ~(std::uint64_t{ 1 } << (row % archetype_chunk_size));
+		_free_rows.emplace_back(row);
+		return;
 	}
 
-	game_obj* game_object_collection::find(const entity_id e) noexcept
+	archetype_column_base* archetype::find_column(const variable_id v) noexcept
 	{
-		return game_obj_find_impl(e, _emptys, _data);
+		const auto slot = resources::object_functions::get_variable_slot(*_object_type, v);
+		if (slot < std::size(_columns) && _columns[slot]->id == v)
+			return _columns[slot].get();
+
+		// the object types layout has changed since this archetype was made
+		const auto iter = std::ranges::find_if(_columns, [v](const auto& c) noexcept {
+			return c->id == v;
+			});
+		return iter == std::end(_columns) ? nullptr : iter->get();
+	}
+
+	archetype& archetype_collection::find_or_create(const resources::object& o)
+	{
+		const auto [iter, inserted] = _index.try_emplace(&o, std::size(_archetypes));
+		if (!inserted)
+			return _archetypes[iter->second];
+
+		try
+		{
+			return _archetypes.emplace_back(o);
+		}
+		catch (...)
+		{
+			_index.erase(iter);
+			throw;
+		}
+	}
+
+	archetype* archetype_collection::find(const resources::object* o) noexcept
+	{
+		const auto iter = _index.find(o);
+		return iter == std::end(_index) ? nullptr : &_archetypes[iter->second];
 	}
 }
 
 namespace hades::state_api
 {
+	namespace detail
+	{
+		struct extract_curve_visitor
+		{
+			const void* var;
+			std::vector<object_save_instance::saved_curve::saved_keyframe>& out;
+
+			template<template<typename> typename CurveType, typename T>
+			void operator()()
+			{
+				const auto& field = *static_cast<const state_field<CurveType<T>>*>(var);
+				const auto& keyframes = field.data.keyframes();
+				out.reserve(std::size(keyframes));
+				for (const auto& k : keyframes)
+					out.push_back({ k.time, k.value });
+				return;
+			}
+		};
+	}
+
+	object_save_instance extract_object(const game_obj& o, const game_state& s)
+	{
+		assert(o.object_type);
+		auto out = object_save_instance{ o.object_type, o.id };
+
+		const auto creation = s.object_creation_time.find(o.id);
+		if (creation != std::end(s.object_creation_time))
+			out.creation_time = creation->second;
+		const auto destruction = s.object_destruction_time.find(o.id);
+		if (destruction != std::end(s.object_destruction_time))
+			out.destruction_time = destruction->second;
+		out.name_id = get_name(object_ref{ o.id, const_cast<game_obj*>(&o) }, out.creation_time, s);
+
+		out.curves.reserve(size(o.object_variables));
+		for (const auto& entry : o.object_variables)
+		{
+			const auto curve = data::get<resources::curve>(entry.id, data::no_load);
+			assert(curve);
+			auto& saved = out.curves.emplace_back(object_save_instance::saved_curve{ curve, {} });
+			detail::call_with_curve_info(entry.info, detail::extract_curve_visitor{ entry.var, saved.keyframes });
+		}
+
+		return out;
+	}
+
 	time_point get_object_creation_time(const game_obj& o, const game_state& s)
 	{
 		return s.object_creation_time.at(o.id);
@@ -167,18 +167,35 @@ namespace hades
 		);
 	}	
 
-	static system_job_data* game_data_ptr = nullptr;
-	static unique_id game_current_level_id = {};
-	static game_interface* game_current_level_ptr = nullptr;
-	static system_behaviours<game_system>* game_current_level_system_ptr = nullptr;
+	void declare_system_access(unique_id id, std::vector<unique_id> reads,
+		std::vector<unique_id> writes, data::data_manager& d)
+	{
+		using namespace std::string_view_literals;
+		auto sys = d.find_or_create<resources::system>(id, {}, "game-system"sv);
+		if (!sys)
+			throw system_error{ "unable to find requested system" };
+
+		remove_duplicates(reads);
+		remove_duplicates(writes);
+		sys->read_curves = std::move(reads);
+		sys->write_curves = std::move(writes);
+		sys->access_declared = true;
+		return;
+	}
+
+	// systems may be ticked on any of the thread pools threads
+	// so each thread keeps track of the system it is currently running
+	thread_local static system_job_data* game_data_ptr = nullptr;
+	thread_local static unique_id game_current_level_id = {};
+	thread_local static game_interface* game_current_level_ptr = nullptr;
+	thread_local static system_behaviours<game_system>* game_current_level_system_ptr = nullptr;
 
 	void set_game_data(system_job_data *d) noexcept
 	{
-		assert(d);
 		game_data_ptr = d;
-		game_current_level_id = d->level_id;
-		game_current_level_ptr = d->level_data;
-		game_current_level_system_ptr = d->systems;
+		game_current_level_id = d ? d->level_id : unique_id{};
+		game_current_level_ptr = d ? d->level_data : nullptr;
+		game_current_level_system_ptr = d ? d->systems : nullptr;
 		return;
 	}
 
@@ -199,6 +216,11 @@ namespace hades
 			return game_data_ptr;
 		}
 
+		system_job_data* try_get_game_data_ptr() noexcept
+		{
+			return game_data_ptr;
+		}
+
 		unique_id get_game_level_id() noexcept
 		{
 			return game_current_level_id;
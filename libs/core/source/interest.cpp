@@ -0,0 +1,168 @@
+#include "hades/interest.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include "hades/core_curves.hpp"
+
+namespace hades
+{
+	// the grid is padded by a cell on the right and bottom, so that objects
+	//	clamped to the far edge of the world still land in a cell
+	static rect_float pad_world(const rect_float world, const float cell_size) noexcept
+	{
+		return { world.x, world.y, world.width + cell_size, world.height + cell_size };
+	}
+
+	// the grid can't have cells larger than the world
+	static float clamp_cell_size(const rect_float world, const float cell_size) noexcept
+	{
+		return std::clamp(cell_size, 1.f, std::max(std::min(world.width, world.height), 1.f));
+	}
+
+	interest_grid::interest_grid(const rect_float world_bounds, const float cell_size)
+		: _world{ normalise(world_bounds) }, _cell_size{ clamp_cell_size(_world, cell_size) },
+		_grid{ pad_world(_world, _cell_size), _cell_size }
+	{}
+
+	void interest_grid::place(const game_obj& o, const time_point t)
+	{
+		const auto iter = std::lower_bound(begin(_moving), end(_moving), o.id);
+		const auto listed = iter != end(_moving) && *iter == o.id;
+		if (_place(o, t))
+		{
+			if (!listed)
+				_moving.insert(iter, o.id);
+		}
+		else if (listed)
+			_moving.erase(iter);
+		return;
+	}
+
+	void interest_grid::remove(const entity_id id)
+	{
+		_grid.remove(id);
+		const auto iter = std::lower_bound(begin(_unpositioned), end(_unpositioned), id);
+		if (iter != end(_unpositioned) && *iter == id)
+			_unpositioned.erase(iter);
+		const auto moving = std::lower_bound(begin(_moving), end(_moving), id);
+		if (moving != end(_moving) && *moving == id)
+			_moving.erase(moving);
+		return;
+	}
+
+	void interest_grid::reset()
+	{
+		_grid = uniform_collision_grid<entity_id, rect_float>{ pad_world(_world, _cell_size), _cell_size };
+		_unpositioned.clear();
+		_moving.clear();
+		_next_id = next(bad_entity);
+		return;
+	}
+
+	void interest_grid::update(const time_point t, const game_state& s, const extra_state<game_system>& e)
+	{
+		if (!e.dirty_curves.enabled)
+		{
+			for (const auto& o : e.objects)
+				place(o, t);
+			_next_id = next(s.next_id);
+			return;
+		}
+
+		// objects moving towards later keyframes don't have their curves written again
+		//	so they're placed every update until they reach the last one
+		std::erase_if(_moving, [&](const entity_id id) {
+			const auto obj = e.objects.find(id);
+			return !obj || !_place(*obj, t);
+			});
+
+		// new objects, next_id is the last id that was given out
+		for (auto id = _next_id; !(s.next_id < id); id = next(id))
+		{
+			const auto obj = e.objects.find(id);
+			if (obj)
+				place(*obj, t);
+		}
+		_next_id = next(s.next_id);
+
+		// moved objects
+		const auto position = get_position_curve_id();
+		const auto size = get_size_curve_id();
+		auto last = bad_entity;
+		for (const auto& dirty : state_api::get_dirty_curves(e))
+		{
+			if (dirty.object == last || (dirty.variable != position && dirty.variable != size))
+				continue;
+
+			last = dirty.object;
+			const auto obj = e.objects.find(dirty.object);
+			if (obj)
+				place(*obj, t);
+		}
+		return;
+	}
+
+	bool interest_grid::_place(const game_obj& o, const time_point t)
+	{
+		const auto position = state_api::get_object_property_ptr<linear_curve, curve_types::vec2_float>(o, get_position_curve_id());
+		if (!position || position->empty())
+		{
+			_grid.remove(o.id);
+			const auto iter = std::lower_bound(begin(_unpositioned), end(_unpositioned), o.id);
+			if (iter == end(_unpositioned) || *iter != o.id)
+				_unpositioned.insert(iter, o.id);
+			return false;
+		}
+
+		if (!std::empty(_unpositioned))
+		{
+			const auto iter = std::lower_bound(begin(_unpositioned), end(_unpositioned), o.id);
+			if (iter != end(_unpositioned) && *iter == o.id)
+				_unpositioned.erase(iter);
+		}
+
+		const auto pos = position->get(t);
+		const auto size_ptr = state_api::get_object_property_ptr<const_curve, curve_types::vec2_float>(o, get_size_curve_id());
+		const auto size = size_ptr ? *size_ptr : curve_types::vec2_float{};
+		_grid.update(o.id, _clamp({ pos.x, pos.y, size.x, size.y }));
+		return t < position->keyframes().back().time;
+	}
+
+	std::vector<entity_id> interest_grid::find(const rect_float r) const
+	{
+		auto out = _grid.find(_clamp(r));
+		if (std::empty(_unpositioned))
+			return out;
+
+		// objects are either in the grid or unpositioned, so there are no duplicates to remove
+		const auto middle = integer_cast<std::ptrdiff_t>(std::size(out));
+		out.insert(end(out), begin(_unpositioned), end(_unpositioned));
+		std::inplace_merge(begin(out), std::next(begin(out), middle), end(out));
+		return out;
+	}
+
+	rect_float interest_grid::_clamp(rect_float r) const noexcept
+	{
+		r = normalise(r);
+		const auto right = _world.x + _world.width;
+		const auto bottom = _world.y + _world.height;
+		const auto r_right = std::clamp(r.x + r.width, _world.x, right);
+		const auto r_bottom = std::clamp(r.y + r.height, _world.y, bottom);
+		r.x = std::clamp(r.x, _world.x, right);
+		r.y = std::clamp(r.y, _world.y, bottom);
+		r.width = r_right - r.x;
+		r.height = r_bottom - r.y;
+		return r;
+	}
+
+	interest_changes update_interest(interest_set& s, std::vector<entity_id> relevant)
+	{
+		auto out = interest_changes{};
+		std::set_difference(begin(relevant), end(relevant), begin(s.objects), end(s.objects), std::back_inserter(out.entered));
+		std::set_intersection(begin(relevant), end(relevant), begin(s.objects), end(s.objects), std::back_inserter(out.stayed));
+		std::set_difference(begin(s.objects), end(s.objects), begin(relevant), end(relevant), std::back_inserter(out.left));
+		s.objects = std::move(relevant);
+		return out;
+	}
+}
@@ -1,11 +1,13 @@
 #include "hades/level_interface.hpp"
 
+#include "hades/console_variables.hpp"
 #include "hades/core_curves.hpp"
 #include "hades/data.hpp"
 #include "hades/level.hpp"
 #include "hades/level_scripts.hpp"
 #include "hades/game_system.hpp"
 #include "hades/objects.hpp"
+#include "hades/properties.hpp"
 #include "hades/save_load_api.hpp"
 
 namespace hades 
@@ -17,6 +19,15 @@ namespace hades
 		return obj;
 	}
 
+	std::vector<object_ref> game_implementation::create_objects(const std::span<const object_instance> o, const time_point t)
+	{
+		auto objs = state_api::make_objects(o, t, _state, _extras);
+		_new_objects.reserve(size(_new_objects) + size(objs));
+		for (const auto& obj : objs)
+			_new_objects.emplace_back(*obj.ptr);
+		return objs;
+	}
+
 	object_ref game_implementation::clone_object(object_ref o, time_point t)
 	{
 		const auto& current_obj = state_api::get_object(o, _extras);
@@ -59,6 +70,28 @@ namespace hades
 		return std::exchange(_removed_objects, {});
 	}
 
+	void game_implementation::restore_snapshot(const state_snapshot<game_system>& s)
+	{
+		const auto changes = state_api::restore_snapshot(s, _state, _extras);
+		for (const auto id : changes.erased)
+		{
+			if (auto iter = std::ranges::find(_new_objects, id, &game_obj::id);
+				iter != end(_new_objects))
+			{
+				_new_objects.erase(iter);
+			}
+			else
+				_removed_objects.emplace_back(id);
+		}
+
+		for (const auto& o : changes.created)
+			_new_objects.emplace_back(*o.ptr);
+
+		// these may have been erased by the restore
+		_destroy_objects.clear();
+		return;
+	}
+
 	void game_implementation::name_object(std::string_view s, object_ref o, time_point t)
 	{
 		state_api::name_object(string{ s }, o, t, _state);
@@ -84,6 +117,10 @@ namespace hades
 		_terrain = to_terrain_map(sv.source.terrain, *settings);
 
 		_state.next_id = sv.objects.next_id;
+		_state.archetype_storage = console::get_bool(cvars::server_archetype_storage,
+			cvars::default_value::server_archetype_storage)->load();
+		// make room for the registered level locals, so that handles don't resize during ticks
+		_extras.level_local_slots.resize(detail::level_local_count());
 
 		const auto load_script_id = sv.source.on_load;
 		
@@ -128,7 +165,7 @@ namespace hades
 		{
 			if (s->system->on_destroy)
 			{
-				auto& sys_data = sys_behaviours.get_system_data(s->system->id);
+				auto& sys_data = sys_behaviours.get_system_data(*s);
 				auto game_data = data;
 				game_data.entity = activated_object_view{ sys_behaviours.get_entities(*s), time_point::max() };
 				game_data.system = s->system->id;
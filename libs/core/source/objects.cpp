@@ -1,7 +1,10 @@
 #include "hades/objects.hpp"
 
 #include <algorithm>
+#include <mutex>
+#include <shared_mutex>
 #include <stack>
+#include <unordered_map>
 
 #include "hades/animation.hpp"
 #include "hades/core_curves.hpp"
@@ -228,6 +231,113 @@ namespace hades
 
 namespace hades::resources
 {
+	static void make_variable_layout(object& o)
+	{
+		o.variable_layout.clear();
+		o.variable_key_slots.clear();
+
+		auto max_key = std::size_t{};
+		for (const auto& c : o.all_curves)
+		{
+			assert(c.curve_ptr);
+			// const curves are read from the object type, rather than stored on objects
+			if (c.curve_ptr->frame_style == keyframe_style::const_t)
+				continue;
+
+			o.variable_layout.emplace_back(c.curve_ptr->id);
+			max_key = std::max(max_key, c.curve_ptr->key);
+		}
+
+		std::ranges::sort(o.variable_layout);
+		o.variable_layout.shrink_to_fit();
+		if (std::empty(o.variable_layout))
+			return;
+
+		o.variable_key_slots.resize(max_key + 1, object::no_slot);
+		for (const auto& c : o.all_curves)
+		{
+			if (c.curve_ptr->frame_style == keyframe_style::const_t)
+				continue;
+			o.variable_key_slots[c.curve_ptr->key] = object_functions::get_variable_slot(o, c.curve_ptr->id);
+		}
+
+		return;
+	}
+}
+
+namespace hades::resources
+{
+	struct tag_bit_registry
+	{
+		std::shared_mutex mut;
+		std::unordered_map<unique_id, std::size_t> bits;
+	};
+
+	static tag_bit_registry& get_tag_bit_registry() noexcept
+	{
+		static auto registry = tag_bit_registry{};
+		return registry;
+	}
+
+	static std::size_t make_tag_bit(const unique_id tag)
+	{
+		auto& reg = get_tag_bit_registry();
+		const auto lock = std::scoped_lock{ reg.mut };
+		return reg.bits.try_emplace(tag, size(reg.bits)).first->second;
+	}
+
+	static constexpr auto tag_word_bits = std::size_t{ std::numeric_limits<std::uint64_t>::digits };
+
+	static void make_prototype(object& o)
+	{
+		auto& p = o.prototype;
+		p.curve_index.clear();
+		p.object_curves.clear();
+		p.tag_bits.clear();
+
+		const auto curve_count = size(o.all_curves);
+		p.curve_index.reserve(curve_count);
+		for (auto i = std::size_t{}; i < curve_count; ++i)
+		{
+			const auto& c = o.all_curves[i];
+			assert(c.curve_ptr);
+			const auto index = integer_cast<std::uint32_t>(i);
+			p.curve_index.emplace_back(c.curve_ptr->id, index);
+			// const curves are read from the object type, rather than stored on objects
+			if (c.curve_ptr->frame_style != keyframe_style::const_t)
+				p.object_curves.emplace_back(index);
+		}
+
+		// stable, so that lookups find the same entry that a search of all_curves would
+		std::ranges::stable_sort(p.curve_index, {}, &std::pair<unique_id, std::uint32_t>::first);
+		std::ranges::sort(p.object_curves, {}, [&o](const std::uint32_t i) noexcept {
+			return o.all_curves[i].curve_ptr->id;
+			});
+
+		for (const auto t : o.all_tags)
+		{
+			const auto bit = make_tag_bit(t);
+			const auto word = bit / tag_word_bits;
+			if (word >= size(p.tag_bits))
+				p.tag_bits.resize(word + 1);
+			p.tag_bits[word] |= std::uint64_t{ 1 } << (bit % tag_word_bits);
+		}
+
+		p.curve_index.shrink_to_fit();
+		p.object_curves.shrink_to_fit();
+		return;
+	}
+
+	// returns nullptr if the object doesn't have the curve
+	static const object::curve_obj* find_curve(const object& o, const unique_id id) noexcept
+	{
+		const auto& index = o.prototype.curve_index;
+		const auto iter = std::ranges::lower_bound(index, id, {}, &std::pair<unique_id, std::uint32_t>::first);
+		if (iter == end(index) || iter->first != id)
+			return nullptr;
+		return &o.all_curves[iter->second];
+	}
+
 	static void load_objects(object &o, data::data_manager &d)
 	{
 		//const auto& name = d.get_as_string(o.id);
@@ -254,6 +364,7 @@ namespace hades::resources
 		o.all_curves = get_all_curves(d, o);
 		o.all_curves = unique_curves(std::move(o.all_curves));
 		o.all_curves.shrink_to_fit();
+		make_variable_layout(o);
 	
 		o.all_systems = get_all_systems(o);
 		remove_duplicates(o.all_systems);
@@ -267,6 +378,8 @@ namespace hades::resources
 		remove_duplicates(o.all_tags);
 		o.all_tags.shrink_to_fit();
 
+		make_prototype(o);
+
 		//all of the other resources used by objects are parse-only and don't require loading
 		o.loaded = true;
 		return;
@@ -422,6 +535,28 @@ namespace hades::resources::object_functions
 		return o.all_tags;
 	}
 
+	std::size_t get_tag_bit(const unique_id tag)
+	{
+		auto& reg = get_tag_bit_registry();
+		const auto lock = std::shared_lock{ reg.mut };
+		const auto iter = reg.bits.find(tag);
+		return iter == end(reg.bits) ? no_tag_bit : iter->second;
+	}
+
+	bool has_tag(const object& o, const unique_id tag)
+	{
+		return has_tag_bit(o, get_tag_bit(tag));
+	}
+
+	bool has_tag_bit(const object& o, const std::size_t bit) noexcept
+	{
+		assert(o.loaded);
+		const auto word = bit / tag_word_bits;
+		if (bit == no_tag_bit || word >= size(o.prototype.tag_bits))
+			return false;
+		return (o.prototype.tag_bits[word] >> (bit % tag_word_bits)) & std::uint64_t{ 1 };
+	}
+
 	inherited_tag_list get_inherited_tags(const object& o)
 	{
 		auto tags = inherited_tag_list{};
@@ -524,7 +659,11 @@ namespace hades::resources::object_functions
 				});
 
 			if (iter == end(o.all_curves))
+			{
 				o.all_curves.emplace_back(std::move(*v), c, unique_zero);
+				make_variable_layout(o);
+				make_prototype(o);
+			}
 			else
 				iter->value = std::move(*v);
 		}
@@ -532,18 +671,23 @@ namespace hades::resources::object_functions
 		return;
 	}
 
+	std::uint32_t get_variable_slot(const object& o, const unique_id id) noexcept
+	{
+		const auto iter = std::ranges::lower_bound(o.variable_layout, id);
+		if (iter == end(o.variable_layout) || *iter != id)
+			return object::no_slot;
+		return integer_cast<std::uint32_t>(std::distance(begin(o.variable_layout), iter));
+	}
+
 	bool has_curve(const object& o, const curve& c) noexcept
 	{
-		return std::any_of(begin(o.all_curves), end(o.all_curves), [&other = c](auto&& c){
-            return c.curve_ptr == &other;
-		});
+		const auto curve = find_curve(o, c.id);
+		return curve && curve->curve_ptr == &c;
 	}
 
 	bool has_curve(const object& o, const unique_id id) noexcept
 	{
-		return std::any_of(begin(o.all_curves), end(o.all_curves), [id](auto&& c) {
-            return c.curve_ptr->id == id;
-			});
+		return find_curve(o, id) != nullptr;
 	}
 
 	void remove_curve(object& o, unique_id c)
@@ -591,16 +735,15 @@ namespace hades::resources::object_functions
 
 		found_curves = unique_curves(std::move(found_curves));
 		o.all_curves.emplace_back(found_curves[0]);
+		make_variable_layout(o);
+		make_prototype(o);
 		return;
 	}
 
 	curve_default_value get_curve(const object& o, const curve& c)
 	{
-		const auto iter = std::find_if(begin(o.all_curves), end(o.all_curves), [&other = c](auto&& c){
-            return &other == c.curve_ptr;
-		});
-
-		if(iter == end(o.all_curves))
+		const auto iter = find_curve(o, c.id);
+		if(!iter || iter->curve_ptr != &c)
 			throw curve_not_found{ "Requested curve not found on object type: "s 
 				+ hades::data::get_as_string(o.id) + ", curve was: "s 
 				+ hades::data::get_as_string(c.id) };
@@ -618,11 +761,8 @@ namespace hades::resources::object_functions
 
 	const object::curve_obj& get_curve(const object& o, const unique_id id)
 	{
-		const auto iter = std::find_if(begin(o.all_curves), end(o.all_curves), [id](auto&& c) {
-            return id == c.curve_ptr->id;
-			});
-
-		if (iter == end(o.all_curves))
+		const auto iter = find_curve(o, id);
+		if (!iter)
 			throw curve_not_found{ "Requested curve not found on object type: "s
 				+ data::get_as_string(o.id) + ", curve was: "s
 				+ data::get_as_string(id) };
@@ -10,6 +10,7 @@ namespace hades
 	render_instance::render_instance(common_interface* i) : _interface{i}
 	{
 		assert(i);
+		_extra.level_local_slots.resize(detail::level_local_count());
 		return;
 	}
 
@@ -35,10 +36,7 @@ namespace hades
 			// the render game_obj holding ptrs to the erased server data
 			auto obj = state_api::get_object_ptr(ref, _extra);
 			if (obj)
-			{
-				obj->id = bad_entity;
 				_extra.objects.erase(obj);
-			}
 		}
 
         // TODO: make rjd constructor for all usages
@@ -0,0 +1,416 @@
+#include "hades/replay.hpp"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <type_traits>
+
+#include "hades/data.hpp"
+#include "hades/detail/varint.hpp"
+
+namespace hades
+{
+	namespace
+	{
+		constexpr auto replay_magic = std::array{ 'h', 'd', 'r', 'p' };
+		// increase this whenever the layout below is changed
+		constexpr auto replay_format_version = std::uint8_t{ 2 };
+
+		enum class record_tag : std::uint8_t
+		{
+			name,	// string; gives the next name index to a unique_id
+			level,	// level name index
+			input,	// level name index, player name index, time since last tick,
+					//	action count, [action name index, x, y, u, v, active]
+			tick,	// time since last tick, hash
+			hibernation	// level name index, 1 if the level was hibernated or 0 if it was woken
+		};
+
+		using byte_buffer = std::vector<std::byte>;
+
+		void write_byte(byte_buffer& b, const std::uint8_t v)
+		{
+			b.push_back(std::byte{ v });
+			return;
+		}
+
+		// same encoding as exported curves
+		using detail::write_varint;
+		using detail::write_signed;
+
+		void write_string(byte_buffer& b, const std::string_view s)
+		{
+			write_varint(b, std::size(s));
+			const auto bytes = std::as_bytes(std::span{ s });
+			b.insert(end(b), begin(bytes), end(bytes));
+			return;
+		}
+
+		void write_tag(byte_buffer& b, const record_tag t)
+		{
+			write_byte(b, enum_type(t));
+			return;
+		}
+
+		[[noreturn]] void throw_truncated()
+		{
+			throw replay_error{ "replay file is truncated" };
+		}
+
+		std::uint8_t read_byte(std::istream& s)
+		{
+			const auto c = s.get();
+			if (c == std::istream::traits_type::eof())
+				throw_truncated();
+			return static_cast<std::uint8_t>(c);
+		}
+
+		std::uint64_t read_varint(std::istream& s)
+		{
+			const auto out = detail::read_varint([&s] { return read_byte(s); });
+			if (!out)
+				throw replay_error{ "replay file contains an invalid integer" };
+			return *out;
+		}
+
+		std::int64_t read_signed(std::istream& s)
+		{
+			return detail::zigzag_decode(read_varint(s));
+		}
+
+		int32 read_int32(std::istream& s)
+		{
+			const auto v = read_signed(s);
+			if (v < std::numeric_limits<int32>::min() || v > std::numeric_limits<int32>::max())
+				throw replay_error{ "replay file contains an integer that is out of range" };
+			return static_cast<int32>(v);
+		}
+
+		string read_string(std::istream& s)
+		{
+			const auto size = integer_cast<std::size_t>(read_varint(s));
+			auto out = string(size, '\0');
+			if (!s.read(out.data(), integer_cast<std::streamsize>(size)))
+				throw_truncated();
+			return out;
+		}
+
+		unique_id read_name(std::istream& s, const std::vector<unique_id>& names)
+		{
+			const auto index = read_varint(s);
+			if (index >= std::size(names))
+				throw replay_error{ "replay file refers to a name that hasn't been defined" };
+			return names[integer_cast<std::size_t>(index)];
+		}
+	}
+
+	replay_writer::replay_writer(const std::filesystem::path& path, const std::string_view mission, const std::string_view player_slot)
+		: _file{ path }
+	{
+		if (!_file.is_open())
+			throw replay_error{ "unable to open replay file for writing: " + path.generic_string() };
+
+		for (const auto c : replay_magic)
+			write_byte(_buffer, static_cast<std::uint8_t>(c));
+		write_byte(_buffer, replay_format_version);
+		write_string(_buffer, mission);
+		write_string(_buffer, player_slot);
+		_write_buffer();
+		return;
+	}
+
+	void replay_writer::record_level(const unique_id level)
+	{
+		const auto index = _name_index(level);
+		write_tag(_buffer, record_tag::level);
+		write_varint(_buffer, index);
+		_write_buffer();
+		return;
+	}
+
+	void replay_writer::record_input(const unique_id level, const unique_id player, const time_point t, const std::vector<action>& actions)
+	{
+		// name records have to come before the input that uses them
+		const auto level_index = _name_index(level);
+		const auto player_index = _name_index(player);
+		auto action_indices = std::vector<std::size_t>{};
+		action_indices.reserve(std::size(actions));
+		for (const auto& a : actions)
+			action_indices.emplace_back(_name_index(a.id));
+
+		write_tag(_buffer, record_tag::input);
+		write_varint(_buffer, level_index);
+		write_varint(_buffer, player_index);
+		write_signed(_buffer, (t - _last_tick).count());
+		write_varint(_buffer, std::size(actions));
+		for (auto i = std::size_t{}; i < std::size(actions); ++i)
+		{
+			const auto& a = actions[i];
+			write_varint(_buffer, action_indices[i]);
+			write_signed(_buffer, a.x_axis);
+			write_signed(_buffer, a.y_axis);
+			write_signed(_buffer, a.u_axis);
+			write_signed(_buffer, a.v_axis);
+			write_byte(_buffer, a.active ? 1 : 0);
+		}
+
+		_write_buffer();
+		return;
+	}
+
+	void replay_writer::record_tick(const time_point t, const std::uint64_t hash)
+	{
+		write_tag(_buffer, record_tag::tick);
+		write_signed(_buffer, (t - _last_tick).count());
+		for (auto i = 0; i < 8; ++i)
+			write_byte(_buffer, static_cast<std::uint8_t>(hash >> (i * 8)));
+		_last_tick = t;
+		_write_buffer();
+		return;
+	}
+
+	void replay_writer::record_hibernation(const unique_id level, const bool hibernating)
+	{
+		const auto index = _name_index(level);
+		write_tag(_buffer, record_tag::hibernation);
+		write_varint(_buffer, index);
+		write_byte(_buffer, hibernating ? 1 : 0);
+		_write_buffer();
+		return;
+	}
+
+	std::size_t replay_writer::_name_index(const unique_id id)
+	{
+		const auto [iter, inserted] = _names.try_emplace(id, std::size(_names));
+		if (inserted)
+		{
+			write_tag(_buffer, record_tag::name);
+			write_string(_buffer, data::get_as_string(id));
+		}
+		return iter->second;
+	}
+
+	void replay_writer::_write_buffer()
+	{
+		_file.write(reinterpret_cast<const char*>(_buffer.data()), integer_cast<std::streamsize>(std::size(_buffer)));
+		_buffer.clear();
+		if (!_file)
+			throw replay_error{ "failed to write to replay file" };
+		return;
+	}
+
+	replay_reader::replay_reader(const std::filesystem::path& path)
+		: _file{ path }
+	{
+		if (!_file.is_open())
+			throw replay_error{ "unable to open replay file: " + path.generic_string() };
+
+		for (const auto c : replay_magic)
+		{
+			if (read_byte(_file) != static_cast<std::uint8_t>(c))
+				throw replay_error{ "not a replay file: " + path.generic_string() };
+		}
+
+		if (read_byte(_file) != replay_format_version)
+			throw replay_error{ "replay file was written by an incompatible version: " + path.generic_string() };
+
+		_mission = read_string(_file);
+		_player_slot = read_string(_file);
+		return;
+	}
+
+	bool replay_reader::read(replay_record& out)
+	{
+		while (true)
+		{
+			const auto c = _file.get();
+			if (c == std::istream::traits_type::eof())
+				return false;
+
+			switch (record_tag{ static_cast<std::uint8_t>(c) })
+			{
+			case record_tag::name:
+				_names.emplace_back(data::get_uid(read_string(_file)));
+				break;
+			case record_tag::level:
+				out = replay_level{ read_name(_file, _names) };
+				return true;
+			case record_tag::input:
+			{
+				auto input = replay_input{};
+				input.level = read_name(_file, _names);
+				input.player = read_name(_file, _names);
+				input.time = _last_tick + time_duration{ read_signed(_file) };
+				const auto count = integer_cast<std::size_t>(read_varint(_file));
+				for (auto i = std::size_t{}; i < count; ++i)
+				{
+					auto& a = input.actions.emplace_back();
+					a.id = read_name(_file, _names);
+					a.x_axis = read_int32(_file);
+					a.y_axis = read_int32(_file);
+					a.u_axis = read_int32(_file);
+					a.v_axis = read_int32(_file);
+					a.active = read_byte(_file) != 0;
+				}
+				out = std::move(input);
+			}return true;
+			case record_tag::tick:
+			{
+				auto tick = replay_tick{};
+				tick.time = _last_tick + time_duration{ read_signed(_file) };
+				for (auto i = 0; i < 8; ++i)
+					tick.hash |= std::uint64_t{ read_byte(_file) } << (i * 8);
+				_last_tick = tick.time;
+				out = tick;
+			}return true;
+			case record_tag::hibernation:
+			{
+				auto hibernation = replay_hibernation{};
+				hibernation.level = read_name(_file, _names);
+				hibernation.hibernating = read_byte(_file) != 0;
+				out = hibernation;
+			}return true;
+			default:
+				throw replay_error{ "replay file contains an unknown record" };
+			}
+		}
+	}
+}
+
+namespace hades::state_api
+{
+	namespace
+	{
+		// FNV-1a
+		struct state_hasher
+		{
+			std::uint64_t value = 14695981039346656037u;
+
+			void bytes(const void* data, const std::size_t size) noexcept
+			{
+				const auto b = static_cast<const std::uint8_t*>(data);
+				for (auto i = std::size_t{}; i < size; ++i)
+				{
+					value ^= b[i];
+					value *= 1099511628211u;
+				}
+				return;
+			}
+
+			template<typename T>
+			void operator()(const T& v)
+			{
+				if constexpr (std::is_same_v<T, types::string>)
+				{
+					(*this)(std::size(v));
+					bytes(v.data(), std::size(v));
+				}
+				else if constexpr (std::is_same_v<T, object_ref>)
+					(*this)(to_value(v.id));
+				else if constexpr (std::is_same_v<T, unique_id>)
+					(*this)(data::get_as_string(v));
+				else if constexpr (std::is_same_v<T, time_point>)
+					(*this)(v.time_since_epoch().count());
+				else if constexpr (std::is_same_v<T, time_duration>)
+					(*this)(v.count());
+				else if constexpr (curve_types::is_collection_type_v<T>)
+				{
+					(*this)(std::size(v));
+					for (const auto& elm : v)
+						(*this)(elm);
+				}
+				else
+				{
+					static_assert(std::is_trivially_copyable_v<T>);
+					bytes(&v, sizeof(T));
+				}
+				return;
+			}
+		};
+
+		// hashes the keyframes after since, and the last keyframe
+		//	so values written ahead of time are checked when they're written, rather than when they're reached
+		template<typename Keyframes, typename HashValue>
+		void hash_keyframes(state_hasher& hash, const time_point since, const Keyframes& keyframes, HashValue&& hash_value)
+		{
+			if (std::empty(keyframes))
+				return;
+
+			const auto last = std::end(keyframes);
+			auto iter = std::upper_bound(std::begin(keyframes), last, since, [](const time_point t, const auto& k) noexcept {
+				return t < k.time;
+				});
+
+			if (iter == last)
+				iter = std::prev(last);
+
+			for (; iter != last; ++iter)
+			{
+				hash(iter->time);
+				std::invoke(hash_value, iter->value);
+			}
+			return;
+		}
+
+		struct hash_curve_visitor
+		{
+			const game_obj::var_entry& entry;
+			time_point since;
+			state_hasher& hash;
+
+			template<template<typename> typename CurveType, typename T>
+			void operator()()
+			{
+				const auto& keyframes = static_cast<const state_field<CurveType<T>>*>(entry.var)->data.keyframes();
+				hash(entry.id);
+				hash_keyframes(hash, since, keyframes, [this](const T& v) {
+					hash(v);
+					return;
+					});
+				return;
+			}
+		};
+	}
+
+	std::uint64_t hash_state(const time_point since, const game_state& s, const extra_state<game_system>& e)
+	{
+		// objects and names are stored in unordered containers
+		//	so their hashes are summed, which doesn't depend on the order they're visited in
+		auto out = std::uint64_t{};
+		for (const auto& o : e.objects)
+		{
+			auto hash = state_hasher{};
+			hash(to_value(o.id));
+			for (const auto& entry : o.object_variables)
+				detail::call_with_curve_info(entry.info, hash_curve_visitor{ entry, since, hash });
+			out += hash.value;
+		}
+
+		for (const auto& [id, t] : s.object_destruction_time)
+		{
+			auto hash = state_hasher{};
+			hash(to_value(id));
+			hash(t);
+			out += hash.value;
+		}
+
+		for (const auto& [name, curve] : s.names)
+		{
+			auto hash = state_hasher{};
+			hash(name);
+			hash_keyframes(hash, since, curve.keyframes(), [&hash](const object_ref& o) {
+				hash(to_value(o.id));
+				return;
+				});
+			out += hash.value;
+		}
+
+		auto count = state_hasher{};
+		count(std::size(e.objects));
+		return out + count.value;
+	}
+}
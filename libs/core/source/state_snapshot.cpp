@@ -0,0 +1,171 @@
+#include "hades/state_snapshot.hpp"
+
+namespace hades::state_api::detail
+{
+	namespace
+	{
+		struct curve_version_visitor
+		{
+			const void* var;
+			std::uint64_t& version;
+
+			template<template<typename> typename CurveType, typename T>
+			void operator()()
+			{
+				version = static_cast<const state_field<CurveType<T>>*>(var)->data.version();
+				return;
+			}
+		};
+
+		struct copy_curve_visitor
+		{
+			const void* var;
+			std::shared_ptr<const void>& out;
+
+			template<template<typename> typename CurveType, typename T>
+			void operator()()
+			{
+				out = std::make_shared<const CurveType<T>>(static_cast<const state_field<CurveType<T>>*>(var)->data);
+				return;
+			}
+		};
+
+		struct restore_curve_visitor
+		{
+			void* var;
+			const void* curve;
+
+			template<template<typename> typename CurveType, typename T>
+			void operator()()
+			{
+				// the curve version is copied too, so the next snapshot can share this curve again
+				static_cast<state_field<CurveType<T>>*>(var)->data = *static_cast<const CurveType<T>*>(curve);
+				return;
+			}
+		};
+
+		struct insert_curve_visitor
+		{
+			game_obj& obj;
+			variable_id id;
+			game_state& s;
+			const void* curve;
+
+			template<template<typename> typename CurveType, typename T>
+			void operator()()
+			{
+				insert_object_property<CurveType, T>(obj, id, s, *static_cast<const CurveType<T>*>(curve));
+				return;
+			}
+		};
+
+		std::uint64_t get_curve_version(const game_obj::var_entry& entry)
+		{
+			auto version = std::uint64_t{};
+			call_with_curve_info(entry.info, curve_version_visitor{ entry.var, version });
+			return version;
+		}
+
+		bool same_curves(const game_obj& o, const hades::detail::snapshot_object& saved) noexcept
+		{
+			return o.object_type == saved.object_type &&
+				std::ranges::equal(o.object_variables, saved.curves, {},
+					&game_obj::var_entry::id, &hades::detail::snapshot_curve::id);
+		}
+
+		void restore_object_times(const hades::detail::snapshot_object& o, game_state& s)
+		{
+			s.object_creation_time.insert_or_assign(o.id, o.creation_time);
+			if (o.destruction_time)
+				s.object_destruction_time.insert_or_assign(o.id, *o.destruction_time);
+			else
+				s.object_destruction_time.erase(o.id);
+			return;
+		}
+	}
+
+	std::shared_ptr<const hades::detail::snapshot_object> take_object_snapshot(const game_obj& o,
+		const game_state& s, const std::shared_ptr<const hades::detail::snapshot_object>& previous)
+	{
+		const auto creation = s.object_creation_time.find(o.id);
+		const auto creation_time = creation == std::end(s.object_creation_time) ? time_point{} : creation->second;
+		const auto destruction = s.object_destruction_time.find(o.id);
+		const auto destruction_time = destruction == std::end(s.object_destruction_time) ?
+			std::optional<time_point>{} : destruction->second;
+
+		// the previous curves can only be shared if the object still has the same curves
+		const auto same_layout = previous && same_curves(o, *previous);
+		const auto& vars = o.object_variables;
+		const auto var_count = size(vars);
+
+		if (same_layout && previous->creation_time == creation_time &&
+			previous->destruction_time == destruction_time)
+		{
+			auto i = std::size_t{};
+			while (i < var_count && get_curve_version(vars[i]) == previous->curves[i].version)
+				++i;
+
+			if (i == var_count)
+				return previous;
+		}
+
+		auto out = hades::detail::snapshot_object{ o.id, o.object_type, creation_time, destruction_time };
+		out.curves.reserve(var_count);
+		for (auto i = std::size_t{}; i < var_count; ++i)
+		{
+			auto& c = out.curves.emplace_back(hades::detail::snapshot_curve{ vars[i].id, vars[i].info,
+				get_curve_version(vars[i]) });
+
+			if (same_layout && previous->curves[i].version == c.version)
+				c.curve = previous->curves[i].curve;
+			else
+				call_with_curve_info(vars[i].info, copy_curve_visitor{ vars[i].var, c.curve });
+		}
+
+		return std::make_shared<const hades::detail::snapshot_object>(std::move(out));
+	}
+
+	bool restore_object_state(game_obj& o, const hades::detail::snapshot_object& saved, game_state& s)
+	{
+		if (!same_curves(o, saved))
+			return false;
+
+		const auto var_count = size(o.object_variables);
+		for (auto i = std::size_t{}; i < var_count; ++i)
+		{
+			const auto& entry = o.object_variables[i];
+			const auto& c = saved.curves[i];
+			if (get_curve_version(entry) != c.version)
+				call_with_curve_info(entry.info, restore_curve_visitor{ entry.var, c.curve.get() });
+		}
+
+		restore_object_times(saved, s);
+		return true;
+	}
+
+	void insert_object_state(game_obj& o, const hades::detail::snapshot_object& saved, game_state& s)
+	{
+		assert(empty(o.object_variables));
+		// the saved curves are already in the objects variable layout
+		o.object_variables.reserve(size(saved.curves));
+		for (const auto& c : saved.curves)
+			call_with_curve_info(c.info, insert_curve_visitor{ o, c.id, s, c.curve.get() });
+
+		restore_object_times(saved, s);
+		return;
+	}
+
+	std::shared_ptr<const object_name_map> take_names_snapshot(const object_name_map& names,
+		const std::shared_ptr<const object_name_map>& previous)
+	{
+		const auto unchanged = previous && size(*previous) == size(names) &&
+			std::ranges::all_of(names, [&prev = *previous](const auto& name) {
+				const auto iter = prev.find(name.first);
+				return iter != end(prev) && iter->second.version() == name.second.version();
+			});
+
+		if (unchanged)
+			return previous;
+		return std::make_shared<const object_name_map>(names);
+	}
+}
@@ -0,0 +1,76 @@
+#ifndef HADES_UTIL_ALLOCATION_COUNTER_HPP
+#define HADES_UTIL_ALLOCATION_COUNTER_HPP
+
+#include <atomic>
+#include <cstddef>
+
+// counts heap allocations made by a section of code
+//	allocations are only counted when built with the HADES_COUNT_ALLOCATIONS cmake option,
+//	otherwise counters stay at zero and the global allocator is left alone.
+//	with the option hades-util replaces the global operator new and delete with versions that
+//	call malloc and free, and count each allocation made while a scope is active.
+//	outside of a scope the only cost is checking a thread_local pointer.
+//	over-aligned allocations use the standard library versions and aren't counted
+
+namespace hades
+{
+	// the number of allocations made by scopes using this counter
+	//	scopes on different threads can share a counter
+	class allocation_counter
+	{
+	public:
+		allocation_counter() noexcept = default;
+		// only the count is moved, don't move a counter that a scope is still using
+		allocation_counter(allocation_counter&& other) noexcept
+			: _count{ other.count() }
+		{}
+
+		allocation_counter& operator=(allocation_counter&& other) noexcept
+		{
+			_count.store(other.count(), std::memory_order_relaxed);
+			return *this;
+		}
+
+		std::size_t count() const noexcept
+		{
+			return _count.load(std::memory_order_relaxed);
+		}
+
+		void reset() noexcept
+		{
+			_count.store({}, std::memory_order_relaxed);
+			return;
+		}
+
+		void add() noexcept
+		{
+			_count.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+	private:
+		std::atomic_size_t _count = {};
+	};
+
+	// counts the allocations made on this thread while the scope exists
+	//	scopes can be nested, only the innermost one counts an allocation
+	//	pass nullptr to stop counting until the scope ends
+	//	the thread pool uses this so that jobs it runs while a thread is waiting aren't counted
+	class allocation_counter_scope
+	{
+	public:
+		explicit allocation_counter_scope(allocation_counter*) noexcept;
+		allocation_counter_scope(const allocation_counter_scope&) = delete;
+		allocation_counter_scope& operator=(const allocation_counter_scope&) = delete;
+		~allocation_counter_scope() noexcept;
+
+	private:
+		allocation_counter* _previous;
+	};
+
+	// the counter used by the innermost scope on this thread, or nullptr
+	//	jobs queued from inside a scope can use this to count themselves with the same counter
+	allocation_counter* current_allocation_counter() noexcept;
+}
+
+#endif //!HADES_UTIL_ALLOCATION_COUNTER_HPP
@@ -1,15 +1,17 @@
 #ifndef HADES_UTIL_ASYNC_HPP
 #define HADES_UTIL_ASYNC_HPP
 
+#include <algorithm>
 #include <cassert>
 #include <condition_variable>
-#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <thread>
+#include <vector>
 
+#include "hades/allocation_counter.hpp"
 //#include "hades/random.hpp"
 
 // NOTE: current implementation suffers with async functions starting their own async funcs
@@ -48,6 +50,67 @@ namespace hades
 			thread_pool* pool = nullptr;
 			std::atomic_bool complete = false;
 		};
+
+		// fifo of work for one of the pools threads
+		//	the buffer is kept when work is removed, so a warmed up queue doesn't allocate
+		class work_queue
+		{
+		public:
+			using value_type = std::function<void()>;
+
+			bool empty() const noexcept
+			{
+				return _size == std::size_t{};
+			}
+
+			std::size_t size() const noexcept
+			{
+				return _size;
+			}
+
+			void push_back(value_type f)
+			{
+				if (_size == std::size(_buffer))
+					_grow();
+				_buffer[(_head + _size) % std::size(_buffer)] = std::move(f);
+				++_size;
+				return;
+			}
+
+			value_type pop_front() noexcept
+			{
+				assert(!empty());
+				auto out = std::move(_buffer[_head]);
+				_buffer[_head] = nullptr;
+				_head = (_head + 1) % std::size(_buffer);
+				--_size;
+				return out;
+			}
+
+		private:
+			void _grow()
+			{
+				auto buffer = std::vector<value_type>(std::max(std::size(_buffer) * 2, std::size_t{ 16 }));
+				for (auto i = std::size_t{}; i < _size; ++i)
+					buffer[i] = std::move(_buffer[(_head + i) % std::size(_buffer)]);
+				_buffer = std::move(buffer);
+				_head = {};
+				return;
+			}
+
+			std::vector<value_type> _buffer;
+			std::size_t _head = {};
+			std::size_t _size = {};
+		};
+
+		// runs a job from the thread pool
+		//	the job's allocations aren't counted by the scope that was active on this thread
+		inline void run_work(std::function<void()>& work)
+		{
+			const auto counter = allocation_counter_scope{ nullptr };
+			std::invoke(work);
+			return;
+		}
 	}
 
 	template<typename T>
@@ -107,14 +170,21 @@ namespace hades
 				const auto lock = std::scoped_lock{ other_queue.mut };
 
 				//bail if our target has nothing to steal
-				if (empty(other_queue.work))
+				if (other_queue.work.empty())
 					return;
 
-				work = std::move(other_queue.work.front());
-				other_queue.work.pop_front();
+				work = other_queue.work.pop_front();
 				std::atomic_fetch_sub_explicit(&_work_count, std::size_t{ 1 }, std::memory_order_relaxed);
 			}
-			std::invoke(work);
+			detail::run_work(work);
+			return;
+		}
+
+		// helps the pool until done is set
+		void help_until(const std::atomic_bool& done)
+		{
+			while (!std::atomic_load_explicit(&done, std::memory_order_acquire))
+				help();
 			return;
 		}
 
@@ -153,7 +223,7 @@ namespace hades
 			{
 				const auto index = get_worker_thread_id();
 				const auto lock = std::scoped_lock{ _queues[index].mut };
-				_queues[index].work.emplace_back(false_copyable{ std::move(work) });
+				_queues[index].work.push_back(false_copyable{ std::move(work) });
 				std::atomic_fetch_add_explicit(&_work_count, std::size_t{ 1 }, std::memory_order_relaxed);
 			}
 			
@@ -163,20 +233,29 @@ namespace hades
 			return future{ std::move(shared) };
 		}
 
+		// queues a function without creating a future
+		//	a small copyable function with no args (eg. a lambda capturing a pointer)
+		//	fits in std::function's local buffer, and is queued without allocating
 		template<typename Func, typename ...Args>
 		void detached_async(Func&& f, Args&& ...args) noexcept
 		{
 			static_assert(std::is_nothrow_invocable_v<Func, Args...>);
-			//wrap function args and call in a lambda
-			auto work = [func = std::decay_t<Func>{ std::forward<Func>(f) }, args = std::tuple<std::decay_t<Args>...>(std::move(args)...)]() mutable noexcept {
-				std::apply(func, std::move(args));
-				return;
-			};
+			auto work = std::function<void()>{};
+			if constexpr (sizeof...(Args) == 0 && std::is_copy_constructible_v<std::decay_t<Func>>)
+				work = std::forward<Func>(f);
+			else
+			{
+				//wrap function args and call in a lambda
+				work = false_copyable{ [func = std::decay_t<Func>{ std::forward<Func>(f) }, args = std::tuple<std::decay_t<Args>...>(std::move(args)...)]() mutable noexcept {
+					std::apply(func, std::move(args));
+					return;
+				} };
+			}
 
 			{
 				const auto index = get_worker_thread_id();
 				const auto lock = std::scoped_lock{ _queues[index].mut };
-				_queues[index].work.emplace_back(false_copyable{ std::move(work) });
+				_queues[index].work.push_back(std::move(work));
 				std::atomic_fetch_add_explicit(&_work_count, std::size_t{ 1 }, std::memory_order_relaxed);
 			}
 
@@ -207,7 +286,7 @@ namespace hades
 		struct thread_work_queue
 		{
 			std::mutex mut;
-			std::deque<std::function<void()>> work;
+			detail::work_queue work;
 		};
 
 		static std::size_t get_worker_thread_id() noexcept;
@@ -261,6 +340,17 @@ namespace hades
 		std::invoke(std::forward<Func>(f), std::move(args)...);
 		return;
 	}
+
+	// runs work from the shared thread pool until done is set
+	inline void help_until(const std::atomic_bool& done)
+	{
+		auto* pool = detail::get_shared_thread_pool();
+		if (pool)
+			pool->help_until(done);
+		else
+			assert(std::atomic_load_explicit(&done, std::memory_order_acquire));
+		return;
+	}
 }
 
 #endif //HADES_UTIL_ASYNC_HPP
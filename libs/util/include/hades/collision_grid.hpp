@@ -1,6 +1,7 @@
 #ifndef HADES_COLLISION_GRID_HPP
 #define HADES_COLLISION_GRID_HPP
 
+#include <limits>
 #include <vector>
 #include <unordered_map>
 
@@ -40,8 +41,15 @@ namespace hades
 			std::size_t next;
 		};
 
+		// the range of cells intersected by a rect, end_x and end_y are one past the last cell
+		struct cell_range
+		{
+			std::size_t x, y, end_x, end_y;
+		};
+
 		void _append(std::size_t cell, key_type k);
 		void _remove(std::size_t cell, key_type k);
+		cell_range _find_cells(rect_type rect) const;
 
 		// calls UnaryFunc on each cell_index that intersects rect
 		template<typename UnaryFunc>
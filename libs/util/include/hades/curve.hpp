@@ -2,10 +2,15 @@
 #define HADES_UTIL_CURVE_HPP
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <functional>
+#include <ranges>
 #include <vector>
 
+#include "hades/small_vector.hpp"
 #include "hades/time.hpp"
 #include "hades/utility.hpp"
 
@@ -18,6 +23,28 @@
 
 namespace hades::detail
 {
+	// number of keyframes stored inside each curve before it allocates
+	//	most curves only ever have one or two keyframes
+	template<typename Keyframe>
+	constexpr auto curve_inline_keyframes = std::size_t{ sizeof(Keyframe) <= 16 ? 2 : 1 };
+
+	// returns a value that hasn't been returned before, on any thread
+	//	used to mark changes to curves, see: basic_curve::version
+	inline std::uint64_t next_curve_version() noexcept
+	{
+		// threads take versions in blocks, so they rarely touch the shared counter
+		constexpr auto block_size = std::uint64_t{ 1024 };
+		static auto counter = std::atomic<std::uint64_t>{ 1 };
+		thread_local auto next = std::uint64_t{};
+		thread_local auto last = std::uint64_t{};
+		if (next == last)
+		{
+			next = counter.fetch_add(block_size, std::memory_order_relaxed);
+			last = next + block_size;
+		}
+		return next++;
+	}
+
 	template<typename Vector>
 	inline auto curve_get_near_impl(Vector& v,  time_point t) noexcept
 	{
@@ -35,6 +62,37 @@ namespace hades::detail
 		const auto pre = std::prev(iter);
 		return std::make_pair(pre, iter);
 	}
+
+	// same as above, but checks the keyframes at and after the cursor
+	// before falling back to a binary search
+	template<typename Vector, typename Cursor>
+	inline auto curve_get_near_impl(Vector& v, time_point t, Cursor& c) noexcept
+	{
+		const auto beg = std::begin(v);
+		const auto end = std::end(v);
+		const auto size = std::size(v);
+		assert(beg != end);
+
+		// the cursor points to the last keyframe before t
+		const auto is_before = [&](std::size_t i) noexcept {
+			return v[i].time < t && (i + 1 == size || !(v[i + 1].time < t));
+		};
+
+		for (auto i = c.index; i < size && i < c.index + 2; ++i)
+		{
+			if (is_before(i))
+			{
+				c.index = i;
+				const auto pre = std::next(beg, i);
+				return std::make_pair(pre, std::next(pre));
+			}
+		}
+
+		const auto ret = curve_get_near_impl(v, t);
+		c.index = ret.second == end ? size - 1 :
+			integer_cast<std::size_t>(std::distance(beg, ret.first));
+		return ret;
+	}
 }
 
 namespace hades
@@ -62,6 +120,15 @@ namespace hades
 		default_value = const_t
 	};
 
+	// a hint for curve lookups
+	//	keeps the position of the last lookup, so that lookups
+	//	at increasing times don't need to search the whole curve
+	//	cursors can be used with any curve, a bad hint falls back to a normal search
+	struct curve_cursor
+	{
+		std::size_t index = {};
+	};
+
 	// basic_curve
 	// implements shared behaviour for some of the curve types
 	template<typename T>
@@ -78,8 +145,28 @@ namespace hades
 			return std::empty(_data);
 		}
 
+		std::size_t size() const noexcept
+		{
+			return std::size(_data);
+		}
+
+		void shrink_to_fit()
+		{
+			_data.shrink_to_fit();
+			return;
+		}
+
+		// a value that changes whenever the keyframes are changed
+		//	curves with the same version have the same keyframes, this holds for copies of the curve
+		//	changes made through the reference returned by add_keyframe aren't tracked
+		std::uint64_t version() const noexcept
+		{
+			return _version;
+		}
+
 		T& add_keyframe(time_point t, T val)
 		{
+			_changed();
 			if (empty()) // curves should always at least have a starting value
 			{
 				return _data.emplace_back( keyframe{ t, std::move(val) }).value;
@@ -108,6 +195,7 @@ namespace hades
 		//removes all keyframes after time_point
 		void replace_keyframes(time_point t, T val)
 		{
+			_changed();
 			if (empty())
 			{
 				_data.push_back({ t, std::move(val) });
@@ -115,14 +203,102 @@ namespace hades
 			}
 
 			const auto end = std::end(_data);
-			const auto iter = std::lower_bound(begin(_data), end, t);
+			const auto iter = std::lower_bound(std::begin(_data), end, t);
 			if (iter != end)
 				_data.erase(iter, end);
 			_data.push_back({ t, std::move(val) });
 			return;
 		}
 
+		// removes keyframes that are no longer needed to get values at or after t
+		//	the last keyframe before t is kept, so the curve still has a value at t
+		void trim_history(time_point t)
+		{
+			const auto beg = std::begin(_data);
+			const auto iter = std::lower_bound(beg, std::end(_data), t);
+			if (iter == beg || std::prev(iter) == beg)
+				return;
+
+			_changed();
+			_data.erase(beg, std::prev(iter));
+			return;
+		}
+
+		// removes the oldest keyframes until no more than count remain
+		//	the last keyframe before t is always kept, along with any after it
+		void trim_keyframes(std::size_t count, time_point t)
+		{
+			const auto size = std::size(_data);
+			if (size <= count)
+				return;
+
+			const auto beg = std::begin(_data);
+			const auto iter = std::lower_bound(beg, std::end(_data), t);
+			const auto protected_frame = iter == beg ? beg : std::prev(iter);
+			const auto erase_count = std::min(size - count,
+				integer_cast<std::size_t>(std::distance(beg, protected_frame)));
+			if (erase_count == 0)
+				return;
+
+			_changed();
+			_data.erase(beg, std::next(beg, erase_count));
+			return;
+		}
+
 	protected:
+		// removes keyframes in [from, t) that are redundant
+		//	is_redundant(prev, current, next) is called with the last kept keyframe,
+		//	a keyframe that would be removed and the keyframe after it that would be kept.
+		//	every keyframe in a removed run is rechecked against the run's final
+		//	prev and next, so the error never grows past what is_redundant allows.
+		//	earlier calls may have checked keyframes against the first keyframe at or after from,
+		//	so it is kept along with everything before it. the first and last keyframes are always kept
+		template<typename Func>
+		void _collapse_keyframes(time_point from, time_point t, Func&& is_redundant)
+		{
+			const auto size = std::size(_data);
+			if (size < 3)
+				return;
+
+			const auto beg = std::begin(_data);
+			const auto anchor = integer_cast<std::size_t>(std::distance(beg, std::lower_bound(beg, std::end(_data), from)));
+			auto out = std::max(std::size_t{ 1 }, anchor + 1);
+			// the first keyframe removed since the last kept keyframe
+			//	removed keyframes aren't overwritten until the next one is kept
+			auto run = out;
+			for (auto i = out; i + 1 < size; ++i)
+			{
+				if (_data[i].time < t)
+				{
+					const auto& prev = _data[out - 1];
+					const auto& next = _data[i + 1];
+					if (std::all_of(std::next(beg, run), std::next(beg, i + 1), [&](const keyframe& k) {
+						return std::invoke(is_redundant, prev, k, next);
+						}))
+						continue;
+				}
+
+				if (out != i)
+					_data[out] = std::move(_data[i]);
+				++out;
+				run = i + 1;
+			}
+
+			if (out >= size - 1)
+				return;
+
+			_changed();
+			_data[out] = std::move(_data.back());
+			_data.erase(std::next(std::begin(_data), out + 1), std::end(_data));
+			return;
+		}
+
+		void _changed() noexcept
+		{
+			_version = detail::next_curve_version();
+			return;
+		}
+
 		struct keyframe
 		{
 			time_point time;
@@ -134,7 +310,16 @@ namespace hades
 			}
 		};
 
-		using data_t = std::vector<keyframe>;
+		using data_t = small_vector<keyframe, detail::curve_inline_keyframes<keyframe>>;
+
+	public:
+		// all of the keyframes, in time order
+		const data_t& keyframes() const noexcept
+		{
+			return _data;
+		}
+
+	protected:
 		using get_near_return = std::pair<typename data_t::iterator, typename data_t::iterator>;
 		get_near_return _get_near(time_point t) noexcept
 		{
@@ -147,12 +332,18 @@ namespace hades
 			return detail::curve_get_near_impl(_data, t);
 		}
 
+		get_near_return_const _get_near(time_point t, curve_cursor& c) const noexcept
+		{
+			return detail::curve_get_near_impl(_data, t, c);
+		}
+
 		typename data_t::const_iterator _end() const noexcept
 		{
-			return end(_data);
+			return std::end(_data);
 		}
 
-		std::vector<keyframe> _data;
+		data_t _data;
+		std::uint64_t _version = {};
 	};
 
 	template<linear_interpable T>
@@ -169,17 +360,70 @@ namespace hades
 			if (frames.second == basic::_end())
 				return frames.first->value;
 
-			const auto start_time = frames.first->time;
+			return _lerp(*frames.first, *frames.second, t);
+		}
+
+		// as above, but starts searching from the cursor
+		//	cheaper when called with increasing times
+		T get(time_point t, curve_cursor& c) const
+		{
+			using basic = basic_curve<T>;
+			const auto frames = basic::_get_near(t, c);
+			if (frames.second == basic::_end())
+				return frames.first->value;
+
+			return _lerp(*frames.first, *frames.second, t);
+		}
+
+		// the values and progress that get(t) would lerp between
+		//	used for batch sampling, see: curve_sample.hpp
+		struct lerp_args
+		{
+			const T& first;
+			const T& second;
+			float progress;
+		};
+
+		lerp_args get_lerp_args(time_point t) const noexcept
+		{
+			using basic = basic_curve<T>;
+			const auto frames = basic::_get_near(t);
+			if (frames.second == basic::_end())
+				return { frames.first->value, frames.first->value, 0.f };
+
+			return { frames.first->value, frames.second->value, _progress(*frames.first, *frames.second, t) };
+		}
+
+		// removes keyframes in [from, t) that lie on the line between the keyframes that are kept
+		//	equal(a, b) should return true if the values are close enough to be treated as the same
+		//	pass the previous t as from when collapsing repeatedly, see: basic_curve::_collapse_keyframes
+		template<typename Equal = std::equal_to<>>
+		void collapse_keyframes(time_point from, time_point t, Equal&& equal = {})
+		{
+			basic_curve<T>::_collapse_keyframes(from, t, [&equal](const auto& prev, const auto& current, const auto& next) {
+				return std::invoke(equal, _lerp(prev, next, current.time), current.value);
+			});
+			return;
+		}
+
+	private:
+		using keyframe = typename basic_curve<T>::keyframe;
+
+		static float _progress(const keyframe& first, const keyframe& second, time_point t) noexcept
+		{
+			const auto start_time = first.time;
 			assert(t >= start_time);
-			const auto end_time = frames.second->time - start_time;
+			const auto end_time = second.time - start_time;
 			const auto current_time = t - start_time;
 
-			const auto lerp_progress =
-				static_cast<float>(current_time.count()) /
+			return static_cast<float>(current_time.count()) /
 				static_cast<float>(end_time.count());
+		}
 
+		static T _lerp(const keyframe& first, const keyframe& second, time_point t)
+		{
 			using std::lerp;
-			return lerp(frames.first->value, frames.second->value, lerp_progress);
+			return lerp(first.value, second.value, _progress(first, second, t));
 		}
 	};
 
@@ -198,6 +442,27 @@ namespace hades
 				return n.first->value;
 			return n.second->value;
 		}
+
+		const T& get(time_point t, curve_cursor& c) const noexcept
+		{
+			using basic = basic_curve<T>;
+			assert(!basic_curve<T>::empty());
+			const auto n = basic::_get_near(t, c);
+			if (n.second == basic::_end())
+				return n.first->value;
+			return n.second->value;
+		}
+
+		// removes keyframes in [from, t) that have the same value as the keyframes either side of them
+		template<typename Equal = std::equal_to<>>
+		void collapse_keyframes(time_point from, time_point t, Equal&& equal = {})
+		{
+			basic_curve<T>::_collapse_keyframes(from, t, [&equal](const auto& prev, const auto& current, const auto& next) {
+				return std::invoke(equal, prev.value, current.value)
+					&& std::invoke(equal, current.value, next.value);
+			});
+			return;
+		}
 	};
 
 	template<typename T>
@@ -237,20 +502,62 @@ namespace hades
 			};
 		}
 
-		// TODO: implement
-		std::vector<pulse_keyframe> get_range(time_point min, time_point max) const
+		std::pair<pulse_keyframe, pulse_keyframe> get(time_point t, curve_cursor& c) const noexcept
 		{
-			if (min > max) return get_range(max, min);
+			auto iters = basic_curve<T>::_get_near(t, c);
+			return { { iters.first->value, iters.first->time },
+				(iters.second == basic_curve<T>::_end()) ? bad_keyframe :
+				pulse_keyframe{ iters.second->value, iters.second->time }
+			};
+		}
+
+		using keyframe = typename basic_curve<T>::keyframe;
+		// a view of the pulses in a time window
+		//	elements are keyframes, with time and value members
+		//	invalidated by any change to the curve
+		using pulse_range = std::ranges::subrange<typename basic_curve<T>::data_t::const_iterator>;
 
-			auto out = std::vector<pulse_keyframe>{};
-			//equal_range
-			//return out;
+		// returns the pulses in [min, max)
+		pulse_range get_range(time_point min, time_point max) const noexcept
+		{
+			if (min > max)
+				std::swap(min, max);
+
+			const auto& data = basic_curve<T>::_data;
+			const auto first = std::lower_bound(std::begin(data), std::end(data), min);
+			const auto last = std::lower_bound(first, std::end(data), max);
+			return { first, last };
+		}
+
+		// calls f(const keyframe&) for each pulse in [t - dt, t)
+		//	calling this every tick with the tick duration visits every pulse once
+		template<typename Func>
+		void for_each_pulse(time_point t, time_duration dt, Func&& f) const
+		{
+			for (const auto& k : get_range(t - dt, t))
+				std::invoke(f, k);
+			return;
 		}
 	};
 
 	template<typename T>
 	using pulse_keyframe = typename pulse_curve<T>::pulse_keyframe;
 
+	// calls f(elm, keyframe) for each pulse in [t - dt, t) on each curve
+	//	proj is called with each element of curves and must return a const pulse_curve&
+	//	pulses are visited in order for each curve, one curve at a time
+	template<std::ranges::input_range Range, typename Func, typename Proj = std::identity>
+	void for_each_pulse(Range&& curves, time_point t, time_duration dt, Func&& f, Proj proj = {})
+	{
+		for (auto&& elm : curves)
+		{
+			const auto& c = std::invoke(proj, elm);
+			for (const auto& k : c.get_range(t - dt, t))
+				std::invoke(f, elm, k);
+		}
+		return;
+	}
+
 	template<typename T>
 	class const_curve
 	{
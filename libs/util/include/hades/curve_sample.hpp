@@ -0,0 +1,36 @@
+#ifndef HADES_UTIL_CURVE_SAMPLE_HPP
+#define HADES_UTIL_CURVE_SAMPLE_HPP
+
+#include <functional>
+#include <span>
+
+#include "hades/curve.hpp"
+#include "hades/time.hpp"
+#include "hades/vector_math.hpp"
+
+// batch sampling for linear curves
+//	when many curves are read at the same time point(eg. entity positions for a frame)
+//	the keyframes are gathered first, then interpolated together using SIMD where available
+
+namespace hades
+{
+	// out[i] = lerp(a[i], b[i], t[i])
+	//	all spans must be the same size
+	//	uses SSE when available, results may differ from std::lerp by float rounding
+	void lerp_batch(std::span<const float> a, std::span<const float> b,
+		std::span<const float> t, std::span<float> out) noexcept;
+	void lerp_batch(std::span<const vector2_float> a, std::span<const vector2_float> b,
+		std::span<const float> t, std::span<vector2_float> out) noexcept;
+
+	// writes the value of each curve at time t into out
+	//	out must have room for a value for each curve
+	//	proj is called on each element of curves and must return a const linear_curve<T>&
+	//	eg. sample_curves(positions, t, out, [](auto* c) -> auto& { return *c; });
+	//	each curve must have at least one keyframe
+	template<typename T, std::ranges::input_range Range, typename Proj = std::identity>
+	void sample_curves(Range&& curves, time_point t, std::span<T> out, Proj proj = {});
+}
+
+#include "hades/detail/curve_sample.inl"
+
+#endif //!HADES_UTIL_CURVE_SAMPLE_HPP
@@ -40,6 +40,21 @@ namespace hades
 	template<typename Key, typename Rect>
 	void uniform_collision_grid<Key, Rect>::update(const key_type k, const rect_type rect)
 	{
+		// most updates are small movements that stay in the same cells
+		const auto r = _rects.find(k);
+		if (r != end(_rects))
+		{
+			const auto rect2 = normalise(rect);
+			const auto old_cells = _find_cells(r->second);
+			const auto new_cells = _find_cells(rect2);
+			if (old_cells.x == new_cells.x && old_cells.y == new_cells.y &&
+				old_cells.end_x == new_cells.end_x && old_cells.end_y == new_cells.end_y)
+			{
+				r->second = rect2;
+				return;
+			}
+		}
+
 		remove(k);
 		insert(k, rect);
 		return;
@@ -124,9 +139,7 @@ namespace hades
 	}
 
 	template<typename Key, typename Rect>
-	template<typename UnaryFunc>
-	void uniform_collision_grid<Key, Rect>::_for_each_found_cell(rect_type rect, UnaryFunc&& f) const
-		noexcept(std::is_nothrow_invocable_v<UnaryFunc, std::size_t>)
+	typename uniform_collision_grid<Key, Rect>::cell_range uniform_collision_grid<Key, Rect>::_find_cells(rect_type rect) const
 	{
 		// find the cells intersected by rect
 		// move the world to (0,0)
@@ -153,9 +166,22 @@ namespace hades
 			hades::integral_cast<std::size_t>(cell_rect.y + cell_rect.height, hades::round_down_tag),
 			columns);
 
-		for (auto y = std::max(std::size_t{}, hades::integral_cast<std::size_t>(cell_rect.y, hades::round_down_tag)); y < end_y; ++y)
+		return {
+			std::max(std::size_t{}, hades::integral_cast<std::size_t>(cell_rect.x, hades::round_down_tag)),
+			std::max(std::size_t{}, hades::integral_cast<std::size_t>(cell_rect.y, hades::round_down_tag)),
+			end_x, end_y
+		};
+	}
+
+	template<typename Key, typename Rect>
+	template<typename UnaryFunc>
+	void uniform_collision_grid<Key, Rect>::_for_each_found_cell(rect_type rect, UnaryFunc&& f) const
+		noexcept(std::is_nothrow_invocable_v<UnaryFunc, std::size_t>)
+	{
+		const auto cells = _find_cells(rect);
+		for (auto y = cells.y; y < cells.end_y; ++y)
 		{
-			for (auto x = std::max(std::size_t{}, hades::integral_cast<std::size_t>(cell_rect.x, hades::round_down_tag)); x < end_x; ++x)
+			for (auto x = cells.x; x < cells.end_x; ++x)
 			{
 				const auto cell_index = to_1d_index({ x, y }, _cells_per_row);
 				assert(cell_index < _cell_count);
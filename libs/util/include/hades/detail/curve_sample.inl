@@ -0,0 +1,72 @@
+#include "hades/curve_sample.hpp"
+
+#include <array>
+#include <cassert>
+#include <ranges>
+
+namespace hades
+{
+	namespace detail
+	{
+		template<typename T>
+		concept batch_lerpable = requires (std::span<const T> a, std::span<const float> t, std::span<T> out)
+		{
+			lerp_batch(a, a, t, out);
+		};
+
+		// number of curves gathered before each call to lerp_batch
+		constexpr auto sample_batch_size = std::size_t{ 64 };
+	}
+
+	template<typename T, std::ranges::input_range Range, typename Proj>
+	void sample_curves(Range&& curves, const time_point t, const std::span<T> out, Proj proj)
+	{
+		if constexpr (std::ranges::sized_range<Range>)
+			assert(std::ranges::size(curves) <= std::size(out));
+
+		if constexpr (detail::batch_lerpable<T>)
+		{
+			constexpr auto batch = detail::sample_batch_size;
+			auto first = std::array<T, batch>{};
+			auto second = std::array<T, batch>{};
+			auto progress = std::array<float, batch>{};
+
+			auto out_pos = std::size_t{};
+			auto count = std::size_t{};
+			const auto flush = [&]() noexcept {
+				lerp_batch(std::span<const T>{ first.data(), count },
+					std::span<const T>{ second.data(), count },
+					std::span<const float>{ progress.data(), count },
+					out.subspan(out_pos, count));
+				out_pos += count;
+				count = {};
+				return;
+			};
+
+			for (auto&& elm : curves)
+			{
+				const linear_curve<T>& c = std::invoke(proj, elm);
+				const auto args = c.get_lerp_args(t);
+				first[count] = args.first;
+				second[count] = args.second;
+				progress[count] = args.progress;
+				if (++count == batch)
+					flush();
+			}
+
+			if (count != 0)
+				flush();
+		}
+		else
+		{
+			auto i = std::size_t{};
+			for (auto&& elm : curves)
+			{
+				const linear_curve<T>& c = std::invoke(proj, elm);
+				out[i++] = c.get(t);
+			}
+		}
+
+		return;
+	}
+}
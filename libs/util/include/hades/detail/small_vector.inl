@@ -0,0 +1,306 @@
+#include "hades/small_vector.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <new>
+#include <utility>
+
+namespace hades
+{
+	template<typename T, std::size_t N>
+	inline small_vector<T, N>::small_vector() noexcept
+		: _data{ _inline_data() }
+	{}
+
+	template<typename T, std::size_t N>
+	inline small_vector<T, N>::small_vector(const small_vector& other)
+		: small_vector{}
+	{
+		reserve(other.size());
+		std::uninitialized_copy(other.begin(), other.end(), _data);
+		_size = other._size;
+	}
+
+	template<typename T, std::size_t N>
+	inline small_vector<T, N>::small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+		: small_vector{}
+	{
+		if (other.is_inline())
+		{
+			std::uninitialized_move(other.begin(), other.end(), _data);
+			_size = other._size;
+			other.clear();
+		}
+		else
+		{
+			// take the heap storage
+			_data = std::exchange(other._data, other._inline_data());
+			_size = std::exchange(other._size, std::uint32_t{});
+			_capacity = std::exchange(other._capacity, static_cast<std::uint32_t>(N));
+		}
+	}
+
+	template<typename T, std::size_t N>
+	inline small_vector<T, N>& small_vector<T, N>::operator=(const small_vector& other)
+	{
+		if (this == &other)
+			return *this;
+
+		clear();
+		reserve(other.size());
+		std::uninitialized_copy(other.begin(), other.end(), _data);
+		_size = other._size;
+		return *this;
+	}
+
+	template<typename T, std::size_t N>
+	inline small_vector<T, N>& small_vector<T, N>::operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+	{
+		if (this == &other)
+			return *this;
+
+		clear();
+		if (other.is_inline())
+		{
+			std::uninitialized_move(other.begin(), other.end(), _data);
+			_size = other._size;
+			other.clear();
+		}
+		else
+		{
+			_free();
+			_data = std::exchange(other._data, other._inline_data());
+			_size = std::exchange(other._size, std::uint32_t{});
+			_capacity = std::exchange(other._capacity, static_cast<std::uint32_t>(N));
+		}
+		return *this;
+	}
+
+	template<typename T, std::size_t N>
+	inline small_vector<T, N>::~small_vector() noexcept
+	{
+		clear();
+		_free();
+	}
+
+	template<typename T, std::size_t N>
+	inline typename small_vector<T, N>::reference small_vector<T, N>::operator[](size_type i) noexcept
+	{
+		assert(i < _size);
+		return _data[i];
+	}
+
+	template<typename T, std::size_t N>
+	inline typename small_vector<T, N>::const_reference small_vector<T, N>::operator[](size_type i) const noexcept
+	{
+		assert(i < _size);
+		return _data[i];
+	}
+
+	template<typename T, std::size_t N>
+	inline typename small_vector<T, N>::reference small_vector<T, N>::front() noexcept
+	{
+		assert(!empty());
+		return _data[0];
+	}
+
+	template<typename T, std::size_t N>
+	inline typename small_vector<T, N>::const_reference small_vector<T, N>::front() const noexcept
+	{
+		assert(!empty());
+		return _data[0];
+	}
+
+	template<typename T, std::size_t N>
+	inline typename small_vector<T, N>::reference small_vector<T, N>::back() noexcept
+	{
+		assert(!empty());
+		return _data[_size - 1];
+	}
+
+	template<typename T, std::size_t N>
+	inline typename small_vector<T, N>::const_reference small_vector<T, N>::back() const noexcept
+	{
+		assert(!empty());
+		return _data[_size - 1];
+	}
+
+	template<typename T, std::size_t N>
+	inline bool small_vector<T, N>::is_inline() const noexcept
+	{
+		return _data == reinterpret_cast<const T*>(_buffer);
+	}
+
+	template<typename T, std::size_t N>
+	inline void small_vector<T, N>::reserve(size_type s)
+	{
+		if (s <= _capacity)
+			return;
+
+		assert(s <= std::numeric_limits<std::uint32_t>::max());
+		auto alloc = std::allocator<T>{};
+		const auto storage = alloc.allocate(s);
+		try
+		{
+			_relocate(storage, s);
+		}
+		catch (...)
+		{
+			alloc.deallocate(storage, s);
+			throw;
+		}
+		return;
+	}
+
+	template<typename T, std::size_t N>
+	inline void small_vector<T, N>::shrink_to_fit()
+	{
+		if (is_inline() || _size == _capacity)
+			return;
+
+		if (_size <= N)
+		{
+			_relocate(_inline_data(), N);
+			return;
+		}
+
+		auto alloc = std::allocator<T>{};
+		const auto storage = alloc.allocate(_size);
+		try
+		{
+			_relocate(storage, _size);
+		}
+		catch (...)
+		{
+			alloc.deallocate(storage, _size);
+			throw;
+		}
+		return;
+	}
+
+	template<typename T, std::size_t N>
+	inline void small_vector<T, N>::clear() noexcept
+	{
+		std::destroy(begin(), end());
+		_size = {};
+		return;
+	}
+
+	template<typename T, std::size_t N>
+	template<typename... Args>
+	inline typename small_vector<T, N>::reference small_vector<T, N>::emplace_back(Args&&... args)
+	{
+		if (_size == _capacity)
+		{
+			// construct the new element first, args may refer to an existing element
+			auto value = T{ std::forward<Args>(args)... };
+			reserve(size_type{ _capacity } * 2);
+			const auto ptr = std::construct_at(_data + _size, std::move(value));
+			++_size;
+			return *ptr;
+		}
+
+		const auto ptr = std::construct_at(_data + _size, std::forward<Args>(args)...);
+		++_size;
+		return *ptr;
+	}
+
+	template<typename T, std::size_t N>
+	inline void small_vector<T, N>::push_back(const T& value)
+	{
+		emplace_back(value);
+		return;
+	}
+
+	template<typename T, std::size_t N>
+	inline void small_vector<T, N>::push_back(T&& value)
+	{
+		emplace_back(std::move(value));
+		return;
+	}
+
+	template<typename T, std::size_t N>
+	inline typename small_vector<T, N>::iterator small_vector<T, N>::insert(const_iterator pos, const T& value)
+	{
+		return insert(pos, T{ value });
+	}
+
+	template<typename T, std::size_t N>
+	inline typename small_vector<T, N>::iterator small_vector<T, N>::insert(const_iterator pos, T&& value)
+	{
+		assert(pos >= begin() && pos <= end());
+		const auto index = static_cast<size_type>(pos - cbegin());
+		if (index == _size)
+		{
+			emplace_back(std::move(value));
+			return _data + index;
+		}
+
+		if (_size == _capacity)
+			reserve(size_type{ _capacity } * 2);
+
+		// shift the tail up by one, then assign into the gap
+		std::construct_at(_data + _size, std::move(_data[_size - 1]));
+		++_size;
+		std::move_backward(_data + index, _data + _size - 2, _data + _size - 1);
+		_data[index] = std::move(value);
+		return _data + index;
+	}
+
+	template<typename T, std::size_t N>
+	inline typename small_vector<T, N>::iterator small_vector<T, N>::erase(const_iterator pos)
+	{
+		return erase(pos, std::next(pos));
+	}
+
+	template<typename T, std::size_t N>
+	inline typename small_vector<T, N>::iterator small_vector<T, N>::erase(const_iterator first, const_iterator last)
+	{
+		assert(first >= begin() && last <= end() && first <= last);
+		const auto f = _data + (first - cbegin());
+		const auto l = _data + (last - cbegin());
+		if (f == l)
+			return f;
+
+		const auto new_end = std::move(l, end(), f);
+		std::destroy(new_end, end());
+		_size = static_cast<std::uint32_t>(new_end - _data);
+		return f;
+	}
+
+	template<typename T, std::size_t N>
+	inline T* small_vector<T, N>::_inline_data() noexcept
+	{
+		return reinterpret_cast<T*>(_buffer);
+	}
+
+	template<typename T, std::size_t N>
+	inline void small_vector<T, N>::_relocate(T* storage, size_type capacity)
+	{
+		assert(capacity >= _size);
+		if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>)
+			std::uninitialized_move(begin(), end(), storage);
+		else
+			std::uninitialized_copy(begin(), end(), storage);
+
+		std::destroy(begin(), end());
+		_free();
+		_data = storage;
+		_capacity = static_cast<std::uint32_t>(capacity);
+		return;
+	}
+
+	template<typename T, std::size_t N>
+	inline void small_vector<T, N>::_free() noexcept
+	{
+		if (!is_inline())
+		{
+			auto alloc = std::allocator<T>{};
+			alloc.deallocate(_data, _capacity);
+			_data = _inline_data();
+			_capacity = static_cast<std::uint32_t>(N);
+		}
+		return;
+	}
+}
@@ -0,0 +1,45 @@
+#ifndef HADES_UTIL_FRAME_ARENA_HPP
+#define HADES_UTIL_FRAME_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+// memory for temporaries that only live for a single tick
+//	everything allocated from the arena is freed at once by reset()
+//	the arena keeps its buffer between resets, and grows it to fit the
+//	largest tick seen so far, once warmed up a tick doesn't touch the heap
+
+namespace hades
+{
+	// NOTE: not thread safe
+	class frame_arena
+	{
+	public:
+		static constexpr auto default_size = std::size_t{ 64 * 1024 };
+
+		explicit frame_arena(std::size_t size = default_size);
+		frame_arena(frame_arena&&) noexcept;
+		frame_arena& operator=(frame_arena&&) noexcept;
+		~frame_arena() noexcept;
+
+		std::pmr::memory_resource* resource() noexcept;
+
+		// frees everything allocated from the arena
+		//	if the last tick didn't fit in the buffer, then the buffer is grown
+		void reset();
+
+		// number of allocations since the last reset
+		std::size_t allocation_count() const noexcept;
+		// number of allocations since the last reset that didn't fit in the
+		//	buffer and went to the heap, this should be zero for a warmed up arena
+		std::size_t heap_allocation_count() const noexcept;
+		std::size_t capacity() const noexcept;
+
+	private:
+		struct arena_data;
+		std::unique_ptr<arena_data> _data;
+	};
+}
+
+#endif //!HADES_UTIL_FRAME_ARENA_HPP
@@ -0,0 +1,94 @@
+#ifndef HADES_UTIL_SMALL_VECTOR_HPP
+#define HADES_UTIL_SMALL_VECTOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+// a vector that stores the first N elements inside itself
+//	only allocates once more than N elements are stored
+//	supports the subset of std::vector used by the curve classes
+
+namespace hades
+{
+	template<typename T, std::size_t N>
+	class small_vector
+	{
+	public:
+		static_assert(N > 0, "small_vector needs room for at least one element, use std::vector instead");
+
+		using value_type = T;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+		using reference = T&;
+		using const_reference = const T&;
+		using pointer = T*;
+		using const_pointer = const T*;
+		using iterator = T*;
+		using const_iterator = const T*;
+
+		static constexpr auto inline_capacity = N;
+
+		small_vector() noexcept;
+		small_vector(const small_vector&);
+		small_vector(small_vector&&) noexcept(std::is_nothrow_move_constructible_v<T>);
+		small_vector& operator=(const small_vector&);
+		small_vector& operator=(small_vector&&) noexcept(std::is_nothrow_move_constructible_v<T>);
+		~small_vector() noexcept;
+
+		iterator begin() noexcept { return _data; }
+		iterator end() noexcept { return _data + _size; }
+		const_iterator begin() const noexcept { return _data; }
+		const_iterator end() const noexcept { return _data + _size; }
+		const_iterator cbegin() const noexcept { return _data; }
+		const_iterator cend() const noexcept { return _data + _size; }
+
+		pointer data() noexcept { return _data; }
+		const_pointer data() const noexcept { return _data; }
+
+		reference operator[](size_type i) noexcept;
+		const_reference operator[](size_type i) const noexcept;
+		reference front() noexcept;
+		const_reference front() const noexcept;
+		reference back() noexcept;
+		const_reference back() const noexcept;
+
+		bool empty() const noexcept { return _size == 0; }
+		size_type size() const noexcept { return _size; }
+		size_type capacity() const noexcept { return _capacity; }
+		// true if the elements are stored inside the small_vector
+		bool is_inline() const noexcept;
+
+		void reserve(size_type);
+		// moves the elements back inside the small_vector if they fit
+		void shrink_to_fit();
+		void clear() noexcept;
+
+		template<typename... Args>
+		reference emplace_back(Args&&...);
+		void push_back(const T&);
+		void push_back(T&&);
+
+		iterator insert(const_iterator, const T&);
+		iterator insert(const_iterator, T&&);
+
+		iterator erase(const_iterator);
+		iterator erase(const_iterator first, const_iterator last);
+
+	private:
+		T* _inline_data() noexcept;
+		// moves the elements into new storage, which must have room for at least size() elements
+		void _relocate(T* storage, size_type capacity);
+		void _free() noexcept;
+
+		T* _data;
+		std::uint32_t _size = {};
+		std::uint32_t _capacity = static_cast<std::uint32_t>(N);
+		alignas(T) std::byte _buffer[sizeof(T) * N];
+	};
+}
+
+#include "hades/detail/small_vector.inl"
+
+#endif //!HADES_UTIL_SMALL_VECTOR_HPP
@@ -0,0 +1,66 @@
+#include "hades/allocation_counter.hpp"
+
+#ifdef HADES_COUNT_ALLOCATIONS
+#include <cstdlib>
+#include <functional>
+#include <new>
+#endif
+
+namespace hades
+{
+	// referenced by allocation_counter_scope, so that any program that counts allocations
+	//	also links the operator new below, if it's enabled
+	thread_local static allocation_counter* current_counter = nullptr;
+
+	allocation_counter_scope::allocation_counter_scope(allocation_counter* c) noexcept
+		: _previous{ current_counter }
+	{
+		current_counter = c;
+		return;
+	}
+
+	allocation_counter_scope::~allocation_counter_scope() noexcept
+	{
+		current_counter = _previous;
+		return;
+	}
+
+	allocation_counter* current_allocation_counter() noexcept
+	{
+		return current_counter;
+	}
+}
+
+#ifdef HADES_COUNT_ALLOCATIONS
+// the array and nothrow versions call these by default
+void* operator new(const std::size_t size)
+{
+	if (hades::current_counter)
+		hades::current_counter->add();
+
+	const auto bytes = size == 0 ? std::size_t{ 1 } : size;
+	while (true)
+	{
+		const auto ptr = std::malloc(bytes);
+		if (ptr)
+			return ptr;
+
+		const auto handler = std::get_new_handler();
+		if (!handler)
+			throw std::bad_alloc{};
+		std::invoke(handler);
+	}
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+	return;
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+	return;
+}
+#endif
@@ -1,7 +1,6 @@
 #include "hades/async.hpp"
 
 #include <cassert>
-#include <iterator>
 
 namespace hades
 {
@@ -29,10 +28,9 @@ namespace hades
 				{
 					auto& queue = _queues[thread_id];
 					const auto lock = std::scoped_lock{ queue.mut };
-					if (!std::empty(queue.work))
+					if (!queue.work.empty())
 					{
-						work = std::move(queue.work.front());
-						queue.work.pop_front();
+						work = queue.work.pop_front();
 						std::atomic_fetch_sub_explicit(&_work_count, std::size_t{ 1 }, std::memory_order_release);
 					}
 				}
@@ -52,24 +50,21 @@ namespace hades
 					const auto lock = std::scoped_lock{ our_queue.mut, other_queue.mut };
 
 					//bail if our target has nothing to steal
-					const auto count = size(other_queue.work);
+					const auto count = other_queue.work.size();
 					if (count == std::size_t{})
 						continue;
 
 					//take half of the queue
 					const auto steal_count = (count + 1) / 2;
-					auto beg = begin(other_queue.work);
-					auto iter = next(beg, /*integer_cast*/static_cast<ptrdiff_t>(steal_count));
-					std::move(beg, iter, std::back_inserter(our_queue.work)); // TODO: possible throw?
-					other_queue.work.erase(beg, iter);
+					for (auto i = std::size_t{}; i < steal_count; ++i)
+						our_queue.work.push_back(other_queue.work.pop_front()); // TODO: possible throw?
 
-					work = std::move(our_queue.work.front());
-					our_queue.work.pop_front();
+					work = our_queue.work.pop_front();
 					std::atomic_fetch_sub_explicit(&_work_count, std::size_t{ 1 }, std::memory_order_release);
 				}
 
 				//if we have a task, then do it
-				std::invoke(std::move(work));
+				detail::run_work(work);
 			}
 
 			return;
@@ -0,0 +1,84 @@
+#include "hades/curve_sample.hpp"
+
+#include <cassert>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HADES_CURVE_SAMPLE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace hades
+{
+	static_assert(sizeof(vector2_float) == sizeof(float) * 2);
+
+	namespace
+	{
+		// the same calculation as the SIMD path, so that every element
+		// gets the same rounding regardless of where it falls in the batch
+		inline float lerp_scalar(float a, float b, float t) noexcept
+		{
+			return a + (b - a) * t;
+		}
+	}
+
+	void lerp_batch(std::span<const float> a, std::span<const float> b,
+		std::span<const float> t, std::span<float> out) noexcept
+	{
+		const auto size = std::size(a);
+		assert(std::size(b) == size && std::size(t) == size && std::size(out) >= size);
+		auto i = std::size_t{};
+
+#ifdef HADES_CURVE_SAMPLE_SSE
+		for (; i + 4 <= size; i += 4)
+		{
+			const auto va = _mm_loadu_ps(&a[i]);
+			const auto vb = _mm_loadu_ps(&b[i]);
+			const auto vt = _mm_loadu_ps(&t[i]);
+			_mm_storeu_ps(&out[i], _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), vt)));
+		}
+#endif
+
+		for (; i < size; ++i)
+			out[i] = lerp_scalar(a[i], b[i], t[i]);
+		return;
+	}
+
+	void lerp_batch(std::span<const vector2_float> a, std::span<const vector2_float> b,
+		std::span<const float> t, std::span<vector2_float> out) noexcept
+	{
+		const auto size = std::size(a);
+		assert(std::size(b) == size && std::size(t) == size && std::size(out) >= size);
+		auto i = std::size_t{};
+
+#ifdef HADES_CURVE_SAMPLE_SSE
+		// 4 vectors per loop, as two registers of [x0, y0, x1, y1]
+		const auto a_ptr = reinterpret_cast<const float*>(a.data());
+		const auto b_ptr = reinterpret_cast<const float*>(b.data());
+		const auto out_ptr = reinterpret_cast<float*>(out.data());
+		for (; i + 4 <= size; i += 4)
+		{
+			const auto vt = _mm_loadu_ps(&t[i]);
+			const auto t_lo = _mm_unpacklo_ps(vt, vt); // [t0, t0, t1, t1]
+			const auto t_hi = _mm_unpackhi_ps(vt, vt); // [t2, t2, t3, t3]
+
+			const auto a_lo = _mm_loadu_ps(a_ptr + i * 2);
+			const auto a_hi = _mm_loadu_ps(a_ptr + i * 2 + 4);
+			const auto b_lo = _mm_loadu_ps(b_ptr + i * 2);
+			const auto b_hi = _mm_loadu_ps(b_ptr + i * 2 + 4);
+
+			_mm_storeu_ps(out_ptr + i * 2, _mm_add_ps(a_lo, _mm_mul_ps(_mm_sub_ps(b_lo, a_lo), t_lo)));
+			_mm_storeu_ps(out_ptr + i * 2 + 4, _mm_add_ps(a_hi, _mm_mul_ps(_mm_sub_ps(b_hi, a_hi), t_hi)));
+		}
+#endif
+
+		for (; i < size; ++i)
+		{
+			out[i] = {
+				lerp_scalar(a[i].x, b[i].x, t[i]),
+				lerp_scalar(a[i].y, b[i].y, t[i])
+			};
+		}
+		return;
+	}
+}
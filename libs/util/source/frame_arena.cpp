@@ -0,0 +1,109 @@
+#include "hades/frame_arena.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace hades
+{
+	namespace
+	{
+		// passes allocations through to upstream, counting them
+		class counting_resource final : public std::pmr::memory_resource
+		{
+		public:
+			explicit counting_resource(std::pmr::memory_resource* upstream) noexcept
+				: _upstream{ upstream }
+			{}
+
+			std::size_t allocations = {};
+			std::size_t allocated_bytes = {};
+
+		private:
+			void* do_allocate(std::size_t bytes, std::size_t alignment) override
+			{
+				++allocations;
+				allocated_bytes += bytes;
+				return _upstream->allocate(bytes, alignment);
+			}
+
+			void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+			{
+				_upstream->deallocate(p, bytes, alignment);
+				return;
+			}
+
+			bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+			{
+				return this == &other;
+			}
+
+			std::pmr::memory_resource* _upstream;
+		};
+	}
+
+	struct frame_arena::arena_data
+	{
+		explicit arena_data(std::size_t s)
+			: buffer{ std::make_unique<std::byte[]>(s) }, size{ s },
+			heap{ std::pmr::new_delete_resource() },
+			arena{ buffer.get(), s, &heap }, counter{ &arena }
+		{}
+
+		std::unique_ptr<std::byte[]> buffer;
+		std::size_t size;
+		// counts allocations that overflow the buffer
+		counting_resource heap;
+		std::pmr::monotonic_buffer_resource arena;
+		// counts all allocations
+		counting_resource counter;
+	};
+
+	frame_arena::frame_arena(std::size_t size)
+		: _data{ std::make_unique<arena_data>(std::max(size, std::size_t{ 1 })) }
+	{}
+
+	frame_arena::frame_arena(frame_arena&&) noexcept = default;
+	frame_arena& frame_arena::operator=(frame_arena&&) noexcept = default;
+	frame_arena::~frame_arena() noexcept = default;
+
+	std::pmr::memory_resource* frame_arena::resource() noexcept
+	{
+		assert(_data);
+		return &_data->counter;
+	}
+
+	void frame_arena::reset()
+	{
+		assert(_data);
+		if (_data->heap.allocations != 0)
+		{
+			// the buffer was too small, make room for everything that was used
+			const auto new_size = std::max(_data->size * 2, _data->size + _data->heap.allocated_bytes);
+			_data = std::make_unique<arena_data>(new_size);
+			return;
+		}
+
+		_data->arena.release();
+		_data->counter.allocations = {};
+		_data->counter.allocated_bytes = {};
+		return;
+	}
+
+	std::size_t frame_arena::allocation_count() const noexcept
+	{
+		assert(_data);
+		return _data->counter.allocations;
+	}
+
+	std::size_t frame_arena::heap_allocation_count() const noexcept
+	{
+		assert(_data);
+		return _data->heap.allocations;
+	}
+
+	std::size_t frame_arena::capacity() const noexcept
+	{
+		assert(_data);
+		return _data->size;
+	}
+}
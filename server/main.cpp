@@ -0,0 +1,8 @@
+#include "hades/server_main.hpp"
+
+// runs a mission without a window, see server_main.hpp for the commands
+// eg. hades_server -game my_game -mission missions/test.mission -fast -ticks 1000
+int main(int argc, char** argv)
+{
+	return hades::hades_server_main(argc, argv, "game");
+}